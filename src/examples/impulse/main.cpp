@@ -31,17 +31,26 @@
 	@file	main.cpp
 	@brief	Impulse response calculator for S-parameters
 
-	Run "impulse file.s2p"
+	Run "impulse file.sNp"
 
-	Output is a CSV with time-domain transform of the S-parameters at 1ps resolution.
+	Output is a CSV with time-domain transform of every path in the S-parameters at 1ps resolution.
  */
 
 #include "../../../lib/scopehal/scopehal.h"
 #include <ffts.h>
+#include <omp.h>
 
 using namespace std;
 
 int64_t GetGroupDelay(SParameterVector& vec);
+void SampleSParameters(SParameterVector& vec, size_t nouts, double bin_hz, float* coeffRe, float* coeffIm);
+void ApplySParameters(
+	const float* dfreq,
+	const float* coeffRe,
+	const float* coeffIm,
+	float* dtfreq,
+	size_t nouts);
+void PrintRiseTimes(int to, int from, const float* samples, size_t len, size_t fs_per_sample);
 
 int main(int argc, char* argv[])
 {
@@ -77,11 +86,10 @@ int main(int argc, char* argv[])
 	//Initialize
 	AlignedAllocator< float, 64 > allocator;
 	size_t npoints = 131072;
+	size_t nouts = npoints/2 + 1;
 	size_t fs_per_sample = 1000;
 	double sample_ghz = 1000;
 	double bin_hz = round((0.5f * sample_ghz * 1e9f) / npoints);
-	ffts_plan_t* forwardPlan = ffts_init_1d_real(npoints, FFTS_FORWARD);
-	ffts_plan_t* reversePlan = ffts_init_1d_real(npoints, FFTS_BACKWARD);
 
 	//Load the S-parameters
 	SParameters params;
@@ -91,6 +99,8 @@ int main(int argc, char* argv[])
 		LogError("Couldn't open file\n");
 		return 1;
 	}
+	int nports = params.GetNumPorts();
+	int npaths = nports * nports;
 
 	//Generate the input waveform (TODO: impulse or step)
 	float* din = allocator.allocate(npoints);
@@ -103,51 +113,67 @@ int main(int argc, char* argv[])
 			din[i] = 1;
 	}
 
-	//Do the forward FFT
-	float* dfreq = allocator.allocate(npoints*2);
+	//Do the forward FFT. The stimulus is the same for every path so we only need to do this once.
+	float* dfreq = allocator.allocate(nouts*2);
+	ffts_plan_t* forwardPlan = ffts_init_1d_real(npoints, FFTS_FORWARD);
 	ffts_execute(forwardPlan, din, dfreq);
+	ffts_free(forwardPlan);
 
-	//Apply the S-parameter transformation to each channel
-	float* dtfreq[2][2];
-	for(int to=0; to<2; to++)
-		for(int from=0; from<2; from++)
-			dtfreq[to][from] = allocator.allocate(npoints*2);
-	for(size_t i=0; i<npoints; i++)
+	//FFTS plans have internal scratch space so can't be shared between threads.
+	//Make one inverse plan per thread and reuse it for all of the paths that thread processes.
+	int nthreads = omp_get_max_threads();
+	vector<ffts_plan_t*> reversePlans;
+	vector<float*> coeffRe;
+	vector<float*> coeffIm;
+	vector<float*> dtfreq;
+	for(int i=0; i<nthreads; i++)
 	{
-		for(int to=0; to<2; to++)
-		{
-			for(int from=0; from<2; from++)
-			{
-				auto point = params.SamplePoint(to+1, from+1, bin_hz * i);
-				float sinval = sin(point.m_phase);
-				float cosval = cos(point.m_phase);
-
-				float real = dfreq[i*2 + 0];
-				float imag = dfreq[i*2 + 1];
-
-				dtfreq[to][from][i*2 + 0] = (real*cosval - imag*sinval) * point.m_amplitude;
-				dtfreq[to][from][i*2 + 1] = (real*sinval + imag*cosval) * point.m_amplitude;
-			}
-		}
+		reversePlans.push_back(ffts_init_1d_real(npoints, FFTS_BACKWARD));
+		coeffRe.push_back(allocator.allocate(nouts));
+		coeffIm.push_back(allocator.allocate(nouts));
+		dtfreq.push_back(allocator.allocate(nouts*2));
 	}
 
-	//Do the reverse FFTs
-	float* dttime[2][2];
-	for(int to=0; to<2; to++)
+	//Apply the S-parameter transformation to each path and convert back to the time domain.
+	//Path index is (from-1)*nports + (to-1), so for a 2-port the order is S11, S21, S12, S22.
+	vector<float*> dttime(npaths);
+	for(int i=0; i<npaths; i++)
+		dttime[i] = allocator.allocate(npoints);
+	float scale = 1.0f / npoints;
+	#pragma omp parallel for schedule(dynamic)
+	for(int path=0; path<npaths; path++)
 	{
-		for(int from=0; from<2; from++)
+		int tid = omp_get_thread_num();
+		int from = path / nports + 1;
+		int to = path % nports + 1;
+
+		SampleSParameters(params[SPair(to, from)], nouts, bin_hz, coeffRe[tid], coeffIm[tid]);
+		ApplySParameters(dfreq, coeffRe[tid], coeffIm[tid], dtfreq[tid], nouts);
+		ffts_execute(reversePlans[tid], dtfreq[tid], dttime[path]);
+
+		//Rescale
+		float* out = dttime[path];
+		for(size_t i=0; i<npoints; i++)
+			out[i] *= scale;
+	}
+
+	//Calculate maximum group delay for the first few bins of each transmission path
+	//(approx propagation delay of the channel) and start the output at the fastest one.
+	int64_t groupdelay_samples = 0;
+	bool first = true;
+	for(int from=1; from<=nports; from++)
+	{
+		for(int to=1; to<=nports; to++)
 		{
-			dttime[to][from] = allocator.allocate(npoints);
-			ffts_execute(reversePlan, dtfreq[to][from], dttime[to][from]);
+			if(to == from)
+				continue;
 
-			//Rescale
-			for(size_t i=0; i<npoints; i++)
-				dttime[to][from][i] /= npoints;
+			int64_t delay = ceil( GetGroupDelay(params[SPair(to, from)]) / fs_per_sample );
+			if(first || (delay < groupdelay_samples))
+				groupdelay_samples = delay;
+			first = false;
 		}
 	}
-
-	//Calculate maximum group delay for the first few S21 bins (approx propagation delay of the channel)
-	int64_t groupdelay_samples = ceil( GetGroupDelay(params[SPair(2,1)]) / fs_per_sample );
 	if( (groupdelay_samples < 0) || (groupdelay_samples >= (int64_t)npoints) )
 	{
 		LogWarning("Calculated invalid group delay = %ld\n", groupdelay_samples);
@@ -155,27 +181,109 @@ int main(int argc, char* argv[])
 	}
 
 	//Write the output
-	LogNotice("fs, s11, s21, s12, s22\n");
+	string header = "fs";
+	for(int from=1; from<=nports; from++)
+	{
+		for(int to=1; to<=nports; to++)
+			header += ", s" + to_string(to) + to_string(from);
+	}
+	LogNotice("%s\n", header.c_str());
 	float tstart = nmid;
+	string line;
+	char tmp[32];
 	for(size_t i=groupdelay_samples; i<npoints; i++)
 	{
-		LogNotice("%.0f, %f, %f, %f, %f\n",
-			(i*fs_per_sample) - tstart,
-			dttime[0][0][i],
-			dttime[1][0][i],
-			dttime[0][1][i],
-			dttime[1][1][i]
-			);
+		snprintf(tmp, sizeof(tmp), "%.0f", (i*fs_per_sample) - tstart);
+		line = tmp;
+		for(int path=0; path<npaths; path++)
+		{
+			snprintf(tmp, sizeof(tmp), ", %f", dttime[path][i]);
+			line += tmp;
+		}
+		LogNotice("%s\n", line.c_str());
 	}
 
-	//Calculate the 10-90 and 20-80% thresholds for the S21 curve
-	SparseAnalogWaveform wfm;
-	for(size_t i=groupdelay_samples; i<npoints; i++)
+	//Calculate rise times for each transmission path
+	for(int from=1; from<=nports; from++)
+	{
+		for(int to=1; to<=nports; to++)
+		{
+			if(to == from)
+				continue;
+			int path = (from-1)*nports + (to-1);
+			PrintRiseTimes(
+				to,
+				from,
+				dttime[path] + groupdelay_samples,
+				npoints - groupdelay_samples,
+				fs_per_sample);
+		}
+	}
+
+	//Clean up
+	allocator.deallocate(din);
+	allocator.deallocate(dfreq);
+	for(int i=0; i<nthreads; i++)
 	{
-		wfm.m_offsets.push_back(i);
-		wfm.m_durations.push_back(fs_per_sample);
-		wfm.m_samples.push_back(dttime[1][0][i]);
+		ffts_free(reversePlans[i]);
+		allocator.deallocate(coeffRe[i]);
+		allocator.deallocate(coeffIm[i]);
+		allocator.deallocate(dtfreq[i]);
 	}
+	for(auto p : dttime)
+		allocator.deallocate(p);
+}
+
+/**
+	@brief Samples one S-parameter at each FFT bin and converts it to rectangular form
+ */
+void SampleSParameters(SParameterVector& vec, size_t nouts, double bin_hz, float* coeffRe, float* coeffIm)
+{
+	for(size_t i=0; i<nouts; i++)
+	{
+		auto point = vec.SamplePoint(bin_hz * i);
+		coeffRe[i] = cos(point.m_phase) * point.m_amplitude;
+		coeffIm[i] = sin(point.m_phase) * point.m_amplitude;
+	}
+}
+
+/**
+	@brief Multiplies the stimulus spectrum by one S-parameter
+
+	Coefficients are stored as separate real and imaginary arrays with no dependencies between iterations,
+	so the compiler can vectorize the loop.
+ */
+void ApplySParameters(
+	const float* __restrict__ dfreq,
+	const float* __restrict__ coeffRe,
+	const float* __restrict__ coeffIm,
+	float* __restrict__ dtfreq,
+	size_t nouts)
+{
+	#pragma omp simd
+	for(size_t i=0; i<nouts; i++)
+	{
+		float real = dfreq[i*2 + 0];
+		float imag = dfreq[i*2 + 1];
+
+		dtfreq[i*2 + 0] = real*coeffRe[i] - imag*coeffIm[i];
+		dtfreq[i*2 + 1] = real*coeffIm[i] + imag*coeffRe[i];
+	}
+}
+
+/**
+	@brief Calculates the 10-90 and 20-80% rise times of a step response
+ */
+void PrintRiseTimes(int to, int from, const float* samples, size_t len, size_t fs_per_sample)
+{
+	//Calculate the thresholds
+	UniformAnalogWaveform wfm;
+	wfm.m_timescale = fs_per_sample;
+	wfm.m_triggerPhase = 0;
+	wfm.Resize(len);
+	memcpy(wfm.m_samples.GetCpuPointer(), samples, len * sizeof(float));
+	wfm.MarkModifiedFromCpu();
+
 	float base = Filter::GetBaseVoltage(&wfm);
 	float top = Filter::GetTopVoltage(&wfm);
 	float delta = top - base;
@@ -184,6 +292,8 @@ int main(int argc, char* argv[])
 	float v80 = base + 0.8*delta;
 	float v90 = base + 0.9*delta;
 	Unit volts(Unit::UNIT_VOLTS);
+	LogWarning("S%d%d:\n", to, from);
+	LogIndenter li;
 	LogWarning("Base: %s\n", volts.PrettyPrint(base).c_str());
 	LogWarning("Top: %s\n", volts.PrettyPrint(top).c_str());
 	LogWarning("10-90 thresholds: %s, %s\n", volts.PrettyPrint(v10).c_str(), volts.PrettyPrint(v90).c_str());
@@ -194,9 +304,9 @@ int main(int argc, char* argv[])
 	size_t t20 = 0;
 	size_t t80 = 0;
 	size_t t90 = 0;
-	for(size_t i=groupdelay_samples; i<npoints; i++)
+	for(size_t i=0; i<len; i++)
 	{
-		float v = dttime[1][0][i];
+		float v = samples[i];
 		if((t10 == 0) && v > v10)
 			t10 = i;
 		if((t20 == 0) && v > v20)
@@ -211,20 +321,6 @@ int main(int argc, char* argv[])
 	Unit fs(Unit::UNIT_FS);
 	LogWarning("20-80%%: %s\n", fs.PrettyPrint( (t80-t20) * fs_per_sample).c_str());
 	LogWarning("10-90%%: %s\n", fs.PrettyPrint( (t90-t10) * fs_per_sample).c_str());
-
-	//Clean up
-	ffts_free(forwardPlan);
-	ffts_free(reversePlan);
-	allocator.deallocate(din);
-	allocator.deallocate(dfreq);
-	for(int to=0; to<2; to++)
-	{
-		for(int from=0; from<2; from++)
-		{
-			allocator.deallocate(dtfreq[to][from]);
-			allocator.deallocate(dttime[to][from]);
-		}
-	}
 }
 
 int64_t GetGroupDelay(SParameterVector& vec)
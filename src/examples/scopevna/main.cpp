@@ -35,9 +35,39 @@
 #include "../../../lib/scopehal/scopehal.h"
 #include "../../../lib/scopeprotocols/scopeprotocols.h"
 #include "../../../lib/scopehal/SiglentVectorSignalGenerator.h"
+#include "../../../lib/scopehal/MockOscilloscope.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 using namespace std;
 
+/**
+	@brief One acquisition at one sweep point, on its way from the instrument (or a replay file) to the DSP thread
+ */
+class SweepCapture
+{
+public:
+	SweepCapture(float freq = 0, int iteration = 0, WaveformBase* ref = nullptr, WaveformBase* dut = nullptr)
+		: m_freq(freq)
+		, m_iteration(iteration)
+		, m_ref(ref)
+		, m_dut(dut)
+	{}
+
+	float m_freq;
+	int m_iteration;
+	WaveformBase* m_ref;
+	WaveformBase* m_dut;
+};
+
+//Number of waveforms averaged (well, median'd) at each sweep point
+#define ITERATIONS_PER_POINT 3
+
+//Maximum number of captures waiting for the DSP thread before acquisition stalls, so we don't use unbounded RAM
+#define MAX_QUEUED_CAPTURES 8
+
 FILE* g_fpOut = NULL;
 
 Filter* g_refMixerFilter = NULL;
@@ -58,23 +88,32 @@ Filter* g_phaseDiffFilter = NULL;
 OscilloscopeChannel* g_dutChannel = NULL;
 OscilloscopeChannel* g_refChannel = NULL;
 
-void BuildFilterGraph(Oscilloscope* scope);
-void OnWaveform(float freq, int iteration);
+//Captures waiting for the DSP thread. A null m_ref marks the end of the sweep.
+deque<SweepCapture> g_captureQueue;
+mutex g_captureMutex;
+condition_variable g_captureReady;
+condition_variable g_captureDone;
 
-float last_phase = 0;
+//Calibration data
+bool g_hasCal = false;
+SParameters g_calParams;
 
-float g_phases[3];
-float g_mags[3];
+//If not empty, save every capture here for later replay
+string g_saveDir;
 
-int CompareFloat(const void* a, const void* b);
-
-int CompareFloat(const void* a, const void* b)
-{
-	float* pa = (float*)a;
-	float* pb = (float*)b;
-
-	return *pa < *pb;
-}
+void BuildFilterGraph(Oscilloscope* scope);
+void OnWaveform(float freq, int iteration);
+void DSPThread();
+void PushCapture(const SweepCapture& cap);
+void WritePoint(float freq);
+bool RunLiveSweep(const string& scopepath);
+size_t ReplaySweep(const string& dir);
+void SaveCapture(const SweepCapture& cap);
+SweepCapture LoadCapture(const string& fname);
+void WaitForTrigger(Oscilloscope* scope);
+
+float g_phases[ITERATIONS_PER_POINT];
+float g_mags[ITERATIONS_PER_POINT];
 
 int main(int argc, char* argv[])
 {
@@ -82,6 +121,8 @@ int main(int argc, char* argv[])
 
 	//Parse command-line arguments
 	string scopepath;
+	string replayDir;
+	string outfile = "/tmp/test.s2p";
 	for(int i=1; i<argc; i++)
 	{
 		string s(argv[i]);
@@ -92,9 +133,17 @@ int main(int argc, char* argv[])
 
 		if(s == "--help")
 		{
-			//not implemented
+			fprintf(stderr,
+				"scopevna [logger options] [--out file.s2p] [--save dir] scope\n"
+				"scopevna [logger options] [--out file.s2p] --replay dir\n");
 			return 0;
 		}
+		else if( (s == "--replay") && (i+1 < argc) )
+			replayDir = argv[++i];
+		else if( (s == "--save") && (i+1 < argc) )
+			g_saveDir = argv[++i];
+		else if( (s == "--out") && (i+1 < argc) )
+			outfile = argv[++i];
 		else if(s[0] == '-')
 		{
 			fprintf(stderr, "Unrecognized command-line argument \"%s\", use --help\n", s.c_str());
@@ -115,6 +164,72 @@ int main(int argc, char* argv[])
 	DriverStaticInit();
 	ScopeProtocolStaticInit();
 
+	//Open the output S-parameter file
+	g_fpOut = fopen(outfile.c_str(), "w");
+	if(!g_fpOut)
+	{
+		LogError("Couldn't create %s\n", outfile.c_str());
+		return 1;
+	}
+	fprintf(g_fpOut, "# HZ S MA R 50.0\n");
+
+	//The DSP runs against a mock scope, so the real one is free to acquire the next waveform in the meantime
+	auto dspScope = new MockOscilloscope("VNA DSP", "Generic", "12345");
+	dspScope->m_nickname = "dsp";
+	for(size_t i=0; i<2; i++)
+	{
+		dspScope->AddChannel(new OscilloscopeChannel(
+			dspScope,
+			(i == 0) ? "ref" : "dut",
+			"#ffffff",
+			Unit(Unit::UNIT_FS),
+			Unit(Unit::UNIT_VOLTS),
+			Stream::STREAM_TYPE_ANALOG,
+			i));
+	}
+
+	//Create the filter graph where all our fun happens
+	BuildFilterGraph(dspScope);
+
+	//Load the calibration file, if it exists
+	TouchstoneParser parser;
+	g_hasCal = parser.Load("/tmp/scopevna-cal.s2p", g_calParams);
+
+	//Crunch waveforms in the background while we acquire or load more
+	thread dsp(DSPThread);
+
+	auto start = chrono::steady_clock::now();
+	bool ok = true;
+	size_t nreplayed = 0;
+	if(!replayDir.empty())
+		nreplayed = ReplaySweep(replayDir);
+	else
+		ok = RunLiveSweep(scopepath);
+
+	//Done, wait for the DSP to catch up and clean up
+	PushCapture(SweepCapture());
+	dsp.join();
+	if(!replayDir.empty())
+	{
+		double dt = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		LogNotice("Replayed %zu captures in %.2f s\n", nreplayed, dt);
+	}
+
+	fclose(g_fpOut);
+	delete dspScope;
+	return ok ? 0 : 1;
+}
+
+/**
+	@brief Steps the generator across the band, acquiring waveforms at each point
+
+	As soon as the last waveform at a point is captured we move on and retune for the next one, while the DSP thread
+	processes the previous point.
+
+	@return False if we couldn't connect to the instruments
+ */
+bool RunLiveSweep(const string& scopepath)
+{
 	//Parse arguments
 	char nick[128];
 	char driver[128];
@@ -126,29 +241,31 @@ int main(int argc, char* argv[])
 		if(3 != sscanf(scopepath.c_str(), "%127[^:]:%127[^:]:%127[^:]", nick, driver, trans))
 		{
 			LogError("Invalid scope string %s\n", scopepath.c_str());
-			return 1;
+			return false;
 		}
 	}
 
 	//Connect to scope
 	SCPITransport* transport = SCPITransport::CreateTransport(trans, args);
 	if(transport == NULL)
-		return 1;
+		return false;
 	if(!transport->IsConnected())
 	{
 		LogError("Failed to connect to instrument using connection string %s\n", scopepath.c_str());
-		return 1;
+		return false;
 	}
 
 	Oscilloscope* scope = Oscilloscope::CreateOscilloscope(driver, transport);
 	if(scope == NULL)
-		return 1;
+		return false;
 	scope->m_nickname = nick;
 
 	//Initial scope configuration: not interleaved
 	//Probe on 3, ref on 4
 	scope->EnableChannel(3);
 	scope->EnableChannel(4);
+	auto refChannel = scope->GetChannel(3);
+	auto dutChannel = scope->GetChannel(2);
 
 	//Connect to signal generator, configure for 0 dBm
 	//TODO: dynamic creation etc
@@ -157,19 +274,7 @@ int main(int argc, char* argv[])
 	gen->SetChannelOutputPower(0, 0);
 	gen->SetChannelOutputEnable(0, true);
 
-	//Open the output S-parameter file
-	g_fpOut = fopen("/tmp/test.s2p", "w");
-	fprintf(g_fpOut, "# HZ S MA R 50.0\n");
-
-	//Create the filter graph where all our fun happens
-	BuildFilterGraph(scope);
-
-	//Load the calibration file, if it exists
-	TouchstoneParser parser;
-	SParameters params;
-	bool has_cal = parser.Load("/tmp/scopevna-cal.s2p", params);
-
-	//Main processing loop
+	//Main acquisition loop
 	//for(float freq = 0; freq < 6e9; freq += 1e7)
 	for(float freq = 0; freq < 6e8; freq += 1e6)
 	{
@@ -193,58 +298,242 @@ int main(int argc, char* argv[])
 		std::this_thread::sleep_for(std::chrono::milliseconds(20));
 
 		//Grab a couple of waveforms
-		for(int i=0; i<3; i++)
+		for(int i=0; i<ITERATIONS_PER_POINT; i++)
 		{
 			//Grab a waveform
 			scope->StartSingleTrigger();
-			while(scope->PollTrigger() != Oscilloscope::TRIGGER_MODE_TRIGGERED)
-				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			WaitForTrigger(scope);
 			scope->AcquireData();
 			scope->PopPendingWaveform();
 
-			//Crunch it
-			OnWaveform(realfreq, i);
+			//Hand the waveforms off to the DSP thread, the scope will allocate new ones next time
+			PushCapture(SweepCapture(realfreq, i, refChannel->Detach(0), dutChannel->Detach(0)));
 		}
+	}
 
-		//Caculate median value
-		qsort(g_phases, 3, sizeof(float), CompareFloat);
-		qsort(g_mags, 3, sizeof(float), CompareFloat);
-		float mag = g_mags[1];
-		float ang = g_phases[1];
+	gen->SetChannelOutputEnable(0, false);
+	delete gen;
+	delete scope;
+	return true;
+}
 
-		//Apply calibration
-		if(has_cal)
-		{
-			//LogDebug("base mag/ang = %f, %f\n", mag, ang);
+/**
+	@brief Polls the scope until it triggers
 
-			auto& cal_s21 = params[SPair(2, 1)];
-			auto cal_mag = cal_s21.InterpolateMagnitude(realfreq);
-			auto cal_ang = cal_s21.InterpolateAngle(realfreq) * 180 / M_PI;
-			//LogDebug("cal mag/ang = %f, %f\n", cal_mag, cal_ang);
+	Drivers only expose polling, so poll quickly at first (most captures complete within a few ms) and back off to
+	avoid hammering the instrument if it's slow to trigger.
+ */
+void WaitForTrigger(Oscilloscope* scope)
+{
+	int delay = 1;
+	while(scope->PollTrigger() != Oscilloscope::TRIGGER_MODE_TRIGGERED)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+		delay = min(delay*2, 20);
+	}
+}
 
-			mag /= cal_mag;
-			ang -= cal_ang;
+/**
+	@brief Queues a capture for the DSP thread, blocking if it's too far behind
+ */
+void PushCapture(const SweepCapture& cap)
+{
+	unique_lock<mutex> lock(g_captureMutex);
+	g_captureDone.wait(lock, []{ return g_captureQueue.size() < MAX_QUEUED_CAPTURES; });
+	g_captureQueue.push_back(cap);
+	g_captureReady.notify_one();
+}
 
-			if(ang <= -180)
-				ang += 360;
-			if(ang >= 180)
-				ang -= 360;
+/**
+	@brief Processes captures in order, writing each sweep point to the output file as soon as it's complete
+ */
+void DSPThread()
+{
+	while(true)
+	{
+		SweepCapture cap;
+		{
+			unique_lock<mutex> lock(g_captureMutex);
+			g_captureReady.wait(lock, []{ return !g_captureQueue.empty(); });
+			cap = g_captureQueue.front();
+			g_captureQueue.pop_front();
+			g_captureDone.notify_one();
 		}
 
-		//Write to touchstone file
-		fprintf(g_fpOut, "%.0f 0 0 %f %f 0 0 0 0\n", realfreq, mag, ang);
-		fflush(g_fpOut);
+		//End of sweep
+		if(!cap.m_ref)
+			break;
+
+		if(!g_saveDir.empty())
+			SaveCapture(cap);
+
+		g_refChannel->SetData(cap.m_ref, 0);
+		g_dutChannel->SetData(cap.m_dut, 0);
+		OnWaveform(cap.m_freq, cap.m_iteration);
+
+		if(cap.m_iteration == (ITERATIONS_PER_POINT-1) )
+			WritePoint(cap.m_freq);
+	}
+}
+
+/**
+	@brief Calculates the median of the waveforms at one sweep point, calibrates it, and writes it out
+ */
+void WritePoint(float realfreq)
+{
+	//Caculate median value
+	sort(g_phases, g_phases + ITERATIONS_PER_POINT);
+	sort(g_mags, g_mags + ITERATIONS_PER_POINT);
+	float mag = g_mags[ITERATIONS_PER_POINT / 2];
+	float ang = g_phases[ITERATIONS_PER_POINT / 2];
+
+	//Apply calibration
+	if(g_hasCal)
+	{
+		//LogDebug("base mag/ang = %f, %f\n", mag, ang);
+
+		auto& cal_s21 = g_calParams[SPair(2, 1)];
+		auto cal_mag = cal_s21.InterpolateMagnitude(realfreq);
+		auto cal_ang = cal_s21.InterpolateAngle(realfreq) * 180 / M_PI;
+		//LogDebug("cal mag/ang = %f, %f\n", cal_mag, cal_ang);
+
+		mag /= cal_mag;
+		ang -= cal_ang;
+
+		if(ang <= -180)
+			ang += 360;
+		if(ang >= 180)
+			ang -= 360;
 	}
 
-	//Done, clean up
-	gen->SetChannelOutputEnable(0, false);
-	fclose(g_fpOut);
+	//Write to touchstone file
+	fprintf(g_fpOut, "%.0f 0 0 %f %f 0 0 0 0\n", realfreq, mag, ang);
+	fflush(g_fpOut);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Capture save / replay
+
+/*
+	Capture file format, one file per capture, native endianness:
+		float		frequency
+		int32_t		iteration
+		int64_t		timescale (fs per sample)
+		uint64_t	sample count
+		float[]		reference samples
+		float[]		DUT samples
+ */
+
+/**
+	@brief Saves a capture so the sweep can be replayed offline later
+ */
+void SaveCapture(const SweepCapture& cap)
+{
+	static size_t index = 0;
+
+	auto ref = dynamic_cast<UniformAnalogWaveform*>(cap.m_ref);
+	auto dut = dynamic_cast<UniformAnalogWaveform*>(cap.m_dut);
+	if(!ref || !dut)
+		return;
+
+	char fname[512];
+	snprintf(fname, sizeof(fname), "%s/capture_%06zu.bin", g_saveDir.c_str(), index++);
+	FILE* fp = fopen(fname, "wb");
+	if(!fp)
+	{
+		LogError("Couldn't create %s\n", fname);
+		return;
+	}
+
+	ref->PrepareForCpuAccess();
+	dut->PrepareForCpuAccess();
+
+	int32_t iteration = cap.m_iteration;
+	int64_t timescale = ref->m_timescale;
+	uint64_t len = min(ref->size(), dut->size());
+	fwrite(&cap.m_freq, sizeof(cap.m_freq), 1, fp);
+	fwrite(&iteration, sizeof(iteration), 1, fp);
+	fwrite(&timescale, sizeof(timescale), 1, fp);
+	fwrite(&len, sizeof(len), 1, fp);
+	fwrite(ref->m_samples.GetCpuPointer(), sizeof(float), len, fp);
+	fwrite(dut->m_samples.GetCpuPointer(), sizeof(float), len, fp);
+	fclose(fp);
+}
+
+/**
+	@brief Loads a capture saved by SaveCapture()
+
+	@return The capture, with null waveforms on failure
+ */
+SweepCapture LoadCapture(const string& fname)
+{
+	SweepCapture cap;
+
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if(!fp)
+		return cap;
+
+	int32_t iteration;
+	int64_t timescale;
+	uint64_t len;
+	if( (1 != fread(&cap.m_freq, sizeof(cap.m_freq), 1, fp)) ||
+		(1 != fread(&iteration, sizeof(iteration), 1, fp)) ||
+		(1 != fread(&timescale, sizeof(timescale), 1, fp)) ||
+		(1 != fread(&len, sizeof(len), 1, fp)) )
+	{
+		fclose(fp);
+		return cap;
+	}
+	cap.m_iteration = iteration;
+
+	UniformAnalogWaveform* wfms[2];
+	for(int i=0; i<2; i++)
+	{
+		auto wfm = new UniformAnalogWaveform;
+		wfm->m_timescale = timescale;
+		wfm->m_triggerPhase = 0;
+		wfm->m_startTimestamp = 0;
+		wfm->m_startFemtoseconds = 0;
+		wfm->PrepareForCpuAccess();
+		wfm->Resize(len);
+		if(len != fread(wfm->m_samples.GetCpuPointer(), sizeof(float), len, fp))
+			LogWarning("%s is truncated\n", fname.c_str());
+		wfm->MarkModifiedFromCpu();
+		wfms[i] = wfm;
+	}
+	fclose(fp);
+
+	cap.m_ref = wfms[0];
+	cap.m_dut = wfms[1];
+	return cap;
+}
+
+/**
+	@brief Queues every capture of a sweep saved with --save, for benchmarking without any instruments attached
+
+	@return Number of captures queued. They aren't done until the DSP thread has exited.
+ */
+size_t ReplaySweep(const string& dir)
+{
+	size_t npoints = 0;
+	for(size_t i=0; ; i++)
+	{
+		char fname[512];
+		snprintf(fname, sizeof(fname), "%s/capture_%06zu.bin", dir.c_str(), i);
+
+		auto cap = LoadCapture(fname);
+		if(!cap.m_ref)
+			break;
+		PushCapture(cap);
+		npoints ++;
+	}
+	return npoints;
 }
 
 void BuildFilterGraph(Oscilloscope* scope)
 {
-	g_refChannel = scope->GetChannel(3);
-	g_dutChannel = scope->GetChannel(2);
+	g_refChannel = scope->GetChannel(0);
+	g_dutChannel = scope->GetChannel(1);
 
 	//Mix the reference and DUT waveform with coherent LOs
 	g_refMixerFilter = Filter::CreateFilter("Downconvert");
@@ -351,7 +640,7 @@ void OnWaveform(float refFreqHz, int iteration)
 	g_dutIfQFilter->GetParameter("Frequency High").SetFloatVal(ifBandHigh);
 
 	//Run the filter graph
-	FilterGraphExecutor ex;
+	static FilterGraphExecutor ex;
 	ex.RunBlocking(Filter::GetAllInstances());
 
 	//Calculate average amplitude
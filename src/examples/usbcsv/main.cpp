@@ -36,11 +36,73 @@
 #include "../scopehal/scopehal.h"
 #include "../scopehal/MockOscilloscope.h"
 #include "../scopeprotocols/scopeprotocols.h"
+#include <dirent.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <thread>
 
 using namespace std;
 
-bool ProcessWaveform(MockOscilloscope* scope, const string& fname, USB2PacketDecoder* pdecode);
+/**
+	@brief One independent copy of the decode pipeline, owned by a single worker thread
+ */
+class DecodeContext
+{
+public:
+	//Workers already run in parallel with each other, so each graph is executed on its own thread only
+	DecodeContext()
+		: m_executor(1)
+		, m_firstFileLoaded(false)
+		, m_firstLoadTime(0)
+	{}
+
+	MockOscilloscope* m_scope;
+	USB2PacketDecoder* m_decode;
+	set<Filter*> m_filters;
+	FilterGraphExecutor m_executor;
+
+	///@brief True if the first file is still loaded in m_scope from setup, and hasn't been decoded yet
+	bool m_firstFileLoaded;
+
+	///@brief Time taken to load the first file during setup
+	double m_firstLoadTime;
+};
+
+/**
+	@brief Output of decoding one file
+ */
+class DecodeResult
+{
+public:
+	DecodeResult()
+		: m_done(false)
+		, m_ok(false)
+		, m_loadTime(0)
+		, m_decodeTime(0)
+	{}
+
+	bool m_done;
+	bool m_ok;
+	string m_text;
+	double m_loadTime;
+	double m_decodeTime;
+};
+
+bool ProcessWaveform(const string& fname, DecodeContext* ctx, DecodeResult& result);
+bool LoadFastCSV(MockOscilloscope* scope, const string& fname);
+DecodeContext* CreateDecodeContext(const string& firstFile);
+DecodeContext* CloneDecodeContext(DecodeContext* first);
+void SetupFilterGraph(DecodeContext* ctx);
 USB2PacketDecoder* CreateFilterGraph(Oscilloscope* scope);
+void WorkerThread(
+	DecodeContext* ctx,
+	const vector<string>* files,
+	vector<DecodeResult>* results,
+	atomic<size_t>* nextFile);
+void ListCSVFiles(const string& path, vector<string>& files);
 string SymbolToString(USB2PacketSymbol sym);
 int64_t Round(int64_t number, int64_t step);
 
@@ -50,12 +112,16 @@ enum USBState {
 			   WAIT,
 };
 
+//Results are printed in file order, as soon as every earlier file is done
+mutex g_resultMutex;
+condition_variable g_resultReady;
 
 int main(int argc, char* argv[])
 {
 	Severity console_verbosity = Severity::NOTICE;
 
-	string fname = "";
+	vector<string> files;
+	size_t nthreads = max(thread::hardware_concurrency(), 1U);
 
 	//Parse command-line arguments
 	for(int i=1; i<argc; i++)
@@ -66,44 +132,175 @@ int main(int argc, char* argv[])
 		if(ParseLoggerArguments(i, argc, argv, console_verbosity))
 			continue;
 
+		else if( (s == "--threads") && (i+1 < argc) )
+			nthreads = max(atoi(argv[++i]), 1);
+
+		//Anything else is a CSV file, or a directory of them
 		else
-			fname = argv[i];
+			ListCSVFiles(s, files);
 	}
 
 	//Set up logging
 	g_log_sinks.emplace(g_log_sinks.begin(), new ColoredSTDLogSink(console_verbosity));
 
+	if(files.empty())
+	{
+		LogError("No CSV files specified\n");
+		return 1;
+	}
+
 	//Initialize object creation tables
 	TransportStaticInit();
 	DriverStaticInit();
 	ScopeProtocolStaticInit();
 	InitializePlugins();
 
+	//Set up one copy of the filter graph per worker, up front, so no two threads are ever creating filters at once.
+	//We need a waveform loaded before setting up the filter graph so that we have channel names and types.
+	//Only the first context actually loads it, the rest copy its channel layout.
+	nthreads = min(nthreads, files.size());
+	vector<DecodeContext*> contexts;
+	auto first = CreateDecodeContext(files[0]);
+	if(!first)
+		return 1;
+	contexts.push_back(first);
+	for(size_t i=1; i<nthreads; i++)
+		contexts.push_back(CloneDecodeContext(first));
+
+	//Decode everything. The first context starts on the file it already has loaded.
+	auto start = chrono::steady_clock::now();
+	vector<DecodeResult> results(files.size());
+	atomic<size_t> nextFile(1);
+	vector<thread*> threads;
+	for(auto ctx : contexts)
+		threads.push_back(new thread(WorkerThread, ctx, &files, &results, &nextFile));
+
+	//Print results in order as they come in
+	size_t nfailed = 0;
+	for(size_t i=0; i<files.size(); i++)
+	{
+		unique_lock<mutex> lock(g_resultMutex);
+		g_resultReady.wait(lock, [&]{ return results[i].m_done; });
+
+		auto& r = results[i];
+		LogNotice("%s: load %.1f ms, decode %.1f ms\n", files[i].c_str(), r.m_loadTime * 1e3, r.m_decodeTime * 1e3);
+		if(r.m_ok)
+			LogNotice("%s", r.m_text.c_str());
+		else
+			nfailed ++;
+
+		//Free up memory once we're done with it
+		r.m_text = "";
+	}
+
+	for(auto t : threads)
+	{
+		t->join();
+		delete t;
+	}
+	double dt = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	LogNotice("Decoded %zu files (%zu failed) in %.2f s using %zu threads\n", files.size(), nfailed, dt, nthreads);
+
+	//Clean up
+	for(auto ctx : contexts)
+	{
+		ctx->m_decode->Release();
+		delete ctx->m_scope;
+		delete ctx;
+	}
+	return (nfailed == 0) ? 0 : 1;
+}
+
+/**
+	@brief Adds a CSV file to the list, or every CSV file in a directory (in name order)
+ */
+void ListCSVFiles(const string& path, vector<string>& files)
+{
+	DIR* dir = opendir(path.c_str());
+	if(!dir)
+	{
+		files.push_back(path);
+		return;
+	}
+
+	vector<string> found;
+	dirent* ent;
+	while( (ent = readdir(dir)) != nullptr)
+	{
+		string name = ent->d_name;
+		if( (name.length() > 4) && (name.substr(name.length() - 4) == ".csv") )
+			found.push_back(path + "/" + name);
+	}
+	closedir(dir);
+
+	sort(found.begin(), found.end());
+	files.insert(files.end(), found.begin(), found.end());
+}
+
+/**
+	@brief Creates a mock scope and filter graph for the first worker thread, loading the first file into it
+ */
+DecodeContext* CreateDecodeContext(const string& firstFile)
+{
+	auto ctx = new DecodeContext;
+
 	//Create a dummy scope to use for import
-	auto scope = new MockOscilloscope("CSV Import", "Generic", "12345");
-	scope->m_nickname = "import";
+	ctx->m_scope = new MockOscilloscope("CSV Import", "Generic", "12345");
+	ctx->m_scope->m_nickname = "import";
 
-	//Load the first waveform from the batch.
-	//We need to do this before setting up the filter graph so that we have channel names and types.
 	LogDebug("Loading first waveform\n");
-	if(!scope->LoadCSV(fname))
+	auto start = chrono::steady_clock::now();
+	if(!ctx->m_scope->LoadCSV(firstFile))
 	{
-		LogError("Failed to load CSV %s\n", fname.c_str());
-		return 0;
+		LogError("Failed to load CSV %s\n", firstFile.c_str());
+		delete ctx->m_scope;
+		delete ctx;
+		return nullptr;
 	}
+	ctx->m_firstLoadTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	ctx->m_firstFileLoaded = true;
 
-	//Set up the decodes
-	auto pdecode = CreateFilterGraph(scope);
+	SetupFilterGraph(ctx);
+	return ctx;
+}
 
-	//Load and decode each waveform in the batch.
-	//Can loop this.
-	if(!ProcessWaveform(scope, fname, pdecode))
-		return 1;
+/**
+	@brief Creates a mock scope and filter graph for another worker thread, with the same channels as the first one
+ */
+DecodeContext* CloneDecodeContext(DecodeContext* first)
+{
+	auto ctx = new DecodeContext;
 
-	//Clean up
-	pdecode->Release();
-	delete scope;
-	return 0;
+	ctx->m_scope = new MockOscilloscope("CSV Import", "Generic", "12345");
+	ctx->m_scope->m_nickname = "import";
+	for(size_t i=0; i<first->m_scope->GetChannelCount(); i++)
+	{
+		ctx->m_scope->AddChannel(new OscilloscopeChannel(
+			ctx->m_scope,
+			first->m_scope->GetChannel(i)->GetHwname(),
+			"#ffffff",
+			Unit(Unit::UNIT_FS),
+			Unit(Unit::UNIT_VOLTS),
+			Stream::STREAM_TYPE_ANALOG,
+			i));
+	}
+
+	SetupFilterGraph(ctx);
+	return ctx;
+}
+
+/**
+	@brief Sets up the decodes for a context, and remembers which filters are ours so we never run another worker's graph
+ */
+void SetupFilterGraph(DecodeContext* ctx)
+{
+	auto before = Filter::GetAllInstances();
+	ctx->m_decode = CreateFilterGraph(ctx->m_scope);
+	for(auto f : Filter::GetAllInstances())
+	{
+		if(before.find(f) == before.end())
+			ctx->m_filters.emplace(f);
+	}
 }
 
 USB2PacketDecoder* CreateFilterGraph(Oscilloscope* scope)
@@ -127,6 +324,197 @@ USB2PacketDecoder* CreateFilterGraph(Oscilloscope* scope)
 	return dynamic_cast<USB2PacketDecoder*>(pack);
 }
 
+/**
+	@brief Decodes files until there are none left
+ */
+void WorkerThread(
+	DecodeContext* ctx,
+	const vector<string>* files,
+	vector<DecodeResult>* results,
+	atomic<size_t>* nextFile)
+{
+	while(true)
+	{
+		size_t i = ctx->m_firstFileLoaded ? 0 : (*nextFile) ++;
+		if(i >= files->size())
+			break;
+
+		DecodeResult result;
+		result.m_ok = ProcessWaveform((*files)[i], ctx, result);
+
+		lock_guard<mutex> lock(g_resultMutex);
+		result.m_done = true;
+		(*results)[i] = move(result);
+		g_resultReady.notify_all();
+	}
+}
+
+/**
+	@brief Parses a floating point number, advancing the pointer past it
+
+	Much faster than strtod() since we don't care about locales, hex floats, etc.
+ */
+static double ParseNumber(const char*& p, const char* end)
+{
+	bool negative = false;
+	if( (p < end) && ( (*p == '-') || (*p == '+') ) )
+	{
+		negative = (*p == '-');
+		p++;
+	}
+
+	double value = 0;
+	while( (p < end) && isdigit(*p) )
+		value = value*10 + (*(p++) - '0');
+
+	if( (p < end) && (*p == '.') )
+	{
+		p++;
+		double scale = 0.1;
+		while( (p < end) && isdigit(*p) )
+		{
+			value += (*(p++) - '0') * scale;
+			scale *= 0.1;
+		}
+	}
+
+	if( (p < end) && ( (*p == 'e') || (*p == 'E') ) )
+	{
+		p++;
+		bool negexp = false;
+		if( (p < end) && ( (*p == '-') || (*p == '+') ) )
+		{
+			negexp = (*p == '-');
+			p++;
+		}
+		int exp = 0;
+		while( (p < end) && isdigit(*p) )
+			exp = exp*10 + (*(p++) - '0');
+		value *= pow(10, negexp ? -exp : exp);
+	}
+
+	return negative ? -value : value;
+}
+
+/**
+	@brief Loads a CSV file into a scope which already has channels set up from a previous LoadCSV() call
+
+	The file is streamed through a fixed size buffer and parsed in place. The first column is time in seconds and
+	each additional column is one channel. Header lines (anything not starting with a number) are skipped.
+
+	@return False if the file couldn't be read or doesn't have the expected number of columns
+ */
+bool LoadFastCSV(MockOscilloscope* scope, const string& fname)
+{
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if(!fp)
+		return false;
+
+	size_t nchans = scope->GetChannelCount();
+	vector<SparseAnalogWaveform*> waveforms;
+	for(size_t i=0; i<nchans; i++)
+	{
+		auto wfm = new SparseAnalogWaveform;
+		wfm->m_timescale = 1;
+		wfm->m_triggerPhase = 0;
+		wfm->m_startTimestamp = time(nullptr);
+		wfm->m_startFemtoseconds = 0;
+		wfm->PrepareForCpuAccess();
+		waveforms.push_back(wfm);
+	}
+
+	const size_t blocksize = 1024 * 1024;
+	vector<char> buf(blocksize);
+	size_t used = 0;
+	bool ok = true;
+	bool first = true;
+	int64_t tstart = 0;
+	vector<float> values(nchans);
+	while(ok)
+	{
+		size_t nread = fread(&buf[used], 1, buf.size() - used, fp);
+		size_t len = used + nread;
+		bool eof = (nread == 0);
+		if(eof && (len == 0))
+			break;
+
+		//Parse all complete lines (or everything, at end of file)
+		const char* p = &buf[0];
+		const char* end = p + len;
+		while(p < end)
+		{
+			const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+			if(!eol)
+			{
+				if(!eof)
+					break;
+				eol = end;
+			}
+
+			//Skip header and blank lines
+			if( (p < eol) && (isdigit(*p) || (*p == '-') || (*p == '+') || (*p == '.')) )
+			{
+				int64_t t = ParseNumber(p, eol) * FS_PER_SECOND;
+				size_t col = 0;
+				for(; (col < nchans) && (p < eol) && (*p == ','); col++)
+				{
+					p++;
+					values[col] = ParseNumber(p, eol);
+				}
+				if(col != nchans)
+				{
+					ok = false;
+					break;
+				}
+
+				if(first)
+				{
+					tstart = t;
+					first = false;
+				}
+				for(size_t i=0; i<nchans; i++)
+				{
+					waveforms[i]->m_offsets.push_back(t - tstart);
+					waveforms[i]->m_samples.push_back(values[i]);
+				}
+			}
+
+			p = eol + 1;
+		}
+		if(eof)
+			break;
+
+		//Move the partial line to the start of the buffer, growing it if a single line didn't fit
+		used = (p < end) ? (end - p) : 0;
+		memmove(&buf[0], p, used);
+		if(used == buf.size())
+			buf.resize(buf.size() * 2);
+	}
+	fclose(fp);
+
+	if(!ok || first)
+	{
+		for(auto w : waveforms)
+			delete w;
+		return false;
+	}
+
+	//Each sample lasts until the next one starts
+	for(auto w : waveforms)
+	{
+		size_t n = w->m_offsets.size();
+		w->m_durations.resize(n);
+		for(size_t i=0; i+1<n; i++)
+			w->m_durations[i] = w->m_offsets[i+1] - w->m_offsets[i];
+		w->m_durations[n-1] = (n > 1) ? w->m_durations[n-2] : 1;
+		w->MarkModifiedFromCpu();
+	}
+
+	for(size_t i=0; i<nchans; i++)
+		scope->GetChannel(i)->SetData(waveforms[i], 0);
+	return true;
+}
+
 //I created this because my LA only samples at a certain rate
 //and femtoseconds is too much precision.
 int64_t Round(int64_t number, int64_t step)
@@ -142,23 +530,33 @@ int64_t Round(int64_t number, int64_t step)
 }
 
 
-bool ProcessWaveform(MockOscilloscope* scope, const string& fname, USB2PacketDecoder* pdecode)
+bool ProcessWaveform(const string& fname, DecodeContext* ctx, DecodeResult& result)
 {
-	//Import the waveform
-	//LogNotice("Loading waveform \"%s\"\n", fname.c_str());
-	//LogIndenter li;
-
-	if(!scope->LoadCSV(fname))
+	//Import the waveform. The fast parser handles files in the same format as the first one, anything else
+	//goes through the generic importer.
+	auto start = chrono::steady_clock::now();
+	if(ctx->m_firstFileLoaded)
 	{
-		LogError("Failed to load CSV %s\n", fname.c_str());
-		return false;
+		//Already loaded during setup
+		ctx->m_firstFileLoaded = false;
+		result.m_loadTime = ctx->m_firstLoadTime;
 	}
+	else
+	{
+		if(!LoadFastCSV(ctx->m_scope, fname) && !ctx->m_scope->LoadCSV(fname))
+		{
+			LogError("Failed to load CSV %s\n", fname.c_str());
+			return false;
+		}
+		result.m_loadTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
+	auto loaded = chrono::steady_clock::now();
 
 	//Run the filter graph
-	FilterGraphExecutor ex;
-	ex.RunBlocking(Filter::GetAllInstances());
+	ctx->m_executor.RunBlocking(ctx->m_filters);
+	result.m_decodeTime = chrono::duration<double>(chrono::steady_clock::now() - loaded).count();
 
-	auto waveform = dynamic_cast<USB2PacketWaveform*>(pdecode->GetData(0));
+	auto waveform = dynamic_cast<USB2PacketWaveform*>(ctx->m_decode->GetData(0));
 	if(!waveform)
 	{
 		LogError("Decode failed\n");
@@ -171,13 +569,15 @@ bool ProcessWaveform(MockOscilloscope* scope, const string& fname, USB2PacketDec
 	//in USB captures I have taken.
 	int64_t step = 8e7;
 
-	//Print the protocol analyzer data
+	//Format the protocol analyzer data. It's printed by the main thread, in file order
+	char tmp[128];
 	{
 		size_t len = waveform->m_samples.size();
 		USBState state = USBState::SETUP;
 		std::vector<size_t> elts;
 		std::vector<size_t> setup;
 		bool collect = false;
+		size_t npackets = 0;
 
 		for(size_t i=0; i<len;)
 		{
@@ -214,11 +614,10 @@ bool ProcessWaveform(MockOscilloscope* scope, const string& fname, USB2PacketDec
 
 			}
 
+			//No more transactions after the last one we printed
 			if (elts.size() == 0)
-			{
-				LogError("No packets found.\n");
-				return false;
-			}
+				break;
+			npackets ++;
 
 			auto first = elts[0];
 			auto last = elts[elts.size()-1];
@@ -227,25 +626,34 @@ bool ProcessWaveform(MockOscilloscope* scope, const string& fname, USB2PacketDec
 			int64_t right = Round(waveform->m_offsets[last] * waveform->m_timescale, step)/step;
 			string pid = SymbolToString(waveform->m_samples[first]);
 
-			LogNotice("%lu %lu %s ", left, right, pid.c_str());
+			snprintf(tmp, sizeof(tmp), "%" PRId64 " %" PRId64 " %s ", left, right, pid.c_str());
+			result.m_text += tmp;
 
 			for (auto loc : elts)
 			{
 				auto sym = waveform->m_samples[loc];
-				LogNotice("%02x ", sym.m_data);
+				snprintf(tmp, sizeof(tmp), "%02x ", sym.m_data);
+				result.m_text += tmp;
 			}
 
-			LogNotice("| ");
+			result.m_text += "| ";
 			for (auto loc : setup)
 			{
 				auto sym = waveform->m_samples[loc];
-				LogNotice("%02x ", sym.m_data);
+				snprintf(tmp, sizeof(tmp), "%02x ", sym.m_data);
+				result.m_text += tmp;
 			}
 
-			LogNotice("\n");
+			result.m_text += "\n";
 
 			elts.clear();
 		}
+
+		if (npackets == 0)
+		{
+			LogError("%s: No packets found.\n", fname.c_str());
+			return false;
+		}
 	}
 
 	return true;
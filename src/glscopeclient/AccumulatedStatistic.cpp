@@ -0,0 +1,240 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of AccumulatedStatistic and QuantileSketch
+ */
+#include "glscopeclient.h"
+#include "AccumulatedStatistic.h"
+#include <cinttypes>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// QuantileSketch
+
+QuantileSketch::QuantileSketch()
+	: m_count(0)
+	, m_oddCompaction(false)
+{
+}
+
+void QuantileSketch::Clear()
+{
+	m_levels.clear();
+	m_count = 0;
+	m_oddCompaction = false;
+}
+
+void QuantileSketch::Add(double value)
+{
+	if(m_levels.empty())
+		m_levels.resize(1);
+
+	m_levels[0].push_back(value);
+	m_count ++;
+
+	if(m_levels[0].size() >= LEVEL_CAPACITY)
+		Compact(0);
+}
+
+/**
+	@brief Sorts a full level and promotes every other value to the level above it
+ */
+void QuantileSketch::Compact(size_t level)
+{
+	if(m_levels.size() <= level+1)
+		m_levels.resize(level+2);
+
+	auto& src = m_levels[level];
+	sort(src.begin(), src.end());
+
+	//An odd value out stays behind, so the total weight is preserved
+	double leftover = 0;
+	bool hasLeftover = (src.size() & 1);
+	if(hasLeftover)
+	{
+		leftover = src.back();
+		src.pop_back();
+	}
+
+	auto& dst = m_levels[level+1];
+	for(size_t i = m_oddCompaction ? 1 : 0; i < src.size(); i += 2)
+		dst.push_back(src[i]);
+	m_oddCompaction = !m_oddCompaction;
+
+	src.clear();
+	if(hasLeftover)
+		src.push_back(leftover);
+
+	if(dst.size() >= LEVEL_CAPACITY)
+		Compact(level+1);
+}
+
+/**
+	@brief Gets the approximate value below which a fraction q of the values fall
+
+	@param q	Quantile, from 0 to 1
+ */
+double QuantileSketch::GetQuantile(double q) const
+{
+	vector< pair<double, uint64_t> > weighted;
+	uint64_t total = 0;
+	for(size_t i=0; i<m_levels.size(); i++)
+	{
+		uint64_t weight = 1ULL << i;
+		for(auto v : m_levels[i])
+		{
+			weighted.push_back(pair<double, uint64_t>(v, weight));
+			total += weight;
+		}
+	}
+	if(weighted.empty())
+		return 0;
+
+	sort(weighted.begin(), weighted.end());
+
+	uint64_t target = llround(q * total);
+	uint64_t sum = 0;
+	for(auto& w : weighted)
+	{
+		sum += w.second;
+		if(sum >= target)
+			return w.first;
+	}
+	return weighted.back().first;
+}
+
+string QuantileSketch::Serialize(const string& indent) const
+{
+	char tmp[64];
+	string config = indent + "levels:\n";
+	for(auto& level : m_levels)
+	{
+		config += indent + "    - [";
+		for(size_t i=0; i<level.size(); i++)
+		{
+			snprintf(tmp, sizeof(tmp), (i == 0) ? "%.17g" : ", %.17g", level[i]);
+			config += tmp;
+		}
+		config += "]\n";
+	}
+	return config;
+}
+
+void QuantileSketch::Load(const YAML::Node& node)
+{
+	Clear();
+
+	auto levels = node["levels"];
+	if(!levels)
+		return;
+
+	for(auto level : levels)
+		m_levels.push_back(level.as< vector<double> >());
+
+	for(size_t i=0; i<m_levels.size(); i++)
+		m_count += m_levels[i].size() << i;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AccumulatedStatistic
+
+AccumulatedStatistic::AccumulatedStatistic()
+{
+	Clear();
+}
+
+void AccumulatedStatistic::Clear()
+{
+	m_count = 0;
+	m_mean = 0;
+	m_m2 = 0;
+	m_min = DBL_MAX;
+	m_max = -DBL_MAX;
+	m_sketch.Clear();
+}
+
+void AccumulatedStatistic::Add(double value)
+{
+	m_count ++;
+	double delta = value - m_mean;
+	m_mean += delta / m_count;
+	m_m2 += delta * (value - m_mean);
+
+	m_min = min(m_min, value);
+	m_max = max(m_max, value);
+
+	m_sketch.Add(value);
+}
+
+/**
+	@brief Gets the sample standard deviation of everything added so far
+ */
+double AccumulatedStatistic::GetStdDev() const
+{
+	if(m_count < 2)
+		return 0;
+	return sqrt(m_m2 / (m_count - 1));
+}
+
+string AccumulatedStatistic::Serialize(const string& indent) const
+{
+	char tmp[128];
+	snprintf(tmp, sizeof(tmp), "%scount: %" PRIu64 "\n", indent.c_str(), m_count);
+	string config = tmp;
+	snprintf(tmp, sizeof(tmp), "%smean:  %.17g\n", indent.c_str(), m_mean);
+	config += tmp;
+	snprintf(tmp, sizeof(tmp), "%sm2:    %.17g\n", indent.c_str(), m_m2);
+	config += tmp;
+	snprintf(tmp, sizeof(tmp), "%smin:   %.17g\n", indent.c_str(), m_min);
+	config += tmp;
+	snprintf(tmp, sizeof(tmp), "%smax:   %.17g\n", indent.c_str(), m_max);
+	config += tmp;
+	config += indent + "sketch:\n";
+	config += m_sketch.Serialize(indent + "    ");
+	return config;
+}
+
+void AccumulatedStatistic::Load(const YAML::Node& node)
+{
+	Clear();
+
+	m_count = node["count"].as<uint64_t>();
+	m_mean = node["mean"].as<double>();
+	m_m2 = node["m2"].as<double>();
+	m_min = node["min"].as<double>();
+	m_max = node["max"].as<double>();
+
+	auto sketch = node["sketch"];
+	if(sketch)
+		m_sketch.Load(sketch);
+}
@@ -0,0 +1,123 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of AccumulatedStatistic and QuantileSketch
+ */
+
+#ifndef AccumulatedStatistic_h
+#define AccumulatedStatistic_h
+
+/**
+	@brief Approximate quantiles of a stream of values in bounded memory
+
+	Values are kept in a stack of levels. Whenever a level fills up it is sorted and every other value is promoted to
+	the next level, with twice the weight. Memory use grows with the log of the number of values seen.
+ */
+class QuantileSketch
+{
+public:
+	QuantileSketch();
+
+	void Clear();
+	void Add(double value);
+	double GetQuantile(double q) const;
+
+	///@brief Total number of values added since the last clear
+	uint64_t GetCount() const
+	{ return m_count; }
+
+	std::string Serialize(const std::string& indent) const;
+	void Load(const YAML::Node& node);
+
+protected:
+	void Compact(size_t level);
+
+	///@brief Number of values a level holds before it gets compacted
+	static const size_t LEVEL_CAPACITY = 256;
+
+	///@brief Retained values. Each value in level N stands for 2^N of the original values
+	std::vector< std::vector<double> > m_levels;
+
+	///@brief Total number of values added
+	uint64_t m_count;
+
+	///@brief Alternates which half of a level survives compaction, so we don't bias high or low
+	bool m_oddCompaction;
+};
+
+/**
+	@brief Running statistics of one measurement across many triggers, without keeping any history
+
+	Mean and variance use Welford's algorithm, percentiles come from a QuantileSketch.
+ */
+class AccumulatedStatistic
+{
+public:
+	AccumulatedStatistic();
+
+	void Clear();
+	void Add(double value);
+
+	uint64_t GetCount() const
+	{ return m_count; }
+
+	double GetMean() const
+	{ return m_mean; }
+
+	double GetStdDev() const;
+
+	double GetMin() const
+	{ return m_min; }
+
+	double GetMax() const
+	{ return m_max; }
+
+	double GetQuantile(double q) const
+	{ return m_sketch.GetQuantile(q); }
+
+	std::string Serialize(const std::string& indent) const;
+	void Load(const YAML::Node& node);
+
+protected:
+	uint64_t m_count;
+	double m_mean;
+
+	///@brief Sum of squared differences from the mean
+	double m_m2;
+
+	double m_min;
+	double m_max;
+
+	QuantileSketch m_sketch;
+};
+
+#endif
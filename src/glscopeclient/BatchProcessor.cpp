@@ -0,0 +1,419 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of BatchProcessor
+ */
+#include "glscopeclient.h"
+#include "BatchProcessor.h"
+#include <cinttypes>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+BatchProcessor::BatchProcessor()
+{
+	m_time.first = 0;
+	m_time.second = 0;
+}
+
+BatchProcessor::~BatchProcessor()
+{
+	for(auto it : m_packetFiles)
+		fclose(it.second);
+
+	for(auto f : m_filters)
+		f->Release();
+	for(auto s : m_scopes)
+		delete s;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Loading
+
+/**
+	@brief Loads the instruments and filter graph from a session, plus the list of saved waveforms
+
+	@return True on success
+ */
+bool BatchProcessor::Load(const string& filename)
+{
+	try
+	{
+		auto docs = YAML::LoadAllFromFile(filename);
+		auto node = docs[0];
+
+		//Instruments
+		auto instruments = node["instruments"];
+		if(!instruments)
+		{
+			LogError("Save file missing instruments node\n");
+			return false;
+		}
+		for(auto it : instruments)
+		{
+			auto inst = it.second;
+			auto scope = OscilloscopeWindow::CreateOfflineInstrument(inst);
+			m_scopes.push_back(scope);
+			m_table.emplace(inst["id"].as<int>(), scope);
+			scope->LoadConfiguration(inst, m_table);
+		}
+
+		//Filters
+		vector<string> failed;
+		OscilloscopeWindow::LoadFilters(node["decodes"], m_table, failed);
+		for(auto proto : failed)
+			LogError("Unable to create filter \"%s\", skipping\n", proto.c_str());
+
+		for(auto f : Filter::GetAllInstances())
+		{
+			f->AddRef();
+			m_filters.push_back(f);
+		}
+		sort(m_filters.begin(), m_filters.end(),
+			[](Filter* a, Filter* b) { return a->GetDisplayName() < b->GetDisplayName(); });
+
+		//Waveform metadata
+		m_datadir = filename.substr(0, filename.length() - strlen(".scopesession")) + "_data";
+		for(auto scope : m_scopes)
+		{
+			char tmp[512];
+			snprintf(tmp, sizeof(tmp), "%s/scope_%d_metadata.yml", m_datadir.c_str(), m_table[scope]);
+			auto mdocs = YAML::LoadAllFromFile(tmp);
+
+			vector<YAML::Node> waveforms;
+			for(auto it : mdocs[0]["waveforms"])
+				waveforms.push_back(it.second);
+			m_waveforms.push_back(waveforms);
+		}
+	}
+	catch(const YAML::Exception& ex)
+	{
+		LogError("Unable to load %s: %s\n", filename.c_str(), ex.what());
+		return false;
+	}
+
+	return true;
+}
+
+/**
+	@brief Loads one history waveform into every instrument that has one at that index
+
+	Each channel's samples are loaded by its own thread, as in the interactive loader.
+
+	@return False if no instrument had a waveform at that index
+ */
+bool BatchProcessor::LoadWaveform(size_t index)
+{
+	bool found = false;
+	for(size_t i=0; i<m_scopes.size(); i++)
+	{
+		if(index >= m_waveforms[i].size())
+			continue;
+		found = true;
+
+		auto scope = m_scopes[i];
+		int scope_id = m_table[scope];
+		vector<pair<int, int>> channels;
+		vector<string> formats;
+		int waveform_id = OscilloscopeWindow::PrepareHistoryWaveform(
+			m_waveforms[i][index], scope, m_time, channels, formats, m_datadir, scope_id, &m_pool);
+
+		size_t nchans = channels.size();
+		vector<float> channel_progress(nchans, 0);
+		vector<int> channel_done(nchans, 0);
+		vector<thread*> threads;
+		for(size_t j=0; j<nchans; j++)
+		{
+			threads.push_back(new thread(
+				&OscilloscopeWindow::DoLoadWaveformDataForScope,
+				channels[j].first,
+				channels[j].second,
+				scope,
+				m_datadir,
+				scope_id,
+				waveform_id,
+				formats[j],
+				&channel_progress[j],
+				&channel_done[j]
+				));
+		}
+		for(auto t : threads)
+		{
+			t->join();
+			delete t;
+		}
+	}
+
+	return found;
+}
+
+/**
+	@brief Detaches the waveform we just processed from every instrument channel
+
+	There's no history in batch mode, so nothing else owns these waveforms. They go to the pool, where they are
+	either reused for the next waveform or freed when we're destroyed.
+ */
+void BatchProcessor::ReleaseWaveforms()
+{
+	for(auto scope : m_scopes)
+	{
+		for(size_t i=0; i<scope->GetChannelCount(); i++)
+		{
+			auto chan = scope->GetChannel(i);
+			for(size_t j=0; j<chan->GetStreamCount(); j++)
+			{
+				auto data = chan->Detach(j);
+				if(data)
+					m_pool.Add(data);
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Processing
+
+/**
+	@brief Runs the filter graph over every saved waveform, in order, and writes the results to a directory
+
+	Waveforms are processed one at a time because filters like averages and eye patterns integrate across
+	waveforms. Within each waveform, the executor runs independent filters in parallel.
+
+	@return True on success
+ */
+bool BatchProcessor::Run(const string& outdir)
+{
+	string fname = outdir + "/measurements.csv";
+	FILE* fp = fopen(fname.c_str(), "w");
+	if(!fp)
+	{
+		LogError("Couldn't create %s\n", fname.c_str());
+		return false;
+	}
+	m_usedFileNames.emplace("measurements");
+	WriteMeasurementHeader(fp);
+
+	set<Filter*> filters(m_filters.begin(), m_filters.end());
+	size_t nwaveforms = 0;
+	for(size_t i=0; LoadWaveform(i); i++)
+	{
+		{
+			TraceSpan span("FilterGraphExecutor::RunBlocking");
+			m_executor.RunBlocking(filters);
+		}
+
+		WriteMeasurements(fp);
+		WritePackets(outdir);
+		ReleaseWaveforms();
+		nwaveforms ++;
+
+		LogVerbose("Processed waveform %zu\n", nwaveforms);
+	}
+
+	fclose(fp);
+	LogNotice("Processed %zu waveforms\n", nwaveforms);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Output
+
+/**
+	@brief Quotes a string for a CSV field, if it needs it
+ */
+string BatchProcessor::CSVEscape(const string& str)
+{
+	if(str.find_first_of(",\"\n") == string::npos)
+		return str;
+
+	string ret = "\"";
+	for(auto c : str)
+	{
+		if(c == '"')
+			ret += "\"\"";
+		else
+			ret += c;
+	}
+	return ret + "\"";
+}
+
+/**
+	@brief Replaces anything that isn't safe in a file name (on any platform) with an underscore
+ */
+string BatchProcessor::SanitizeFileName(const string& name)
+{
+	string ret;
+	for(auto c : name)
+	{
+		if( (static_cast<unsigned char>(c) < 0x20) || (strchr("/\\:*?\"<>|", c) != nullptr) )
+			ret += '_';
+		else
+			ret += c;
+	}
+
+	//Don't end up with a hidden file, or one that refers to a directory
+	if(ret.empty() || (ret[0] == '.') )
+		ret = "_" + ret;
+	return ret;
+}
+
+/**
+	@brief Picks an output file for a protocol decode, named after it but not clashing with any other output file
+ */
+string BatchProcessor::GetPacketFileName(const string& outdir, Filter* f)
+{
+	//Compare case insensitively, since two names differing only in case are the same file on some filesystems
+	string base = SanitizeFileName(f->GetDisplayName());
+	string name = base;
+	for(int i=2; ; i++)
+	{
+		string lower = name;
+		transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+		if(m_usedFileNames.find(lower) == m_usedFileNames.end())
+		{
+			m_usedFileNames.emplace(lower);
+			break;
+		}
+		name = base + "_" + to_string(i);
+	}
+	return outdir + "/" + name + ".csv";
+}
+
+void BatchProcessor::WriteMeasurementHeader(FILE* fp)
+{
+	fprintf(fp, "timestamp,femtoseconds");
+	for(auto f : m_filters)
+	{
+		for(size_t i=0; i<f->GetStreamCount(); i++)
+		{
+			if(f->GetType(i) != Stream::STREAM_TYPE_ANALOG)
+				continue;
+
+			auto name = StreamDescriptor(f, i).GetName();
+			fprintf(fp, ",%s,%s,%s",
+				CSVEscape(name + " min").c_str(),
+				CSVEscape(name + " max").c_str(),
+				CSVEscape(name + " mean").c_str());
+		}
+	}
+	fprintf(fp, "\n");
+}
+
+/**
+	@brief Writes the min, max and mean of every analog filter output for the current waveform
+ */
+void BatchProcessor::WriteMeasurements(FILE* fp)
+{
+	fprintf(fp, "%" PRId64 ",%" PRId64, (int64_t)m_time.first, m_time.second);
+	for(auto f : m_filters)
+	{
+		for(size_t i=0; i<f->GetStreamCount(); i++)
+		{
+			if(f->GetType(i) != Stream::STREAM_TYPE_ANALOG)
+				continue;
+
+			//Leave the fields blank if the filter didn't produce anything
+			auto data = f->GetData(i);
+			auto udata = dynamic_cast<UniformAnalogWaveform*>(data);
+			auto sdata = dynamic_cast<SparseAnalogWaveform*>(data);
+			if( (!udata && !sdata) || (data->size() == 0) )
+			{
+				fprintf(fp, ",,,");
+				continue;
+			}
+
+			data->PrepareForCpuAccess();
+			const float* samples = udata ? udata->m_samples.GetCpuPointer() : sdata->m_samples.GetCpuPointer();
+			size_t len = data->size();
+			float vmin = FLT_MAX;
+			float vmax = -FLT_MAX;
+			double sum = 0;
+			for(size_t j=0; j<len; j++)
+			{
+				vmin = min(vmin, samples[j]);
+				vmax = max(vmax, samples[j]);
+				sum += samples[j];
+			}
+			fprintf(fp, ",%.9g,%.9g,%.9g", vmin, vmax, sum / len);
+		}
+	}
+	fprintf(fp, "\n");
+}
+
+/**
+	@brief Appends the packets from each protocol decode for the current waveform to that decode's CSV
+ */
+void BatchProcessor::WritePackets(const string& outdir)
+{
+	for(auto f : m_filters)
+	{
+		auto decoder = dynamic_cast<PacketDecoder*>(f);
+		if(!decoder)
+			continue;
+		auto headers = decoder->GetHeaders();
+
+		//Open the file and write the header the first time around
+		FILE* fp = m_packetFiles[decoder];
+		if(!fp)
+		{
+			string fname = GetPacketFileName(outdir, f);
+			fp = fopen(fname.c_str(), "w");
+			if(!fp)
+			{
+				LogError("Couldn't create %s\n", fname.c_str());
+				m_packetFiles.erase(decoder);
+				continue;
+			}
+			m_packetFiles[decoder] = fp;
+
+			fprintf(fp, "timestamp,femtoseconds,offset,length");
+			for(auto& h : headers)
+				fprintf(fp, ",%s", CSVEscape(h).c_str());
+			fprintf(fp, ",data\n");
+		}
+
+		for(auto p : decoder->GetPackets())
+		{
+			fprintf(fp, "%" PRId64 ",%" PRId64 ",%" PRId64 ",%" PRId64,
+				(int64_t)m_time.first, m_time.second, p->m_offset, p->m_len);
+			for(auto& h : headers)
+				fprintf(fp, ",%s", CSVEscape(p->m_headers[h]).c_str());
+
+			fprintf(fp, ",");
+			for(auto b : p->m_data)
+				fprintf(fp, "%02x", b);
+			fprintf(fp, "\n");
+		}
+	}
+}
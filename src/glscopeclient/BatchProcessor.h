@@ -0,0 +1,97 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of BatchProcessor
+ */
+
+#ifndef BatchProcessor_h
+#define BatchProcessor_h
+
+/**
+	@brief Runs the filter graph of a saved session over each of its history waveforms, without any UI
+
+	Instruments are always loaded offline. For each history waveform, a summary of every analog filter output is
+	written to measurements.csv, and every packet from each protocol decode is written to a CSV named after the decode
+	(with characters that aren't valid in file names replaced, and a numeric suffix if two decodes end up the same).
+ */
+class BatchProcessor
+{
+public:
+	BatchProcessor();
+	virtual ~BatchProcessor();
+
+	bool Load(const std::string& filename);
+	bool Run(const std::string& outdir);
+
+protected:
+	bool LoadWaveform(size_t index);
+	void ReleaseWaveforms();
+
+	void WriteMeasurementHeader(FILE* fp);
+	void WriteMeasurements(FILE* fp);
+	void WritePackets(const std::string& outdir);
+
+	static std::string CSVEscape(const std::string& str);
+	static std::string SanitizeFileName(const std::string& name);
+	std::string GetPacketFileName(const std::string& outdir, Filter* f);
+
+	///@brief Object IDs from the session file
+	IDTable m_table;
+
+	///@brief The (offline) instruments in the session
+	std::vector<Oscilloscope*> m_scopes;
+
+	///@brief Session data directory
+	std::string m_datadir;
+
+	///@brief Metadata of each saved waveform, for each instrument (indexed the same as m_scopes)
+	std::vector< std::vector<YAML::Node> > m_waveforms;
+
+	///@brief Timestamp of the waveform currently loaded
+	TimePoint m_time;
+
+	///@brief Every filter in the session, in display name order
+	std::vector<Filter*> m_filters;
+
+	///@brief Output file for each protocol decode
+	std::map<PacketDecoder*, FILE*> m_packetFiles;
+
+	///@brief Base names (lowercased) of every output file so far, so two decodes never share one
+	std::set<std::string> m_usedFileNames;
+
+	///@brief Waveforms already processed, recycled for loading the next one
+	WaveformPool m_pool;
+
+	FilterGraphExecutor m_executor;
+};
+
+#endif
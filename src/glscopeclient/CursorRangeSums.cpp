@@ -0,0 +1,211 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of CursorRangeSums
+ */
+#include "glscopeclient.h"
+#include "CursorRangeSums.h"
+#include <omp.h>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+CursorRangeSums::CursorRangeSums()
+	: m_data(nullptr)
+	, m_size(0)
+	, m_valid(false)
+	, m_dbm(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Building the sums
+
+/**
+	@brief Marks the sums as stale, so they get rebuilt next time they're used
+ */
+void CursorRangeSums::Invalidate()
+{
+	m_valid = false;
+}
+
+/**
+	@brief Rebuilds the sums if the waveform has changed since they were last built
+
+	The prefix sum is computed in parallel: each thread sums its own block of samples, then every block is offset by
+	the total of the blocks before it.
+
+	@param data		The waveform
+	@param dbm		True if the waveform is in dBm, so samples have to be converted to watts before summing
+
+	@return False if the waveform isn't analog, so there's nothing to measure
+ */
+bool CursorRangeSums::Update(WaveformBase* data, bool dbm)
+{
+	auto udata = dynamic_cast<UniformAnalogWaveform*>(data);
+	auto sdata = dynamic_cast<SparseAnalogWaveform*>(data);
+	if(!udata && !sdata)
+		return false;
+
+	size_t len = data->size();
+	if(m_valid && (m_data == data) && (m_size == len) && (m_dbm == dbm) )
+		return true;
+
+	data->PrepareForCpuAccess();
+	const float* samples = udata ? udata->m_samples.GetCpuPointer() : sdata->m_samples.GetCpuPointer();
+
+	m_sum.resize(len + 1);
+	m_sum[0] = 0;
+
+	size_t nblocks = omp_get_max_threads();
+	size_t blocksize = (len + nblocks - 1) / nblocks;
+	vector<double> blockOffsets(nblocks + 1, 0);
+
+	//Running sum within each block
+	#pragma omp parallel for
+	for(size_t b=0; b<nblocks; b++)
+	{
+		size_t start = min(len, b*blocksize);
+		size_t end = min(len, start + blocksize);
+
+		double sum = 0;
+		if(dbm)
+		{
+			for(size_t i=start; i<end; i++)
+			{
+				sum += pow(10, (samples[i] - 30) / 10);
+				m_sum[i+1] = sum;
+			}
+		}
+		else
+		{
+			for(size_t i=start; i<end; i++)
+			{
+				sum += samples[i];
+				m_sum[i+1] = sum;
+			}
+		}
+		blockOffsets[b+1] = sum;
+	}
+
+	//Each block starts where the previous one left off
+	for(size_t b=0; b<nblocks; b++)
+		blockOffsets[b+1] += blockOffsets[b];
+
+	#pragma omp parallel for
+	for(size_t b=1; b<nblocks; b++)
+	{
+		size_t start = min(len, b*blocksize);
+		size_t end = min(len, start + blocksize);
+		double offset = blockOffsets[b];
+		for(size_t i=start; i<end; i++)
+			m_sum[i+1] += offset;
+	}
+
+	m_data = data;
+	m_size = len;
+	m_dbm = dbm;
+	m_valid = true;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Range queries
+
+/**
+	@brief Sum of samples first...last, inclusive
+
+	Update() must have been called with dbm clear.
+ */
+double CursorRangeSums::GetSum(size_t first, size_t last)
+{
+	return GetRangeSum(first, last);
+}
+
+/**
+	@brief Total power of samples first...last, inclusive, for a waveform in dBm
+
+	Update() must have been called with dbm set.
+ */
+double CursorRangeSums::GetPowerDbm(size_t first, size_t last)
+{
+	return 10 * log10(GetRangeSum(first, last)) + 30;
+}
+
+/**
+	@brief Sum of the (converted) samples first...last, inclusive
+
+	The prefix sums carry rounding error relative to their own magnitude, not the range's. If the difference is small
+	enough to be mostly rounding error, sum the range directly instead.
+ */
+double CursorRangeSums::GetRangeSum(size_t first, size_t last)
+{
+	double hi = m_sum[last+1];
+	double lo = m_sum[first];
+	double sum = hi - lo;
+
+	//Relative size below which the difference can't be trusted.
+	//Prefix sums of a few million doubles are good to roughly 1e-10 of their magnitude, so this leaves plenty of margin.
+	const double tolerance = 1e-6;
+	if(fabs(sum) <= tolerance * max(fabs(hi), fabs(lo)))
+		sum = SumDirect(first, last);
+
+	//Power can't be negative, even after rounding
+	if(m_dbm)
+		sum = max(sum, 0.0);
+	return sum;
+}
+
+/**
+	@brief Sums samples first...last, inclusive, straight from the waveform
+ */
+double CursorRangeSums::SumDirect(size_t first, size_t last)
+{
+	auto udata = dynamic_cast<UniformAnalogWaveform*>(m_data);
+	auto sdata = dynamic_cast<SparseAnalogWaveform*>(m_data);
+	const float* samples = udata ? udata->m_samples.GetCpuPointer() : sdata->m_samples.GetCpuPointer();
+
+	double sum = 0;
+	if(m_dbm)
+	{
+		for(size_t i=first; i<=last; i++)
+			sum += pow(10, (samples[i] - 30) / 10);
+	}
+	else
+	{
+		for(size_t i=first; i<=last; i++)
+			sum += samples[i];
+	}
+	return sum;
+}
@@ -0,0 +1,79 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of CursorRangeSums
+ */
+
+#ifndef CursorRangeSums_h
+#define CursorRangeSums_h
+
+/**
+	@brief Cached prefix sums of a frequency domain waveform, for O(1) in-band power between two cursors
+
+	The sums are rebuilt when the waveform changes, after which any range query is a subtraction. Only one array of
+	sums is kept: either the raw samples or, for dBm waveforms, the samples converted to watts.
+
+	A range that is tiny compared to the sums either side of it (e.g. the noise floor just after a strong carrier)
+	would lose most of its digits to cancellation, so those ranges are summed directly from the samples instead.
+ */
+class CursorRangeSums
+{
+public:
+	CursorRangeSums();
+
+	void Invalidate();
+	bool Update(WaveformBase* data, bool dbm);
+
+	double GetSum(size_t first, size_t last);
+	double GetPowerDbm(size_t first, size_t last);
+
+protected:
+	double GetRangeSum(size_t first, size_t last);
+	double SumDirect(size_t first, size_t last);
+
+	///@brief The waveform the sums were built from
+	WaveformBase* m_data;
+
+	///@brief Number of samples in the waveform when the sums were built
+	size_t m_size;
+
+	///@brief True if the sums are up to date
+	bool m_valid;
+
+	///@brief True if m_sum holds samples converted from dBm to watts
+	bool m_dbm;
+
+	///@brief m_sum[i] is the sum of samples 0...i-1
+	std::vector<double> m_sum;
+};
+
+#endif
@@ -941,6 +941,7 @@ void FilterDialog::OnInputChanged()
 	m_inputChanging = false;
 
 	m_parent->RefreshAllFilters();
+	m_parent->RefreshAllMeasurements();
 	m_parent->ClearAllPersistence();
 }
 
@@ -1118,6 +1119,7 @@ void FilterDialog::OnParameterChanged()
 
 	//Re-run the filter graph
 	m_parent->RefreshAllFilters();
+	m_parent->RefreshAllMeasurements();
 
 	//Did the number of output streams change since the filter was created?
 	int streamcount = m_filter->GetStreamCount();
@@ -38,29 +38,146 @@
 
 using namespace std;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FilterProfileColumns
+
+FilterProfileColumns::FilterProfileColumns()
+{
+	add(m_name);
+	add(m_time);
+	add(m_share);
+	add(m_path);
+	add(m_outputSize);
+	add(m_critical);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 FilterGraphEditor::FilterGraphEditor(OscilloscopeWindow* parent)
 	: m_parent(parent)
 	, m_editor(this)
+	, m_profileRevision(0)
 {
 	set_title("Filter Graph Editor");
 	set_size_request(320, 240);
 
-	add(m_scroller);
-		m_scroller.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
-		m_scroller.add(m_editor);
+	add(m_vbox);
+		m_vbox.pack_start(m_profileButton, Gtk::PACK_SHRINK);
+			m_profileButton.set_label("Profile filter execution (runs filters one at a time)");
+			m_profileButton.signal_toggled().connect(sigc::mem_fun(*this, &FilterGraphEditor::OnProfileToggled));
+		m_vbox.pack_start(m_profileSummary, Gtk::PACK_SHRINK);
+			m_profileSummary.set_halign(Gtk::ALIGN_START);
+		m_vbox.pack_start(m_panes, Gtk::PACK_EXPAND_WIDGET);
+			m_panes.pack1(m_scroller, true, true);
+				m_scroller.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+				m_scroller.add(m_editor);
+			m_panes.pack2(m_profileScroller, false, true);
+				m_profileScroller.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+				m_profileScroller.set_size_request(-1, 150);
+				m_profileScroller.add(m_profileTree);
+
+	m_profileModel = Gtk::ListStore::create(m_profileColumns);
+	m_profileTree.set_model(m_profileModel);
+	m_profileTree.append_column("Filter", m_profileColumns.m_name);
+	m_profileTree.append_column_numeric("Time (ms)", m_profileColumns.m_time, "%.3f");
+	m_profileTree.append_column_numeric("Share (%)", m_profileColumns.m_share, "%.1f");
+	m_profileTree.append_column("Path", m_profileColumns.m_path);
+	m_profileTree.append_column_numeric("Output (MB)", m_profileColumns.m_outputSize, "%.2f");
+	m_profileTree.append_column("Critical", m_profileColumns.m_critical);
+
+	//Click a header to sort by that column
+	m_profileTree.get_column(0)->set_sort_column(m_profileColumns.m_name);
+	m_profileTree.get_column(1)->set_sort_column(m_profileColumns.m_time);
+	m_profileTree.get_column(2)->set_sort_column(m_profileColumns.m_share);
+	m_profileTree.get_column(3)->set_sort_column(m_profileColumns.m_path);
+	m_profileTree.get_column(4)->set_sort_column(m_profileColumns.m_outputSize);
+	m_profileTree.get_column(5)->set_sort_column(m_profileColumns.m_critical);
+	m_profileModel->set_sort_column(m_profileColumns.m_time, Gtk::SORT_DESCENDING);
 
 	show_all();
+	m_profileScroller.hide();
+	m_profileSummary.hide();
 }
 
 FilterGraphEditor::~FilterGraphEditor()
 {
+	m_profileTimer.disconnect();
+	m_parent->GetFilterProfiler().SetEnabled(false);
+}
+
+void FilterGraphEditor::on_hide()
+{
+	//Don't keep serializing the filter graph if nobody is looking at the results
+	m_profileButton.set_active(false);
 
+	Gtk::Window::on_hide();
 }
 
 void FilterGraphEditor::Refresh()
 {
 	m_editor.Refresh();
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Profiling
+
+void FilterGraphEditor::OnProfileToggled()
+{
+	bool enabled = m_profileButton.get_active();
+	m_parent->GetFilterProfiler().SetEnabled(enabled);
+
+	if(enabled)
+	{
+		m_profileScroller.show();
+		m_profileSummary.show();
+		m_profileSummary.set_text("Waiting for next waveform...");
+		m_profileTimer = Glib::signal_timeout().connect(
+			sigc::mem_fun(*this, &FilterGraphEditor::OnProfileTimer), 500);
+	}
+	else
+	{
+		m_profileTimer.disconnect();
+		m_profileScroller.hide();
+		m_profileSummary.hide();
+		m_profileModel->clear();
+		m_editor.ClearProfile();
+	}
+}
+
+bool FilterGraphEditor::OnProfileTimer()
+{
+	auto& profiler = m_parent->GetFilterProfiler();
+	if(profiler.GetRevision() == m_profileRevision)
+		return true;
+
+	map<Filter*, FilterProfileEntry> profile;
+	double total;
+	double critical;
+	m_profileRevision = profiler.GetProfile(profile, total, critical);
+
+	double maxTime = 0;
+	for(auto& it : profile)
+		maxTime = max(maxTime, it.second.m_time);
+
+	m_profileModel->clear();
+	for(auto& it : profile)
+	{
+		auto& entry = it.second;
+		auto row = *m_profileModel->append();
+		row[m_profileColumns.m_name] = entry.m_name;
+		row[m_profileColumns.m_time] = entry.m_time * 1000;
+		row[m_profileColumns.m_share] = (total > 0) ? (100 * entry.m_time / total) : 0;
+		row[m_profileColumns.m_path] = entry.m_gpu ? "GPU" : "CPU";
+		row[m_profileColumns.m_outputSize] = entry.m_outputBytes / (1024.0 * 1024.0);
+		row[m_profileColumns.m_critical] = entry.m_critical;
+	}
+
+	char tmp[128];
+	snprintf(tmp, sizeof(tmp), "%zu filters, %.2f ms total, %.2f ms critical path",
+		profile.size(), total * 1000, critical * 1000);
+	m_profileSummary.set_text(tmp);
+
+	m_editor.SetProfile(profile, maxTime);
+	return true;
+}
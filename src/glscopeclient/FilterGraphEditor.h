@@ -38,6 +38,19 @@
 
 #include "FilterGraphEditorWidget.h"
 
+class FilterProfileColumns : public Gtk::TreeModel::ColumnRecord
+{
+public:
+	FilterProfileColumns();
+
+	Gtk::TreeModelColumn<Glib::ustring>		m_name;
+	Gtk::TreeModelColumn<double>			m_time;
+	Gtk::TreeModelColumn<double>			m_share;
+	Gtk::TreeModelColumn<Glib::ustring>		m_path;
+	Gtk::TreeModelColumn<double>			m_outputSize;
+	Gtk::TreeModelColumn<bool>				m_critical;
+};
+
 /**
 	@brief Editor for a filter graph
  */
@@ -53,10 +66,26 @@ public:
 	{ return m_parent; }
 
 protected:
+	virtual void on_hide();
+
+	void OnProfileToggled();
+	bool OnProfileTimer();
+
 	OscilloscopeWindow* m_parent;
 
-	Gtk::ScrolledWindow m_scroller;
-		FilterGraphEditorWidget m_editor;
+	Gtk::VBox m_vbox;
+		Gtk::CheckButton m_profileButton;
+		Gtk::Label m_profileSummary;
+		Gtk::VPaned m_panes;
+			Gtk::ScrolledWindow m_scroller;
+				FilterGraphEditorWidget m_editor;
+			Gtk::ScrolledWindow m_profileScroller;
+				Gtk::TreeView m_profileTree;
+				Glib::RefPtr<Gtk::ListStore> m_profileModel;
+				FilterProfileColumns m_profileColumns;
+
+	sigc::connection m_profileTimer;
+	uint64_t m_profileRevision;
 };
 
 #endif
@@ -402,6 +402,12 @@ void FilterGraphEditorNode::Render(const Cairo::RefPtr<Cairo::Context>& cr)
 	if(this == m_parent->GetSelectedNode() )
 		outline_color = line_highlight_color;
 
+	//Execution profile, if we have one: tint the box by cost and call out the critical path
+	auto profile = m_parent->GetProfile(m_node);
+	double heat = 0;
+	if(profile && (m_parent->GetProfileMaxTime() > 0) )
+		heat = profile->m_time / m_parent->GetProfileMaxTime();
+
 	//This is a bit messy... but there's no other good way to figure out what type of input a port wants!
 	OscilloscopeChannel dummy_analog(
 		NULL, "", "", Unit(Unit::UNIT_FS), Unit(Unit::UNIT_VOLTS), Stream::STREAM_TYPE_ANALOG);
@@ -412,8 +418,12 @@ void FilterGraphEditorNode::Render(const Cairo::RefPtr<Cairo::Context>& cr)
 		cr->translate(m_rect.get_left(), m_rect.get_top());
 		cr->set_line_width(2);
 
-		//Box background
-		cr->set_source_rgba(fill_color.get_red_p(), fill_color.get_green_p(), fill_color.get_blue_p(), 1);
+		//Box background (blended towards red for expensive filters)
+		cr->set_source_rgba(
+			fill_color.get_red_p()*(1 - 0.6*heat) + 0.6*heat,
+			fill_color.get_green_p()*(1 - 0.6*heat),
+			fill_color.get_blue_p()*(1 - 0.6*heat),
+			1);
 		cr->move_to(0,					0);
 		cr->line_to(m_rect.get_width(),	0);
 		cr->line_to(m_rect.get_width(),	m_rect.get_height());
@@ -432,12 +442,39 @@ void FilterGraphEditorNode::Render(const Cairo::RefPtr<Cairo::Context>& cr)
 
 		//Box outline
 		cr->set_source_rgba(outline_color.get_red_p(), outline_color.get_green_p(), outline_color.get_blue_p(), 1);
+		if(profile && profile->m_critical && (this != m_parent->GetSelectedNode()) )
+		{
+			cr->set_source_rgba(1, 0.5, 0, 1);
+			cr->set_line_width(4);
+		}
 		cr->move_to(0,					0);
 		cr->line_to(m_rect.get_width(),	0);
 		cr->line_to(m_rect.get_width(),	m_rect.get_height());
 		cr->line_to(0, 					m_rect.get_height());
 		cr->line_to(0, 					0);
 		cr->stroke();
+		cr->set_line_width(2);
+
+		//Profile summary below the box
+		if(profile)
+		{
+			char tmp[128];
+			snprintf(tmp, sizeof(tmp), "%.2f ms %s %.1f MB",
+				profile->m_time * 1000,
+				profile->m_gpu ? "GPU" : "CPU",
+				profile->m_outputBytes / (1024.0 * 1024.0));
+
+			auto layout = Pango::Layout::create(m_parent->get_pango_context());
+			layout->set_font_description(m_parent->GetPreferences().GetFont("Appearance.Filter Graph.param_font"));
+			layout->set_text(tmp);
+
+			cr->set_source_rgba(text_color.get_red_p(), text_color.get_green_p(), text_color.get_blue_p(), 1);
+			cr->save();
+				cr->move_to(0, m_rect.get_height() + 2);
+				layout->update_from_cairo_context(cr);
+				layout->show_in_cairo_context(cr);
+			cr->restore();
+		}
 
 		//Draw input ports
 		for(size_t i=0; i<m_inputPorts.size(); i++)
@@ -583,6 +620,7 @@ FilterGraphEditorWidget::FilterGraphEditorWidget(FilterGraphEditor* parent)
 	, m_dragDeltaY(0)
 	, m_sourcePort(0)
 	, m_routingColumnWidth(100)
+	, m_profileMaxTime(0)
 {
 	add_events(Gdk::BUTTON_PRESS_MASK | Gdk::BUTTON_RELEASE_MASK | Gdk::POINTER_MOTION_MASK);
 
@@ -617,6 +655,37 @@ PreferenceManager& FilterGraphEditorWidget::GetPreferences()
 	return m_parent->GetParent()->GetPreferences();
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Profiling
+
+void FilterGraphEditorWidget::SetProfile(const map<Filter*, FilterProfileEntry>& profile, double maxTime)
+{
+	m_profile = profile;
+	m_profileMaxTime = maxTime;
+	queue_draw();
+}
+
+void FilterGraphEditorWidget::ClearProfile()
+{
+	m_profile.clear();
+	m_profileMaxTime = 0;
+	queue_draw();
+}
+
+/**
+	@brief Gets the profile entry for a node, or NULL if it wasn't profiled (not a filter, or profiling is off)
+ */
+const FilterProfileEntry* FilterGraphEditorWidget::GetProfile(FlowGraphNode* node)
+{
+	auto f = dynamic_cast<Filter*>(node);
+	if(!f)
+		return NULL;
+	auto it = m_profile.find(f);
+	if(it == m_profile.end())
+		return NULL;
+	return &it->second;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Top level updating
 
@@ -1293,6 +1362,16 @@ bool FilterGraphEditorWidget::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
 		else
 			cr->set_source_rgba(linecolor.get_red_p(), linecolor.get_green_p(), linecolor.get_blue_p(), 1);
 
+		//Highlight the edges making up the critical path
+		auto toprof = GetProfile(path->m_toNode->m_node);
+		if(toprof && toprof->m_critical && (toprof->m_criticalInput == path->m_fromNode->m_node) )
+		{
+			cr->set_source_rgba(1, 0.5, 0, 1);
+			cr->set_line_width(3);
+		}
+		else
+			cr->set_line_width(2);
+
 		//Draw the lines
 		cr->move_to(path->m_polyline[0].x, path->m_polyline[0].y);
 		for(size_t i=1; i<path->m_polyline.size(); i++)
@@ -1309,6 +1388,7 @@ bool FilterGraphEditorWidget::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
 		}
 		*/
 	}
+	cr->set_line_width(2);
 
 	//Draw the in-progress net
 	if(m_dragMode == DRAG_NET_SOURCE)
@@ -1383,6 +1463,7 @@ void FilterGraphEditorWidget::OnLeftClick(GdkEventButton* event)
 							f->UseDefaultName(true);
 
 						m_parent->GetParent()->RefreshAllFilters();
+						m_parent->GetParent()->RefreshAllMeasurements();
 						m_parent->GetParent()->RefreshAllViews();
 					}
 
@@ -36,6 +36,8 @@
 #ifndef FilterGraphEditorWidget_h
 #define FilterGraphEditorWidget_h
 
+#include "FilterGraphProfiler.h"
+
 class FilterGraphEditor;
 class FilterGraphEditorWidget;
 class ChannelPropertiesDialog;
@@ -159,6 +161,13 @@ public:
 	vec2f GetMousePosition()
 	{ return m_mousePosition; }
 
+	void SetProfile(const std::map<Filter*, FilterProfileEntry>& profile, double maxTime);
+	void ClearProfile();
+	const FilterProfileEntry* GetProfile(FlowGraphNode* node);
+
+	double GetProfileMaxTime()
+	{ return m_profileMaxTime; }
+
 protected:
 
 	//Event handlers
@@ -225,6 +234,10 @@ protected:
 
 	//Column spacing
 	int m_routingColumnWidth;
+
+	//Most recent execution profile (empty if not profiling)
+	std::map<Filter*, FilterProfileEntry> m_profile;
+	double m_profileMaxTime;
 };
 
 #endif
@@ -0,0 +1,229 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FilterGraphProfiler
+ */
+#include "../scopehal/scopehal.h"
+#include "../scopehal/Filter.h"
+#include "FilterGraphProfiler.h"
+#include "Tracer.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+FilterGraphProfiler::FilterGraphProfiler()
+	: m_enabled(false)
+	, m_revision(0)
+	, m_totalTime(0)
+	, m_criticalTime(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Profiling
+
+/**
+	@brief Refreshes the given filters one at a time in dependency order, timing each
+
+	Must be called with the waveform data mutex held, same as FilterGraphExecutor::RunBlocking().
+ */
+void FilterGraphProfiler::Run(FilterGraphExecutor& executor, const set<Filter*>& filters)
+{
+	map<Filter*, FilterProfileEntry> profile;
+
+	//Repeatedly pick any filter with no pending inputs (simple topological sort)
+	set<Filter*> pending = filters;
+	double total = 0;
+	while(!pending.empty())
+	{
+		bool progress = false;
+		for(auto it = pending.begin(); it != pending.end(); )
+		{
+			auto f = *it;
+
+			bool ready = true;
+			for(size_t i=0; i<f->GetInputCount(); i++)
+			{
+				auto in = dynamic_cast<Filter*>(f->GetInput(i).m_channel);
+				if(in && (pending.find(in) != pending.end()) )
+				{
+					ready = false;
+					break;
+				}
+			}
+			if(!ready)
+			{
+				it++;
+				continue;
+			}
+
+			//Run just this one filter. Everything upstream is already up to date.
+			set<Filter*> single;
+			single.emplace(f);
+			string spanName = f->GetDisplayName();
+			TraceSpan span(spanName.c_str());
+			double start = GetTime();
+			executor.RunBlocking(single);
+			double dt = GetTime() - start;
+			span.End();
+			total += dt;
+
+			FilterProfileEntry entry;
+			entry.m_name = f->GetDisplayName();
+			entry.m_time = dt;
+			entry.m_gpu = IsOutputOnGpu(f);
+			entry.m_outputBytes = GetOutputBytes(f);
+			entry.m_critical = false;
+			entry.m_criticalInput = nullptr;
+
+			//Upstream filters were processed first, so their finish times are known
+			double inputFinish = 0;
+			for(size_t i=0; i<f->GetInputCount(); i++)
+			{
+				auto in = dynamic_cast<Filter*>(f->GetInput(i).m_channel);
+				if(in && (profile.find(in) != profile.end()) )
+					inputFinish = max(inputFinish, profile[in].m_finishTime);
+			}
+			entry.m_finishTime = inputFinish + dt;
+			profile[f] = entry;
+
+			it = pending.erase(it);
+			progress = true;
+		}
+
+		//Cycle (shouldn't happen). Just run everything left the normal way.
+		if(!progress)
+		{
+			LogWarning("FilterGraphProfiler: dependency cycle, not profiling remaining filters\n");
+			executor.RunBlocking(pending);
+			break;
+		}
+	}
+
+	//Walk back from the filter that finished last to mark the critical path
+	Filter* last = nullptr;
+	double critical = 0;
+	for(auto& it : profile)
+	{
+		if(it.second.m_finishTime > critical)
+		{
+			critical = it.second.m_finishTime;
+			last = it.first;
+		}
+	}
+	while(last)
+	{
+		auto& entry = profile[last];
+		entry.m_critical = true;
+
+		Filter* next = nullptr;
+		double nextFinish = -1;
+		for(size_t i=0; i<last->GetInputCount(); i++)
+		{
+			auto in = dynamic_cast<Filter*>(last->GetInput(i).m_channel);
+			if(in && (profile.find(in) != profile.end()) && (profile[in].m_finishTime > nextFinish) )
+			{
+				nextFinish = profile[in].m_finishTime;
+				next = in;
+			}
+		}
+		entry.m_criticalInput = next;
+		last = next;
+	}
+
+	lock_guard<mutex> lock(m_mutex);
+	m_profile = profile;
+	m_totalTime = total;
+	m_criticalTime = critical;
+	m_revision ++;
+}
+
+/**
+	@brief Gets a copy of the most recent profile
+
+	@return Revision number of the profile
+ */
+uint64_t FilterGraphProfiler::GetProfile(map<Filter*, FilterProfileEntry>& profile, double& totalTime, double& criticalTime)
+{
+	lock_guard<mutex> lock(m_mutex);
+	profile = m_profile;
+	totalTime = m_totalTime;
+	criticalTime = m_criticalTime;
+	return m_revision;
+}
+
+/**
+	@brief Guesses whether the filter took the GPU path, by looking at where its output samples ended up
+ */
+bool FilterGraphProfiler::IsOutputOnGpu(Filter* f)
+{
+	for(size_t i=0; i<f->GetStreamCount(); i++)
+	{
+		auto data = f->GetData(i);
+		auto ua = dynamic_cast<UniformAnalogWaveform*>(data);
+		auto sa = dynamic_cast<SparseAnalogWaveform*>(data);
+		if(ua && ua->m_samples.IsCpuBufferStale())
+			return true;
+		if(sa && sa->m_samples.IsCpuBufferStale())
+			return true;
+	}
+	return false;
+}
+
+/**
+	@brief Approximate memory used by the filter's output waveforms
+
+	Protocol waveforms have opaque sample types, so only their timestamps are counted.
+ */
+size_t FilterGraphProfiler::GetOutputBytes(Filter* f)
+{
+	size_t bytes = 0;
+	for(size_t i=0; i<f->GetStreamCount(); i++)
+	{
+		auto data = f->GetData(i);
+		if(!data)
+			continue;
+		size_t len = data->size();
+
+		if( dynamic_cast<UniformAnalogWaveform*>(data) || dynamic_cast<SparseAnalogWaveform*>(data) )
+			bytes += len * sizeof(float);
+		else if( dynamic_cast<UniformDigitalWaveform*>(data) || dynamic_cast<SparseDigitalWaveform*>(data) )
+			bytes += len * sizeof(bool);
+
+		//Offsets and durations
+		if(dynamic_cast<SparseWaveformBase*>(data))
+			bytes += len * 2 * sizeof(int64_t);
+	}
+	return bytes;
+}
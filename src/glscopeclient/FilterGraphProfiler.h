@@ -0,0 +1,103 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FilterGraphProfiler
+ */
+
+#ifndef FilterGraphProfiler_h
+#define FilterGraphProfiler_h
+
+/**
+	@brief Cost of a single filter during the last profiled refresh
+ */
+class FilterProfileEntry
+{
+public:
+	std::string m_name;
+
+	///@brief Wall time of Refresh(), in seconds
+	double m_time;
+
+	///@brief True if the output data was left on the GPU (i.e. the Vulkan path ran)
+	bool m_gpu;
+
+	///@brief Total size of all output waveforms
+	size_t m_outputBytes;
+
+	///@brief Earliest time this filter could finish given unlimited parallelism (own time plus slowest input chain)
+	double m_finishTime;
+
+	///@brief True if this filter is on the longest dependency chain
+	bool m_critical;
+
+	///@brief The input feeding this filter along the critical path (NULL if none)
+	Filter* m_criticalInput;
+};
+
+/**
+	@brief Optionally runs the filter graph one filter at a time to measure per-filter cost
+
+	Profiling gives up the executor's parallelism (each filter is run on its own so it can be timed), so it is only
+	done while explicitly enabled from the filter graph editor.
+ */
+class FilterGraphProfiler
+{
+public:
+	FilterGraphProfiler();
+
+	void SetEnabled(bool enabled)
+	{ m_enabled = enabled; }
+
+	bool IsEnabled()
+	{ return m_enabled; }
+
+	void Run(FilterGraphExecutor& executor, const std::set<Filter*>& filters);
+
+	uint64_t GetRevision()
+	{ return m_revision; }
+
+	uint64_t GetProfile(std::map<Filter*, FilterProfileEntry>& profile, double& totalTime, double& criticalTime);
+
+protected:
+	static bool IsOutputOnGpu(Filter* f);
+	static size_t GetOutputBytes(Filter* f);
+
+	std::atomic<bool> m_enabled;
+	std::atomic<uint64_t> m_revision;
+
+	std::mutex m_mutex;
+	std::map<Filter*, FilterProfileEntry> m_profile;
+	double m_totalTime;
+	double m_criticalTime;
+};
+
+#endif
@@ -0,0 +1,589 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of HaltCondition
+ */
+#include "glscopeclient.h"
+#include "HaltCondition.h"
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+HaltCondition::HaltCondition()
+	: m_op(OP_INVALID)
+	, m_value(0)
+	, m_widthQualifier(WIDTH_ANY)
+	, m_width(0)
+{
+	for(size_t i=0; i<256; i++)
+		m_skipTable[i] = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Compilation
+
+/**
+	@brief Converts the text shown in the operator box to an Operator
+ */
+HaltCondition::Operator HaltCondition::ParseOperator(const string& str)
+{
+	if(str == "<")
+		return OP_LESS;
+	else if(str == "<=")
+		return OP_LESS_OR_EQUAL;
+	else if(str == "==")
+		return OP_EQUAL;
+	else if(str == ">=")
+		return OP_GREATER_OR_EQUAL;
+	else if(str == ">")
+		return OP_GREATER;
+	else if(str == "!=")
+		return OP_NOT_EQUAL;
+	else if(str == "starts with")
+		return OP_STARTS_WITH;
+	else if(str == "contains")
+		return OP_CONTAINS;
+	else
+		return OP_INVALID;
+}
+
+/**
+	@brief Builds the condition from user-supplied settings
+
+	@param stream	The stream to check
+	@param op		Comparison operator
+	@param target	Target value (a number in the stream's Y axis units, or a string for protocol data)
+ */
+void HaltCondition::Compile(StreamDescriptor stream, Operator op, const string& target)
+{
+	m_stream = stream;
+	m_op = op;
+	m_text = target;
+
+	if(stream.m_channel)
+		m_value = stream.GetYAxisUnits().ParseString(target);
+	else
+		m_value = 0;
+
+	//Build the bad character table for substring searches
+	size_t tlen = m_text.length();
+	for(size_t i=0; i<256; i++)
+		m_skipTable[i] = tlen;
+	for(size_t i=0; i+1 < tlen; i++)
+		m_skipTable[static_cast<uint8_t>(m_text[i])] = tlen - 1 - i;
+}
+
+/**
+	@brief Restricts matches to runs of matching samples wider or narrower than a limit
+
+	@param qual		The qualifier
+	@param width	Width limit, in fs
+ */
+void HaltCondition::SetWidthQualifier(WidthQualifier qual, int64_t width)
+{
+	m_widthQualifier = qual;
+	m_width = width;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Evaluation
+
+/**
+	@brief Checks if this condition can be applied to a waveform at all
+ */
+bool HaltCondition::CanScan(WaveformBase* data) const
+{
+	if(!IsValid() || !data || data->empty())
+		return false;
+
+	//Numeric comparisons on analog data
+	bool analog = (dynamic_cast<UniformAnalogWaveform*>(data) != nullptr) ||
+		(dynamic_cast<SparseAnalogWaveform*>(data) != nullptr);
+	if(analog && IsNumericOperator())
+		return true;
+
+	//Text matching for protocol data
+	//TODO: match digital data
+	if( (m_op == OP_EQUAL) || (m_op == OP_NOT_EQUAL) || (m_op == OP_STARTS_WITH) || (m_op == OP_CONTAINS) )
+		return true;
+
+	//Ordering comparisons are meaningless for anything else
+	return false;
+}
+
+void HaltCondition::BeginScan(ScanState& state) const
+{
+	state.m_inRun = false;
+	state.m_runStart = 0;
+}
+
+/**
+	@brief Scans a block of samples, continuing from the state left by the previous block
+
+	Matching is done in terms of runs of consecutive matching samples, so that width qualifiers can be applied and so
+	a long run only produces a single match. Runs are only reported once they end (or the waveform does), so that the
+	match covers the whole run and compound conditions can test it for overlap with other streams.
+
+	@param data			The waveform being scanned (must have been checked with CanScan())
+	@param start		Index of the first sample in the block
+	@param end			Index one past the last sample in the block
+	@param state		Scan state
+	@param matches		Matches found are appended here
+	@param maxMatches	Stop scanning once this many matches have been found
+ */
+void HaltCondition::ScanBlock(
+	WaveformBase* data,
+	size_t start,
+	size_t end,
+	ScanState& state,
+	vector<Match>& matches,
+	size_t maxMatches) const
+{
+	size_t i = start;
+	while( (i < end) && (matches.size() < maxMatches) )
+	{
+		size_t edge = FindNextEdge(data, i, end, state.m_inRun);
+		if(edge == NO_MATCH)
+			break;
+
+		//Start of a new run
+		if(!state.m_inRun)
+		{
+			state.m_inRun = true;
+			state.m_runStart = edge;
+		}
+
+		//End of the current run
+		else
+		{
+			state.m_inRun = false;
+			CloseRun(data, state.m_runStart, edge - 1, matches);
+		}
+
+		i = edge;
+	}
+}
+
+/**
+	@brief Finishes a scan, closing any run still open at the end of the waveform
+ */
+void HaltCondition::EndScan(WaveformBase* data, ScanState& state, vector<Match>& matches) const
+{
+	if(state.m_inRun)
+		CloseRun(data, state.m_runStart, data->size() - 1, matches);
+	state.m_inRun = false;
+}
+
+/**
+	@brief Finds the next sample at or after start which begins (or ends, if inRun is set) a run of matches
+ */
+size_t HaltCondition::FindNextEdge(WaveformBase* data, size_t start, size_t end, bool inRun) const
+{
+	auto uadata = dynamic_cast<UniformAnalogWaveform*>(data);
+	auto sadata = dynamic_cast<SparseAnalogWaveform*>(data);
+
+	//Numeric comparisons on analog data are vectorized scans
+	if( (uadata || sadata) && IsNumericOperator())
+	{
+		const float* samples = uadata ? uadata->m_samples.GetCpuPointer() : sadata->m_samples.GetCpuPointer();
+		size_t hit = FindFirstMatch(samples + start, end - start, m_op, m_value, inRun);
+		if(hit == NO_MATCH)
+			return NO_MATCH;
+		return start + hit;
+	}
+
+	//Match filters
+	for(size_t i=start; i<end; i++)
+	{
+		if(MatchText(data->GetText(i)) != inRun)
+			return i;
+	}
+	return NO_MATCH;
+}
+
+/**
+	@brief Applies the width qualifier to a run of matching samples and records it if it passes
+ */
+void HaltCondition::CloseRun(WaveformBase* data, size_t first, size_t last, vector<Match>& matches) const
+{
+	auto udata = dynamic_cast<UniformWaveformBase*>(data);
+	auto sdata = dynamic_cast<SparseWaveformBase*>(data);
+
+	Match m;
+	m.m_index = first;
+	m.m_offset = GetOffsetScaled(sdata, udata, first);
+	m.m_start = m.m_offset + data->m_triggerPhase;
+	m.m_end = GetOffsetScaled(sdata, udata, last) + GetDurationScaled(sdata, udata, last) + data->m_triggerPhase;
+
+	int64_t width = m.m_end - m.m_start;
+	if( (m_widthQualifier == WIDTH_MORE_THAN) && (width <= m_width) )
+		return;
+	if( (m_widthQualifier == WIDTH_LESS_THAN) && (width >= m_width) )
+		return;
+
+	matches.push_back(m);
+}
+
+bool HaltCondition::MatchText(const string& str) const
+{
+	switch(m_op)
+	{
+		case OP_EQUAL:
+			return str == m_text;
+
+		case OP_NOT_EQUAL:
+			return str != m_text;
+
+		case OP_STARTS_WITH:
+			return str.compare(0, m_text.length(), m_text) == 0;
+
+		case OP_CONTAINS:
+			return Contains(str);
+
+		default:
+			return false;
+	}
+}
+
+/**
+	@brief Boyer-Moore-Horspool substring search using the precompiled skip table
+ */
+bool HaltCondition::Contains(const string& str) const
+{
+	size_t tlen = m_text.length();
+	size_t slen = str.length();
+	if(tlen == 0)
+		return true;
+	if(tlen > slen)
+		return false;
+
+	const char* needle = m_text.c_str();
+	const char* haystack = str.c_str();
+	size_t last = tlen - 1;
+	for(size_t pos = 0; pos + tlen <= slen; )
+	{
+		char c = haystack[pos + last];
+		if( (c == needle[last]) && (memcmp(haystack + pos, needle, last) == 0) )
+			return true;
+
+		pos += m_skipTable[static_cast<uint8_t>(c)];
+	}
+
+	return false;
+}
+
+/**
+	@brief Finds the index of the first sample in a buffer which satisfies a numeric comparison
+
+	NaN samples never satisfy any comparison, so when looking for a mismatch they end the run.
+
+	@param mismatch		If set, find the first sample which does *not* satisfy the comparison instead
+
+	@return Index of the first match, or NO_MATCH if nothing matched
+ */
+size_t HaltCondition::FindFirstMatch(const float* samples, size_t len, Operator op, float value, bool mismatch)
+{
+	#ifdef __x86_64__
+	if(g_hasAvx512F)
+		return FindFirstMatchAVX512F(samples, len, op, value, mismatch);
+	else if(g_hasAvx2)
+		return FindFirstMatchAVX2(samples, len, op, value, mismatch);
+	#endif
+
+	return FindFirstMatchGeneric(samples, len, op, value, mismatch);
+}
+
+size_t HaltCondition::FindFirstMatchGeneric(const float* samples, size_t len, Operator op, float value, bool mismatch)
+{
+	//Keep the switch outside the loop so each loop body is a single compare.
+	//All comparisons are false for NaN, so a NaN sample is never a match and always a mismatch.
+	switch(op)
+	{
+		case OP_LESS:
+			for(size_t i=0; i<len; i++)
+			{
+				if((samples[i] < value) != mismatch)
+					return i;
+			}
+			break;
+
+		case OP_LESS_OR_EQUAL:
+			for(size_t i=0; i<len; i++)
+			{
+				if((samples[i] <= value) != mismatch)
+					return i;
+			}
+			break;
+
+		case OP_EQUAL:
+			for(size_t i=0; i<len; i++)
+			{
+				if((samples[i] == value) != mismatch)
+					return i;
+			}
+			break;
+
+		case OP_GREATER_OR_EQUAL:
+			for(size_t i=0; i<len; i++)
+			{
+				if((samples[i] >= value) != mismatch)
+					return i;
+			}
+			break;
+
+		case OP_GREATER:
+			for(size_t i=0; i<len; i++)
+			{
+				if((samples[i] > value) != mismatch)
+					return i;
+			}
+			break;
+
+		case OP_NOT_EQUAL:
+			for(size_t i=0; i<len; i++)
+			{
+				if( ((samples[i] < value) || (samples[i] > value)) != mismatch)
+					return i;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	return NO_MATCH;
+}
+
+#ifdef __x86_64__
+
+/**
+	@brief AVX2 scan for a single comparison predicate (must be a compile time constant for vcmpps)
+
+	Four vectors are compared per iteration and the masks ORed together so the common no-match case only needs one
+	branch per 32 samples.
+ */
+template<int cmp>
+__attribute__((target("avx2")))
+static size_t FindFirstMatchAVX2Inner(const float* samples, size_t len, float value)
+{
+	size_t end = len - (len % 32);
+
+	__m256 vtarget = _mm256_set1_ps(value);
+	for(size_t i=0; i<end; i += 32)
+	{
+		__m256 a = _mm256_cmp_ps(_mm256_loadu_ps(samples + i), vtarget, cmp);
+		__m256 b = _mm256_cmp_ps(_mm256_loadu_ps(samples + i + 8), vtarget, cmp);
+		__m256 c = _mm256_cmp_ps(_mm256_loadu_ps(samples + i + 16), vtarget, cmp);
+		__m256 d = _mm256_cmp_ps(_mm256_loadu_ps(samples + i + 24), vtarget, cmp);
+
+		__m256 any = _mm256_or_ps(_mm256_or_ps(a, b), _mm256_or_ps(c, d));
+		if(!_mm256_movemask_ps(any))
+			continue;
+
+		//Something in this block matched, figure out which one
+		uint32_t mask =
+			(static_cast<uint32_t>(_mm256_movemask_ps(a)) << 0) |
+			(static_cast<uint32_t>(_mm256_movemask_ps(b)) << 8) |
+			(static_cast<uint32_t>(_mm256_movemask_ps(c)) << 16) |
+			(static_cast<uint32_t>(_mm256_movemask_ps(d)) << 24);
+		return i + __builtin_ctz(mask);
+	}
+
+	return end;
+}
+
+/*
+	Predicates for each operator. Matches use ordered compares (false for NaN), mismatches use the negated unordered
+	compares (true for NaN), so NaN is always treated as not matching.
+ */
+
+__attribute__((target("avx2")))
+size_t HaltCondition::FindFirstMatchAVX2(const float* samples, size_t len, Operator op, float value, bool mismatch)
+{
+	size_t end = len - (len % 32);
+	size_t hit;
+	switch(op)
+	{
+		case OP_LESS:
+			if(mismatch)
+				hit = FindFirstMatchAVX2Inner<_CMP_NLT_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX2Inner<_CMP_LT_OQ>(samples, len, value);
+			break;
+
+		case OP_LESS_OR_EQUAL:
+			if(mismatch)
+				hit = FindFirstMatchAVX2Inner<_CMP_NLE_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX2Inner<_CMP_LE_OQ>(samples, len, value);
+			break;
+
+		case OP_EQUAL:
+			if(mismatch)
+				hit = FindFirstMatchAVX2Inner<_CMP_NEQ_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX2Inner<_CMP_EQ_OQ>(samples, len, value);
+			break;
+
+		case OP_GREATER_OR_EQUAL:
+			if(mismatch)
+				hit = FindFirstMatchAVX2Inner<_CMP_NGE_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX2Inner<_CMP_GE_OQ>(samples, len, value);
+			break;
+
+		case OP_GREATER:
+			if(mismatch)
+				hit = FindFirstMatchAVX2Inner<_CMP_NGT_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX2Inner<_CMP_GT_OQ>(samples, len, value);
+			break;
+
+		case OP_NOT_EQUAL:
+			if(mismatch)
+				hit = FindFirstMatchAVX2Inner<_CMP_EQ_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX2Inner<_CMP_NEQ_OQ>(samples, len, value);
+			break;
+
+		default:
+			return NO_MATCH;
+	}
+
+	if(hit < end)
+		return hit;
+
+	//Scalar cleanup for the last few samples
+	hit = FindFirstMatchGeneric(samples + end, len - end, op, value, mismatch);
+	if(hit == NO_MATCH)
+		return NO_MATCH;
+	return end + hit;
+}
+
+/**
+	@brief AVX512F scan for a single comparison predicate
+ */
+template<int cmp>
+__attribute__((target("avx512f")))
+static size_t FindFirstMatchAVX512FInner(const float* samples, size_t len, float value)
+{
+	size_t end = len - (len % 64);
+
+	__m512 vtarget = _mm512_set1_ps(value);
+	for(size_t i=0; i<end; i += 64)
+	{
+		__mmask16 a = _mm512_cmp_ps_mask(_mm512_loadu_ps(samples + i), vtarget, cmp);
+		__mmask16 b = _mm512_cmp_ps_mask(_mm512_loadu_ps(samples + i + 16), vtarget, cmp);
+		__mmask16 c = _mm512_cmp_ps_mask(_mm512_loadu_ps(samples + i + 32), vtarget, cmp);
+		__mmask16 d = _mm512_cmp_ps_mask(_mm512_loadu_ps(samples + i + 48), vtarget, cmp);
+
+		uint64_t mask =
+			(static_cast<uint64_t>(a) << 0) |
+			(static_cast<uint64_t>(b) << 16) |
+			(static_cast<uint64_t>(c) << 32) |
+			(static_cast<uint64_t>(d) << 48);
+		if(mask)
+			return i + __builtin_ctzll(mask);
+	}
+
+	return end;
+}
+
+__attribute__((target("avx512f")))
+size_t HaltCondition::FindFirstMatchAVX512F(const float* samples, size_t len, Operator op, float value, bool mismatch)
+{
+	size_t end = len - (len % 64);
+	size_t hit;
+	switch(op)
+	{
+		case OP_LESS:
+			if(mismatch)
+				hit = FindFirstMatchAVX512FInner<_CMP_NLT_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX512FInner<_CMP_LT_OQ>(samples, len, value);
+			break;
+
+		case OP_LESS_OR_EQUAL:
+			if(mismatch)
+				hit = FindFirstMatchAVX512FInner<_CMP_NLE_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX512FInner<_CMP_LE_OQ>(samples, len, value);
+			break;
+
+		case OP_EQUAL:
+			if(mismatch)
+				hit = FindFirstMatchAVX512FInner<_CMP_NEQ_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX512FInner<_CMP_EQ_OQ>(samples, len, value);
+			break;
+
+		case OP_GREATER_OR_EQUAL:
+			if(mismatch)
+				hit = FindFirstMatchAVX512FInner<_CMP_NGE_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX512FInner<_CMP_GE_OQ>(samples, len, value);
+			break;
+
+		case OP_GREATER:
+			if(mismatch)
+				hit = FindFirstMatchAVX512FInner<_CMP_NGT_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX512FInner<_CMP_GT_OQ>(samples, len, value);
+			break;
+
+		case OP_NOT_EQUAL:
+			if(mismatch)
+				hit = FindFirstMatchAVX512FInner<_CMP_EQ_UQ>(samples, len, value);
+			else
+				hit = FindFirstMatchAVX512FInner<_CMP_NEQ_OQ>(samples, len, value);
+			break;
+
+		default:
+			return NO_MATCH;
+	}
+
+	if(hit < end)
+		return hit;
+
+	//Scalar cleanup for the last few samples
+	hit = FindFirstMatchGeneric(samples + end, len - end, op, value, mismatch);
+	if(hit == NO_MATCH)
+		return NO_MATCH;
+	return end + hit;
+}
+
+#endif /* __x86_64__ */
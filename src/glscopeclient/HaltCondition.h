@@ -0,0 +1,162 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of HaltCondition
+ */
+
+#ifndef HaltCondition_h
+#define HaltCondition_h
+
+/**
+	@brief A compiled halt condition
+
+	The condition is built once from the dialog settings (whenever they change) so that checking it on every trigger
+	does not need to touch any widgets or re-parse the target value.
+ */
+class HaltCondition
+{
+public:
+	HaltCondition();
+
+	enum Operator
+	{
+		OP_LESS,
+		OP_LESS_OR_EQUAL,
+		OP_EQUAL,
+		OP_GREATER_OR_EQUAL,
+		OP_GREATER,
+		OP_NOT_EQUAL,
+		OP_STARTS_WITH,
+		OP_CONTAINS,
+
+		OP_INVALID
+	};
+
+	enum WidthQualifier
+	{
+		WIDTH_ANY,
+		WIDTH_MORE_THAN,
+		WIDTH_LESS_THAN
+	};
+
+	static Operator ParseOperator(const std::string& str);
+
+	void Compile(StreamDescriptor stream, Operator op, const std::string& target);
+	void SetWidthQualifier(WidthQualifier qual, int64_t width);
+
+	bool IsValid() const
+	{ return (m_stream.m_channel != nullptr) && (m_op != OP_INVALID); }
+
+	StreamDescriptor GetStream() const
+	{ return m_stream; }
+
+	/**
+		@brief A run of consecutive samples satisfying the condition
+	 */
+	struct Match
+	{
+		///@brief Index of the first sample in the run
+		size_t m_index;
+
+		///@brief Offset of the first sample from the start of the waveform (the halt timestamp)
+		int64_t m_offset;
+
+		///@brief Start and end of the run, including trigger phase, for comparing across streams
+		int64_t m_start;
+		int64_t m_end;
+	};
+
+	/**
+		@brief Scan state carried from one block of samples to the next
+	 */
+	struct ScanState
+	{
+		bool m_inRun;
+		size_t m_runStart;
+	};
+
+	bool CanScan(WaveformBase* data) const;
+	void BeginScan(ScanState& state) const;
+	void ScanBlock(
+		WaveformBase* data,
+		size_t start,
+		size_t end,
+		ScanState& state,
+		std::vector<Match>& matches,
+		size_t maxMatches) const;
+	void EndScan(WaveformBase* data, ScanState& state, std::vector<Match>& matches) const;
+
+	static size_t FindFirstMatch(const float* samples, size_t len, Operator op, float value, bool mismatch = false);
+
+	/**
+		@brief Sentinel returned by FindFirstMatch() when no sample matches
+	 */
+	static const size_t NO_MATCH = SIZE_MAX;
+
+protected:
+	bool IsNumericOperator() const
+	{ return m_op <= OP_NOT_EQUAL; }
+
+	size_t FindNextEdge(WaveformBase* data, size_t start, size_t end, bool inRun) const;
+	void CloseRun(WaveformBase* data, size_t first, size_t last, std::vector<Match>& matches) const;
+	bool MatchText(const std::string& str) const;
+	bool Contains(const std::string& str) const;
+
+	static size_t FindFirstMatchGeneric(const float* samples, size_t len, Operator op, float value, bool mismatch);
+#ifdef __x86_64__
+	static size_t FindFirstMatchAVX2(const float* samples, size_t len, Operator op, float value, bool mismatch);
+	static size_t FindFirstMatchAVX512F(const float* samples, size_t len, Operator op, float value, bool mismatch);
+#endif
+
+	///@brief The stream being checked
+	StreamDescriptor m_stream;
+
+	///@brief The comparison being done
+	Operator m_op;
+
+	///@brief Target value for numeric comparisons, parsed in the stream's Y axis units
+	float m_value;
+
+	///@brief Target string for text comparisons
+	std::string m_text;
+
+	///@brief Boyer-Moore-Horspool bad character skip table for "contains" matching
+	size_t m_skipTable[256];
+
+	///@brief Width qualifier applied to each run of matching samples
+	WidthQualifier m_widthQualifier;
+
+	///@brief Width limit for the qualifier, in fs
+	int64_t m_width;
+};
+
+#endif
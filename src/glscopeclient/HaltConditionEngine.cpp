@@ -0,0 +1,244 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of HaltConditionEngine
+ */
+#include "glscopeclient.h"
+#include "HaltConditionEngine.h"
+
+using namespace std;
+
+//Number of samples scanned by each condition before moving on to the next condition on the same stream.
+//Small enough that the block stays in L2 cache between conditions.
+static const size_t SCAN_BLOCK_SIZE = 65536;
+
+//Upper bound on matches recorded per condition when looking for coincidences, to bound memory on noisy signals
+static const size_t MAX_MATCHES_PER_CONDITION = 100000;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+HaltConditionEngine::HaltConditionEngine()
+	: m_mode(COMBINE_ANY)
+	, m_window(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Configuration
+
+void HaltConditionEngine::Clear()
+{
+	m_conditions.clear();
+	m_streamGroups.clear();
+	m_matches.clear();
+}
+
+/**
+	@brief Adds a condition, ignoring it if it's not fully configured
+ */
+void HaltConditionEngine::AddCondition(const HaltCondition& cond)
+{
+	if(!cond.IsValid())
+		return;
+
+	size_t index = m_conditions.size();
+	m_conditions.push_back(cond);
+	m_matches.resize(m_conditions.size());
+
+	//Add to the group for this stream, or make a new one
+	for(auto& g : m_streamGroups)
+	{
+		if(m_conditions[g[0]].GetStream() == cond.GetStream())
+		{
+			g.push_back(index);
+			return;
+		}
+	}
+	m_streamGroups.push_back(vector<size_t>{index});
+}
+
+/**
+	@brief Sets how the conditions are combined
+
+	@param mode		Combining mode
+	@param window	Coincidence window for COMBINE_ALL, in fs
+ */
+void HaltConditionEngine::SetCombineMode(CombineMode mode, int64_t window)
+{
+	m_mode = mode;
+	m_window = window;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Evaluation
+
+/**
+	@brief Checks the current waveforms against the conditions
+
+	@param timestamp	Set to the offset of the matching sample within its waveform
+	@param stream		Set to the stream the matching sample came from
+
+	@return True if we should halt
+ */
+bool HaltConditionEngine::Evaluate(int64_t& timestamp, StreamDescriptor& stream)
+{
+	if(m_conditions.empty())
+		return false;
+
+	for(auto& m : m_matches)
+		m.clear();
+
+	//Get all of the waveforms into CPU memory before going parallel
+	for(auto& g : m_streamGroups)
+	{
+		auto data = m_conditions[g[0]].GetStream().GetData();
+		if(data)
+			data->PrepareForCpuAccess();
+	}
+
+	//When any match will do, we only need the first one from each condition
+	size_t maxMatches = (m_mode == COMBINE_ANY) ? 1 : MAX_MATCHES_PER_CONDITION;
+
+	#pragma omp parallel for
+	for(size_t i=0; i<m_streamGroups.size(); i++)
+		ScanStream(i, maxMatches);
+
+	//Pick the earliest match of any condition
+	if(m_mode == COMBINE_ANY)
+	{
+		bool found = false;
+		int64_t tbest = 0;
+		for(size_t i=0; i<m_conditions.size(); i++)
+		{
+			if(m_matches[i].empty())
+				continue;
+
+			auto& m = m_matches[i][0];
+			if(!found || (m.m_start < tbest))
+			{
+				found = true;
+				tbest = m.m_start;
+				timestamp = m.m_offset;
+				stream = m_conditions[i].GetStream();
+			}
+		}
+		return found;
+	}
+
+	//Find the first match of the first condition which every other condition matches within the window of.
+	//Matches of a single condition never overlap so both start and end times are sorted, and we can sweep through
+	//every other condition's matches with a single cursor each.
+	vector<size_t> cursors(m_conditions.size(), 0);
+	for(auto& anchor : m_matches[0])
+	{
+		int64_t tmin = anchor.m_start - m_window;
+		int64_t tmax = anchor.m_end + m_window;
+
+		bool hit = true;
+		for(size_t i=1; i<m_conditions.size(); i++)
+		{
+			auto& matches = m_matches[i];
+			auto& c = cursors[i];
+
+			//Skip anything ending before our window starts
+			while( (c < matches.size()) && (matches[c].m_end < tmin) )
+				c++;
+
+			if( (c >= matches.size()) || (matches[c].m_start > tmax) )
+			{
+				hit = false;
+				break;
+			}
+		}
+
+		if(hit)
+		{
+			timestamp = anchor.m_offset;
+			stream = m_conditions[0].GetStream();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+	@brief Runs every condition on a single stream in one blocked pass over the waveform
+ */
+void HaltConditionEngine::ScanStream(size_t group, size_t maxMatches)
+{
+	auto& indexes = m_streamGroups[group];
+	auto data = m_conditions[indexes[0]].GetStream().GetData();
+
+	//Figure out which conditions actually apply to this waveform
+	vector<size_t> active;
+	for(auto i : indexes)
+	{
+		if(m_conditions[i].CanScan(data))
+			active.push_back(i);
+	}
+	if(active.empty())
+		return;
+
+	vector<HaltCondition::ScanState> states(active.size());
+	for(size_t j=0; j<active.size(); j++)
+		m_conditions[active[j]].BeginScan(states[j]);
+
+	size_t len = data->size();
+	for(size_t start=0; start<len; start += SCAN_BLOCK_SIZE)
+	{
+		size_t end = min(start + SCAN_BLOCK_SIZE, len);
+
+		bool done = true;
+		for(size_t j=0; j<active.size(); j++)
+		{
+			auto i = active[j];
+			if(m_matches[i].size() >= maxMatches)
+				continue;
+
+			m_conditions[i].ScanBlock(data, start, end, states[j], m_matches[i], maxMatches);
+			done = false;
+		}
+
+		//Stop early once everything has as many matches as we need
+		if(done)
+			break;
+	}
+
+	for(size_t j=0; j<active.size(); j++)
+	{
+		auto i = active[j];
+		if(m_matches[i].size() < maxMatches)
+			m_conditions[i].EndScan(data, states[j], m_matches[i]);
+	}
+}
@@ -0,0 +1,89 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of HaltConditionEngine
+ */
+
+#ifndef HaltConditionEngine_h
+#define HaltConditionEngine_h
+
+#include "HaltCondition.h"
+
+/**
+	@brief Evaluates a set of halt conditions, possibly on several streams, against the current waveforms
+
+	Conditions on the same stream are evaluated together in a single blocked pass over the waveform, so each block of
+	samples is only pulled into cache once. Streams are evaluated in parallel.
+ */
+class HaltConditionEngine
+{
+public:
+	HaltConditionEngine();
+
+	enum CombineMode
+	{
+		///@brief Halt when any condition matches
+		COMBINE_ANY,
+
+		///@brief Halt when every condition matches within the coincidence window of a match of the first one
+		COMBINE_ALL
+	};
+
+	void Clear();
+	void AddCondition(const HaltCondition& cond);
+	void SetCombineMode(CombineMode mode, int64_t window);
+
+	bool IsEmpty()
+	{ return m_conditions.empty(); }
+
+	bool Evaluate(int64_t& timestamp, StreamDescriptor& stream);
+
+protected:
+	void ScanStream(size_t group, size_t maxMatches);
+
+	///@brief The conditions being checked
+	std::vector<HaltCondition> m_conditions;
+
+	///@brief Indexes of m_conditions, grouped by the stream they look at
+	std::vector< std::vector<size_t> > m_streamGroups;
+
+	///@brief Matches found for each condition during the current evaluation
+	std::vector< std::vector<HaltCondition::Match> > m_matches;
+
+	///@brief How conditions are combined
+	CombineMode m_mode;
+
+	///@brief Coincidence window for COMBINE_ALL, in fs
+	int64_t m_window;
+};
+
+#endif
@@ -38,6 +38,28 @@
 
 using namespace std;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// HaltConditionRow
+
+HaltConditionRow::HaltConditionRow()
+{
+	m_operatorBox.append("<");
+	m_operatorBox.append("<=");
+	m_operatorBox.append("==");
+	m_operatorBox.append(">");
+	m_operatorBox.append(">=");
+	m_operatorBox.append("!=");
+	m_operatorBox.append("starts with");
+	m_operatorBox.append("contains");
+
+	m_widthBox.append("any width");
+	m_widthBox.append("wider than");
+	m_widthBox.append("narrower than");
+	m_widthBox.set_active_text("any width");
+
+	m_removeButton.set_label("Remove");
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -54,24 +76,102 @@ HaltConditionsDialog::HaltConditionsDialog(
 
 		m_grid.attach_next_to(m_channelNameLabel, m_moveToEventButton, Gtk::POS_BOTTOM, 1, 1);
 			m_channelNameLabel.set_label("Halt when");
-		m_grid.attach_next_to(m_channelNameBox, m_channelNameLabel, Gtk::POS_RIGHT, 1, 1);
-		m_grid.attach_next_to(m_operatorBox, m_channelNameBox, Gtk::POS_RIGHT, 1, 1);
-			m_operatorBox.append("<");
-			m_operatorBox.append("<=");
-			m_operatorBox.append("==");
-			m_operatorBox.append(">");
-			m_operatorBox.append(">=");
-			m_operatorBox.append("!=");
-			m_operatorBox.append("starts with");
-			m_operatorBox.append("contains");
-		m_grid.attach_next_to(m_targetEntry, m_operatorBox, Gtk::POS_RIGHT, 1, 1);
+		m_grid.attach_next_to(m_combineBox, m_channelNameLabel, Gtk::POS_RIGHT, 1, 1);
+			m_combineBox.append("any condition matches");
+			m_combineBox.append("all conditions match within");
+			m_combineBox.set_active_text("any condition matches");
+		m_grid.attach_next_to(m_windowEntry, m_combineBox, Gtk::POS_RIGHT, 1, 1);
+			m_windowEntry.set_text("10 ns");
+
+		m_grid.attach_next_to(m_conditionGrid, m_channelNameLabel, Gtk::POS_BOTTOM, 3, 1);
+		m_grid.attach_next_to(m_addButton, m_conditionGrid, Gtk::POS_BOTTOM, 1, 1);
+			m_addButton.set_label("Add Condition");
+
+	m_combineBox.signal_changed().connect(sigc::mem_fun(*this, &HaltConditionsDialog::OnConditionChanged));
+	m_windowEntry.signal_changed().connect(sigc::mem_fun(*this, &HaltConditionsDialog::OnConditionChanged));
+	m_addButton.signal_clicked().connect(sigc::mem_fun(*this, &HaltConditionsDialog::OnAddCondition));
+
+	AddConditionRow();
 
 	show_all();
 }
 
 HaltConditionsDialog::~HaltConditionsDialog()
 {
+	for(auto r : m_rows)
+		delete r;
+	m_rows.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Condition rows
+
+/**
+	@brief Creates the widgets for a new condition and adds them to the end of the list
+ */
+HaltConditionRow* HaltConditionsDialog::AddConditionRow()
+{
+	auto row = new HaltConditionRow;
+	int y = m_rows.size();
+	m_rows.push_back(row);
+
+	m_conditionGrid.attach(row->m_channelNameBox, 0, y, 1, 1);
+	m_conditionGrid.attach(row->m_operatorBox, 1, y, 1, 1);
+	m_conditionGrid.attach(row->m_targetEntry, 2, y, 1, 1);
+	m_conditionGrid.attach(row->m_widthBox, 3, y, 1, 1);
+	m_conditionGrid.attach(row->m_widthEntry, 4, y, 1, 1);
+	m_conditionGrid.attach(row->m_removeButton, 5, y, 1, 1);
+
+	row->m_channelNameBox.signal_changed().connect(
+		sigc::mem_fun(*this, &HaltConditionsDialog::OnConditionChanged));
+	row->m_operatorBox.signal_changed().connect(
+		sigc::mem_fun(*this, &HaltConditionsDialog::OnConditionChanged));
+	row->m_targetEntry.signal_changed().connect(
+		sigc::mem_fun(*this, &HaltConditionsDialog::OnConditionChanged));
+	row->m_widthBox.signal_changed().connect(
+		sigc::mem_fun(*this, &HaltConditionsDialog::OnConditionChanged));
+	row->m_widthEntry.signal_changed().connect(
+		sigc::mem_fun(*this, &HaltConditionsDialog::OnConditionChanged));
+	row->m_removeButton.signal_clicked().connect(
+		sigc::bind(sigc::mem_fun(*this, &HaltConditionsDialog::OnRemoveCondition), row));
+
+	PopulateChannelBox(row->m_channelNameBox);
+
+	return row;
+}
+
+void HaltConditionsDialog::OnAddCondition()
+{
+	AddConditionRow();
+	m_conditionGrid.show_all();
+	OnConditionChanged();
+}
 
+void HaltConditionsDialog::OnRemoveCondition(HaltConditionRow* row)
+{
+	//We're still inside the remove button's clicked signal, so don't delete it until we're back in the main loop
+	Glib::signal_idle().connect_once(
+		sigc::bind(sigc::mem_fun(*this, &HaltConditionsDialog::RemoveConditionRow), row));
+}
+
+void HaltConditionsDialog::RemoveConditionRow(HaltConditionRow* row)
+{
+	//Always keep at least one condition around
+	if(m_rows.size() <= 1)
+		return;
+
+	for(size_t i=0; i<m_rows.size(); i++)
+	{
+		if(m_rows[i] != row)
+			continue;
+
+		m_conditionGrid.remove_row(i);
+		m_rows.erase(m_rows.begin() + i);
+		delete row;
+		break;
+	}
+
+	OnConditionChanged();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -79,32 +179,23 @@ HaltConditionsDialog::~HaltConditionsDialog()
 
 void HaltConditionsDialog::RefreshChannels()
 {
-	string old_chan = m_channelNameBox.get_active_text();
-
-	m_channelNameBox.remove_all();
 	m_chanptrs.clear();
+	m_channelNames.clear();
 
-	//Populate channel list
+	//Find all channels
 	//Assume hardware channels only have one output for now
-	bool first = true;
 	for(size_t j=0; j<m_parent->GetScopeCount(); j++)
 	{
 		auto scope = m_parent->GetScope(j);
 		for(size_t k=0; k<scope->GetChannelCount(); k++)
 		{
 			auto c = scope->GetChannel(k);
-			m_channelNameBox.append(c->GetDisplayName());
+			m_channelNames.push_back(c->GetDisplayName());
 			m_chanptrs[c->GetDisplayName()] = StreamDescriptor(c, 0);
-
-			if(first && (old_chan == ""))
-			{
-				first = false;
-				m_channelNameBox.set_active_text(c->GetDisplayName());
-			}
 		}
 	}
 
-	//Populate filters
+	//Find all filters
 	auto filters = Filter::GetAllInstances();
 	for(auto d : filters)
 	{
@@ -115,191 +206,83 @@ void HaltConditionsDialog::RefreshChannels()
 			if(nstreams > 1)
 				name += string(".") + d->GetStreamName(i);
 
-			m_channelNameBox.append(name);
+			m_channelNames.push_back(name);
 			m_chanptrs[name] = StreamDescriptor(d, i);
 		}
 	}
 
-	if(old_chan != "")
-		m_channelNameBox.set_active_text(old_chan);
+	for(auto r : m_rows)
+		PopulateChannelBox(r->m_channelNameBox);
+
+	//Stream pointers may have changed even if the names didn't
+	OnConditionChanged();
 }
 
 /**
-	@brief Check if we should halt the trigger
+	@brief Fills a channel selector with every known stream, keeping the current selection if it still exists
  */
-bool HaltConditionsDialog::ShouldHalt(int64_t& timestamp)
+void HaltConditionsDialog::PopulateChannelBox(Gtk::ComboBoxText& box)
 {
-	//If conditional halt is not enabled, no sense checking conditions
-	if(!m_haltEnabledButton.get_active())
-		return false;
-
-	//Get the channel we're looking at
-	auto chan = GetHaltChannel();
-
-	//Don't check if no data to look at
-	auto data = chan.GetData();
-	auto uadata = dynamic_cast<UniformAnalogWaveform*>(data);
-	auto sadata = dynamic_cast<SparseAnalogWaveform*>(data);
-	auto udata = dynamic_cast<UniformWaveformBase*>(data);
-	auto sdata = dynamic_cast<SparseWaveformBase*>(data);
-	if(data->empty())
-		return false;
-
-	//Target for matching
-	auto text = m_targetEntry.get_text();
-	double value = chan.GetYAxisUnits().ParseString(text);
-
-	//Figure out the match filter and check
-	auto sfilter = m_operatorBox.get_active_text();
-	size_t len = data->size();
-	if(sfilter == "<")
-	{
-		//Expect analog data
-		if(!uadata && !sadata)
-			return false;
-
-		for(size_t i=0; i<len; i++)
-		{
-			if(GetValue(sadata, uadata, i) < value)
-			{
-				timestamp = GetOffsetScaled(sdata, udata, i);
-				return true;
-			}
-		}
-	}
-
-	else if(sfilter == "<=")
-	{
-		//Expect analog data
-		if(!uadata && !sadata)
-			return false;
-
-		for(size_t i=0; i<len; i++)
-		{
-			if(GetValue(sadata, uadata, i) <= value)
-			{
-				timestamp = GetOffsetScaled(sdata, udata, i);
-				return true;
-			}
-		}
-	}
-
-	else if(sfilter == "==")
-	{
-		//Match analog data
-		if(uadata || sadata)
-		{
-			for(size_t i=0; i<len; i++)
-			{
-				if(GetValue(sadata, uadata, i) == value)
-				{
-					timestamp = GetOffsetScaled(sdata, udata, i);
-					return true;
-				}
-			}
-		}
-
-		//TODO: match digital data
-
-		//Match filters
-		else
-		{
-			for(size_t i=0; i<len; i++)
-			{
-				if(data->GetText(i) == text)
-				{
-					timestamp = GetOffsetScaled(sdata, udata, i);
-					return true;
-				}
-			}
-		}
-	}
-	else if(sfilter == ">=")
-	{
-		//Expect analog data
-		if(!uadata && !sadata)
-			return false;
+	string old_chan = box.get_active_text();
 
-		for(size_t i=0; i<len; i++)
-		{
-			if(GetValue(sadata, uadata, i) >= value)
-			{
-				timestamp = GetOffsetScaled(sdata, udata, i);
-				return true;
-			}
-		}
-	}
+	box.remove_all();
+	for(auto& name : m_channelNames)
+		box.append(name);
 
-	else if(sfilter == ">")
-	{
-		//Expect analog data
-		if(!uadata && !sadata)
-			return false;
+	if( (old_chan != "") && (m_chanptrs.find(old_chan) != m_chanptrs.end()) )
+		box.set_active_text(old_chan);
+	else if(!m_channelNames.empty())
+		box.set_active_text(m_channelNames[0]);
+}
 
-		for(size_t i=0; i<len; i++)
-		{
-			if(GetValue(sadata, uadata, i) > value)
-			{
-				timestamp = GetOffsetScaled(sdata, udata, i);
-				return true;
-			}
-		}
-	}
+/**
+	@brief Rebuild the compiled conditions after any of the settings changed
+ */
+void HaltConditionsDialog::OnConditionChanged()
+{
+	m_engine.Clear();
 
-	else if(sfilter == "!=")
+	Unit fs(Unit::UNIT_FS);
+	for(auto r : m_rows)
 	{
-		//Match analog data
-		if(uadata || sadata)
-		{
-			for(size_t i=0; i<len; i++)
-			{
-				if(GetValue(sadata, uadata, i) != value)
-				{
-					timestamp = GetOffsetScaled(sdata, udata, i);
-					return true;
-				}
-			}
-		}
-
-		//TODO: match digital data
-
-		//Match filters
-		else
-		{
-			for(size_t i=0; i<len; i++)
-			{
-				if(data->GetText(i) != text)
-				{
-					timestamp = GetOffsetScaled(sdata, udata, i);
-					return true;
-				}
-			}
-		}
+		auto it = m_chanptrs.find(r->m_channelNameBox.get_active_text());
+		if(it == m_chanptrs.end())
+			continue;
+
+		HaltCondition cond;
+		cond.Compile(
+			it->second,
+			HaltCondition::ParseOperator(r->m_operatorBox.get_active_text()),
+			r->m_targetEntry.get_text());
+
+		auto swidth = r->m_widthBox.get_active_text();
+		int64_t width = fs.ParseString(r->m_widthEntry.get_text());
+		if(swidth == "wider than")
+			cond.SetWidthQualifier(HaltCondition::WIDTH_MORE_THAN, width);
+		else if(swidth == "narrower than")
+			cond.SetWidthQualifier(HaltCondition::WIDTH_LESS_THAN, width);
+
+		m_engine.AddCondition(cond);
 	}
 
-	else if(sfilter == "starts with")
+	if(m_combineBox.get_active_text() == "all conditions match within")
 	{
-		for(size_t i=0; i<len; i++)
-		{
-			if(data->GetText(i).find(text) == 0)
-			{
-				timestamp = GetOffsetScaled(sdata, udata, i);
-				return true;
-			}
-		}
+		m_engine.SetCombineMode(
+			HaltConditionEngine::COMBINE_ALL,
+			fs.ParseString(m_windowEntry.get_text()));
 	}
+	else
+		m_engine.SetCombineMode(HaltConditionEngine::COMBINE_ANY, 0);
+}
 
-	else if(sfilter == "contains")
-	{
-		for(size_t i=0; i<len; i++)
-		{
-			if(data->GetText(i).find(text) != string::npos)
-			{
-				timestamp = GetOffsetScaled(sdata, udata, i);
-				return true;
-			}
-		}
-	}
+/**
+	@brief Check if we should halt the trigger
+ */
+bool HaltConditionsDialog::ShouldHalt(int64_t& timestamp)
+{
+	//If conditional halt is not enabled, no sense checking conditions
+	if(!m_haltEnabledButton.get_active())
+		return false;
 
-	return false;
+	return m_engine.Evaluate(timestamp, m_haltStream);
 }
@@ -36,6 +36,26 @@
 #ifndef HaltConditionsDialog_h
 #define HaltConditionsDialog_h
 
+#include "HaltConditionEngine.h"
+
+class OscilloscopeWindow;
+
+/**
+	@brief Widgets for a single condition in the halt conditions dialog
+ */
+class HaltConditionRow
+{
+public:
+	HaltConditionRow();
+
+	Gtk::ComboBoxText m_channelNameBox;
+	Gtk::ComboBoxText m_operatorBox;
+	Gtk::Entry m_targetEntry;
+	Gtk::ComboBoxText m_widthBox;
+	Gtk::Entry m_widthEntry;
+	Gtk::Button m_removeButton;
+};
+
 /**
 	@brief Dialog for configuring halt conditions
  */
@@ -51,20 +71,42 @@ public:
 	bool ShouldMoveToHalt()
 	{ return m_moveToEventButton.get_active(); }
 
+	/**
+		@brief Gets the stream which caused the most recent halt
+	 */
 	StreamDescriptor GetHaltChannel()
-	{ return m_chanptrs[m_channelNameBox.get_active_text()]; }
+	{ return m_haltStream; }
 
 protected:
+	void OnConditionChanged();
+	void OnAddCondition();
+	void OnRemoveCondition(HaltConditionRow* row);
+	void RemoveConditionRow(HaltConditionRow* row);
+
+	HaltConditionRow* AddConditionRow();
+	void PopulateChannelBox(Gtk::ComboBoxText& box);
+
 	Gtk::Grid m_grid;
 		Gtk::CheckButton m_haltEnabledButton;
 		Gtk::CheckButton m_moveToEventButton;
 		Gtk::Label m_channelNameLabel;
-			Gtk::ComboBoxText m_channelNameBox;
-			Gtk::ComboBoxText m_operatorBox;
-			Gtk::Entry m_targetEntry;
+			Gtk::ComboBoxText m_combineBox;
+			Gtk::Entry m_windowEntry;
+		Gtk::Grid m_conditionGrid;
+		Gtk::Button m_addButton;
 
 	OscilloscopeWindow* m_parent;
 	std::map<std::string, StreamDescriptor> m_chanptrs;
+	std::vector<std::string> m_channelNames;
+
+	///@brief One row per condition
+	std::vector<HaltConditionRow*> m_rows;
+
+	///@brief The current conditions, rebuilt whenever the settings change
+	HaltConditionEngine m_engine;
+
+	///@brief Stream which caused the most recent halt
+	StreamDescriptor m_haltStream;
 };
 
 #endif
@@ -0,0 +1,313 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of HistorySearch
+ */
+#include "glscopeclient.h"
+#include "HistorySearch.h"
+#include "pthread_compat.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+HistorySearch::HistorySearch()
+	: m_jobCount(0)
+	, m_nextJob(0)
+	, m_jobsDone(0)
+	, m_cancel(false)
+{
+}
+
+HistorySearch::~HistorySearch()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Thread pool
+
+/**
+	@brief Starts a new search, cancelling any previous one
+
+	@param count	Number of jobs
+	@param job		Function to run for each job index. Appends any hits it finds to the supplied vector.
+ */
+void HistorySearch::Start(size_t count, SearchJob job)
+{
+	Stop();
+
+	//Discard anything left over from the last search
+	{
+		lock_guard<mutex> lock(m_hitMutex);
+		m_pendingHits.clear();
+	}
+
+	m_job = job;
+	m_jobCount = count;
+	m_nextJob = 0;
+	m_jobsDone = 0;
+	m_cancel = false;
+
+	size_t nthreads = max(1u, thread::hardware_concurrency());
+	nthreads = min(nthreads, count);
+	for(size_t i=0; i<nthreads; i++)
+		m_threads.push_back(thread(&HistorySearch::WorkerThread, this));
+}
+
+/**
+	@brief Cancels the current search (if any) and waits for the worker threads to exit
+ */
+void HistorySearch::Stop()
+{
+	m_cancel = true;
+	for(auto& t : m_threads)
+		t.join();
+	m_threads.clear();
+
+	//Anything we didn't get to counts as done
+	m_jobsDone = m_jobCount;
+
+	//Hits from a cancelled search shouldn't show up in the next one
+	lock_guard<mutex> lock(m_hitMutex);
+	m_pendingHits.clear();
+}
+
+void HistorySearch::WorkerThread()
+{
+	pthread_setname_np_compat("HistorySearch");
+
+	vector<HistorySearchHit> hits;
+	while(!m_cancel)
+	{
+		size_t i = m_nextJob ++;
+		if(i >= m_jobCount)
+			break;
+
+		m_job(i, hits);
+
+		//Publish hits as soon as we find them
+		if(!hits.empty())
+		{
+			lock_guard<mutex> lock(m_hitMutex);
+			m_pendingHits.insert(m_pendingHits.end(), hits.begin(), hits.end());
+			hits.clear();
+		}
+
+		m_jobsDone ++;
+	}
+}
+
+/**
+	@brief Gets all hits found since the last call
+ */
+void HistorySearch::PopHits(vector<HistorySearchHit>& hits)
+{
+	lock_guard<mutex> lock(m_hitMutex);
+	hits.insert(hits.end(), m_pendingHits.begin(), m_pendingHits.end());
+	m_pendingHits.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Searches
+
+/**
+	@brief Finds every history entry with a sample matching a condition (threshold crossing etc)
+
+	The stream the condition was compiled for selects which waveform of each entry is checked. Only the first match
+	in each entry is reported.
+ */
+void HistorySearch::SearchSamples(const vector<HistoryEntry>& entries, const HaltCondition& cond)
+{
+	Stop();
+	m_entries = entries;
+	m_condition = cond;
+
+	for(auto& e : m_entries)
+	{
+		auto it = e.m_history.find(m_condition.GetStream());
+		if( (it != e.m_history.end()) && it->second)
+			it->second->PrepareForCpuAccess();
+	}
+
+	Start(m_entries.size(), [this](size_t i, vector<HistorySearchHit>& hits)
+		{
+			auto& e = m_entries[i];
+			auto stream = m_condition.GetStream();
+			auto it = e.m_history.find(stream);
+			if(it == e.m_history.end())
+				return;
+
+			auto data = it->second;
+			if(!m_condition.CanScan(data))
+				return;
+
+			vector<HaltCondition::Match> matches;
+			HaltCondition::ScanState state;
+			m_condition.BeginScan(state);
+			m_condition.ScanBlock(data, 0, data->size(), state, matches, 1);
+			if(matches.empty())
+				m_condition.EndScan(data, state, matches);
+			if(matches.empty())
+				return;
+
+			HistorySearchHit hit;
+			hit.m_key = e.m_key;
+			hit.m_stream = stream;
+			hit.m_offset = matches[0].m_offset;
+			auto sadata = dynamic_cast<SparseAnalogWaveform*>(data);
+			auto uadata = dynamic_cast<UniformAnalogWaveform*>(data);
+			if(sadata || uadata)
+				hit.m_description = stream.GetYAxisUnits().PrettyPrint(GetValue(sadata, uadata, matches[0].m_index));
+			else
+				hit.m_description = data->GetText(matches[0].m_index);
+			hits.push_back(hit);
+		});
+}
+
+/**
+	@brief Finds every history entry where a measurement of one stream is outside a range
+ */
+void HistorySearch::SearchMeasurement(
+	const vector<HistoryEntry>& entries,
+	StreamDescriptor stream,
+	MeasurementType type,
+	float minval,
+	float maxval)
+{
+	Stop();
+	m_entries = entries;
+
+	for(auto& e : m_entries)
+	{
+		auto it = e.m_history.find(stream);
+		if( (it != e.m_history.end()) && it->second)
+			it->second->PrepareForCpuAccess();
+	}
+
+	Start(m_entries.size(), [this, stream, type, minval, maxval](size_t i, vector<HistorySearchHit>& hits)
+		{
+			auto& e = m_entries[i];
+			auto it = e.m_history.find(stream);
+			if(it == e.m_history.end())
+				return;
+
+			float value;
+			if(!Measure(it->second, type, value))
+				return;
+			if( (value >= minval) && (value <= maxval) )
+				return;
+
+			HistorySearchHit hit;
+			hit.m_key = e.m_key;
+			hit.m_stream = stream;
+			hit.m_offset = 0;
+			hit.m_description = stream.GetYAxisUnits().PrettyPrint(value);
+			hits.push_back(hit);
+		});
+}
+
+/**
+	@brief Finds every protocol packet containing a string
+ */
+void HistorySearch::SearchProtocol(const vector<HistoryPacket>& packets, StreamDescriptor stream, const string& text)
+{
+	Stop();
+	m_packets = packets;
+	m_text = text;
+
+	Start(m_packets.size(), [this, stream](size_t i, vector<HistorySearchHit>& hits)
+		{
+			auto& p = m_packets[i];
+			if(p.m_text.find(m_text) == string::npos)
+				return;
+
+			HistorySearchHit hit;
+			hit.m_key = p.m_key;
+			hit.m_stream = stream;
+			hit.m_offset = p.m_offset;
+			hit.m_description = p.m_text;
+			hits.push_back(hit);
+		});
+}
+
+/**
+	@brief Computes a simple measurement of an analog waveform
+
+	@return False if the waveform is not analog or is empty
+ */
+bool HistorySearch::Measure(WaveformBase* data, MeasurementType type, float& value)
+{
+	auto uadata = dynamic_cast<UniformAnalogWaveform*>(data);
+	auto sadata = dynamic_cast<SparseAnalogWaveform*>(data);
+	if(!uadata && !sadata)
+		return false;
+
+	size_t len = data->size();
+	if(len == 0)
+		return false;
+
+	const float* samples = uadata ? uadata->m_samples.GetCpuPointer() : sadata->m_samples.GetCpuPointer();
+
+	float vmin = samples[0];
+	float vmax = samples[0];
+	double sum = 0;
+	for(size_t i=0; i<len; i++)
+	{
+		vmin = min(vmin, samples[i]);
+		vmax = max(vmax, samples[i]);
+		sum += samples[i];
+	}
+
+	switch(type)
+	{
+		case MEASURE_MIN:
+			value = vmin;
+			break;
+
+		case MEASURE_MAX:
+			value = vmax;
+			break;
+
+		case MEASURE_MEAN:
+			value = sum / len;
+			break;
+
+		case MEASURE_PKPK:
+		default:
+			value = vmax - vmin;
+			break;
+	}
+
+	return true;
+}
@@ -0,0 +1,159 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of HistorySearch
+ */
+
+#ifndef HistorySearch_h
+#define HistorySearch_h
+
+#include <functional>
+#include "HaltCondition.h"
+
+/**
+	@brief A decoded protocol packet to be searched
+
+	Only the fields needed for searching are copied out of the protocol analyzer, so the search threads never touch
+	GTK objects.
+ */
+class HistoryPacket
+{
+public:
+	TimePoint m_key;
+	int64_t m_offset;
+	std::string m_text;
+};
+
+/**
+	@brief A single search result
+ */
+class HistorySearchHit
+{
+public:
+	///@brief Acquisition the hit was found in
+	TimePoint m_key;
+
+	///@brief Stream the hit was found in
+	StreamDescriptor m_stream;
+
+	///@brief Offset of the hit from the start of the waveform, in X axis units
+	int64_t m_offset;
+
+	///@brief Human readable description of what matched
+	std::string m_description;
+};
+
+/**
+	@brief Searches waveform history for events, in parallel
+
+	Each history entry (or protocol packet) is an independent job. Jobs are handed out to a pool of worker threads and
+	hits are queued as they're found, so the UI can display them incrementally with PopHits() while the search runs.
+
+	History must not be modified while a search is in progress.
+ */
+class HistorySearch
+{
+public:
+	HistorySearch();
+	virtual ~HistorySearch();
+
+	enum MeasurementType
+	{
+		MEASURE_MIN,
+		MEASURE_MAX,
+		MEASURE_MEAN,
+		MEASURE_PKPK
+	};
+
+	void SearchSamples(const std::vector<HistoryEntry>& entries, const HaltCondition& cond);
+	void SearchMeasurement(
+		const std::vector<HistoryEntry>& entries,
+		StreamDescriptor stream,
+		MeasurementType type,
+		float minval,
+		float maxval);
+	void SearchProtocol(const std::vector<HistoryPacket>& packets, StreamDescriptor stream, const std::string& text);
+
+	void Stop();
+
+	/**
+		@brief Checks if any worker threads are still running
+	 */
+	bool IsRunning()
+	{ return m_jobsDone < m_jobCount; }
+
+	/**
+		@brief Fraction of jobs completed, from 0 to 1
+	 */
+	float GetProgress()
+	{ return m_jobCount ? (m_jobsDone * 1.0f / m_jobCount) : 1; }
+
+	void PopHits(std::vector<HistorySearchHit>& hits);
+
+	static bool Measure(WaveformBase* data, MeasurementType type, float& value);
+
+protected:
+	typedef std::function<void(size_t, std::vector<HistorySearchHit>&)> SearchJob;
+
+	void Start(size_t count, SearchJob job);
+	void WorkerThread();
+
+	///@brief The worker threads
+	std::vector<std::thread> m_threads;
+
+	///@brief Function run for each job index
+	SearchJob m_job;
+
+	///@brief Total number of jobs in the current search
+	size_t m_jobCount;
+
+	///@brief Index of the next job to hand out
+	std::atomic<size_t> m_nextJob;
+
+	///@brief Number of jobs finished
+	std::atomic<size_t> m_jobsDone;
+
+	///@brief Set to abort the search early
+	std::atomic<bool> m_cancel;
+
+	///@brief Hits found but not yet returned by PopHits()
+	std::vector<HistorySearchHit> m_pendingHits;
+	std::mutex m_hitMutex;
+
+	//Inputs for the current search (owned here so they outlive the workers)
+	std::vector<HistoryEntry> m_entries;
+	std::vector<HistoryPacket> m_packets;
+	HaltCondition m_condition;
+	std::string m_text;
+};
+
+#endif
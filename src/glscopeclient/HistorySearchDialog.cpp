@@ -0,0 +1,358 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of HistorySearchDialog
+ */
+#include "glscopeclient.h"
+#include "OscilloscopeWindow.h"
+#include "HistorySearchDialog.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistorySearchColumns
+
+HistorySearchColumns::HistorySearchColumns()
+{
+	add(m_timestamp);
+	add(m_channel);
+	add(m_offset);
+	add(m_description);
+	add(m_index);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+HistorySearchDialog::HistorySearchDialog(OscilloscopeWindow* parent)
+	: Gtk::Dialog("Search History", *parent)
+	, m_parent(parent)
+{
+	set_default_size(600, 500);
+
+	get_vbox()->pack_start(m_grid, Gtk::PACK_SHRINK);
+		m_grid.attach(m_typeLabel, 0, 0, 1, 1);
+			m_typeLabel.set_label("Search for");
+			m_typeLabel.set_halign(Gtk::ALIGN_START);
+		m_grid.attach_next_to(m_typeBox, m_typeLabel, Gtk::POS_RIGHT, 3, 1);
+			m_typeBox.append("Sample value");
+			m_typeBox.append("Measurement out of range");
+			m_typeBox.append("Protocol text");
+			m_typeBox.set_active_text("Sample value");
+
+		m_grid.attach_next_to(m_channelLabel, m_typeLabel, Gtk::POS_BOTTOM, 1, 1);
+			m_channelLabel.set_label("Channel");
+			m_channelLabel.set_halign(Gtk::ALIGN_START);
+		m_grid.attach_next_to(m_channelBox, m_channelLabel, Gtk::POS_RIGHT, 3, 1);
+
+		m_grid.attach_next_to(m_conditionLabel, m_channelLabel, Gtk::POS_BOTTOM, 1, 1);
+			m_conditionLabel.set_label("Condition");
+			m_conditionLabel.set_halign(Gtk::ALIGN_START);
+		m_grid.attach_next_to(m_operatorBox, m_conditionLabel, Gtk::POS_RIGHT, 1, 1);
+			m_operatorBox.append("<");
+			m_operatorBox.append("<=");
+			m_operatorBox.append("==");
+			m_operatorBox.append(">");
+			m_operatorBox.append(">=");
+			m_operatorBox.append("!=");
+			m_operatorBox.set_active_text(">");
+		m_grid.attach_next_to(m_measurementBox, m_operatorBox, Gtk::POS_RIGHT, 1, 1);
+			m_measurementBox.append("Minimum");
+			m_measurementBox.append("Maximum");
+			m_measurementBox.append("Mean");
+			m_measurementBox.append("Peak-to-peak");
+			m_measurementBox.set_active_text("Peak-to-peak");
+		m_grid.attach_next_to(m_targetEntry, m_measurementBox, Gtk::POS_RIGHT, 1, 1);
+			m_targetEntry.set_hexpand(true);
+		m_grid.attach_next_to(m_maxLabel, m_targetEntry, Gtk::POS_RIGHT, 1, 1);
+			m_maxLabel.set_label("to");
+		m_grid.attach_next_to(m_maxEntry, m_maxLabel, Gtk::POS_RIGHT, 1, 1);
+
+		m_grid.attach_next_to(m_searchButton, m_conditionLabel, Gtk::POS_BOTTOM, 1, 1);
+			m_searchButton.set_label("Search");
+		m_grid.attach_next_to(m_progressBar, m_searchButton, Gtk::POS_RIGHT, 3, 1);
+			m_progressBar.set_show_text(true);
+			m_progressBar.set_valign(Gtk::ALIGN_CENTER);
+
+	get_vbox()->pack_start(m_scroller, Gtk::PACK_EXPAND_WIDGET);
+		m_scroller.add(m_tree);
+		m_scroller.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+
+	m_model = Gtk::ListStore::create(m_columns);
+	m_tree.set_model(m_model);
+	m_tree.append_column("Time", m_columns.m_timestamp);
+	m_tree.append_column("Channel", m_columns.m_channel);
+	m_tree.append_column("Offset", m_columns.m_offset);
+	m_tree.append_column("Value", m_columns.m_description);
+
+	m_typeBox.signal_changed().connect(sigc::mem_fun(*this, &HistorySearchDialog::OnTypeChanged));
+	m_searchButton.signal_clicked().connect(sigc::mem_fun(*this, &HistorySearchDialog::OnSearch));
+	m_tree.signal_row_activated().connect(sigc::mem_fun(*this, &HistorySearchDialog::OnRowActivated));
+
+	show_all();
+	OnTypeChanged();
+}
+
+HistorySearchDialog::~HistorySearchDialog()
+{
+	StopSearch();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Event handlers
+
+void HistorySearchDialog::on_hide()
+{
+	StopSearch();
+	Gtk::Dialog::on_hide();
+}
+
+/**
+	@brief Show only the widgets relevant to the selected search type
+ */
+void HistorySearchDialog::OnTypeChanged()
+{
+	auto type = m_typeBox.get_active_text();
+	if(type == "Sample value")
+	{
+		m_operatorBox.show();
+		m_measurementBox.hide();
+		m_maxLabel.hide();
+		m_maxEntry.hide();
+	}
+	else if(type == "Measurement out of range")
+	{
+		m_operatorBox.hide();
+		m_measurementBox.show();
+		m_maxLabel.show();
+		m_maxEntry.show();
+	}
+	else
+	{
+		m_operatorBox.hide();
+		m_measurementBox.hide();
+		m_maxLabel.hide();
+		m_maxEntry.hide();
+	}
+
+	RefreshChannels();
+}
+
+/**
+	@brief Fills the channel list with the streams we can search for the selected search type
+ */
+void HistorySearchDialog::RefreshChannels()
+{
+	string old_chan = m_channelBox.get_active_text();
+
+	m_channelBox.remove_all();
+	m_chanptrs.clear();
+
+	//Protocol text comes from protocol analyzers
+	if(m_typeBox.get_active_text() == "Protocol text")
+	{
+		for(auto a : m_parent->m_analyzers)
+		{
+			auto d = a->GetDecoder();
+			m_channelBox.append(d->GetDisplayName());
+			m_chanptrs[d->GetDisplayName()] = StreamDescriptor(d, 0);
+		}
+	}
+
+	//Only instrument channels are saved in history, so they're all we can search
+	else
+	{
+		for(size_t j=0; j<m_parent->GetScopeCount(); j++)
+		{
+			auto scope = m_parent->GetScope(j);
+			for(size_t k=0; k<scope->GetChannelCount(); k++)
+			{
+				auto c = scope->GetChannel(k);
+				if(c->GetType(0) != Stream::STREAM_TYPE_ANALOG)
+					continue;
+
+				m_channelBox.append(c->GetDisplayName());
+				m_chanptrs[c->GetDisplayName()] = StreamDescriptor(c, 0);
+			}
+		}
+	}
+
+	if(m_chanptrs.find(old_chan) != m_chanptrs.end())
+		m_channelBox.set_active_text(old_chan);
+	else
+		m_channelBox.set_active(0);
+}
+
+void HistorySearchDialog::OnSearch()
+{
+	//Already running? Cancel it
+	if(m_search.IsRunning())
+	{
+		StopSearch();
+		return;
+	}
+
+	auto it = m_chanptrs.find(m_channelBox.get_active_text());
+	if(it == m_chanptrs.end())
+		return;
+	auto stream = it->second;
+
+	//History must not change under the search threads
+	m_parent->OnStop();
+
+	m_hits.clear();
+	m_model->clear();
+
+	auto type = m_typeBox.get_active_text();
+	if(type == "Protocol text")
+	{
+		//Copy out the packet text so the search threads never touch GTK objects
+		vector<HistoryPacket> packets;
+		for(auto a : m_parent->m_analyzers)
+		{
+			if(a->GetDecoder() != stream.m_channel)
+				continue;
+
+			for(auto& row : a->GetPacketRows())
+			{
+				HistoryPacket p;
+				p.m_key = row.m_capturekey;
+				p.m_offset = row.m_offset;
+				for(auto& h : row.m_headers)
+					p.m_text += h + " ";
+				p.m_text += row.m_data;
+				packets.push_back(p);
+			}
+		}
+
+		m_search.SearchProtocol(packets, stream, m_targetEntry.get_text());
+	}
+	else
+	{
+		vector<HistoryEntry> entries;
+		m_parent->GetHistoryEntries(entries);
+
+		if(type == "Sample value")
+		{
+			HaltCondition cond;
+			cond.Compile(stream, HaltCondition::ParseOperator(m_operatorBox.get_active_text()), m_targetEntry.get_text());
+			m_search.SearchSamples(entries, cond);
+		}
+		else
+		{
+			auto smeas = m_measurementBox.get_active_text();
+			HistorySearch::MeasurementType mtype = HistorySearch::MEASURE_PKPK;
+			if(smeas == "Minimum")
+				mtype = HistorySearch::MEASURE_MIN;
+			else if(smeas == "Maximum")
+				mtype = HistorySearch::MEASURE_MAX;
+			else if(smeas == "Mean")
+				mtype = HistorySearch::MEASURE_MEAN;
+
+			auto unit = stream.GetYAxisUnits();
+			m_search.SearchMeasurement(
+				entries,
+				stream,
+				mtype,
+				unit.ParseString(m_targetEntry.get_text()),
+				unit.ParseString(m_maxEntry.get_text()));
+		}
+	}
+
+	//Keep the user from editing history until we're done
+	set_modal(true);
+	m_searchButton.set_label("Stop");
+	m_timerConnection = Glib::signal_timeout().connect(sigc::mem_fun(*this, &HistorySearchDialog::OnTimer), 100);
+}
+
+/**
+	@brief Pulls new hits from the search threads and displays them
+ */
+bool HistorySearchDialog::OnTimer()
+{
+	bool running = m_search.IsRunning();
+
+	vector<HistorySearchHit> hits;
+	m_search.PopHits(hits);
+	Unit fs(Unit::UNIT_FS);
+	for(auto& h : hits)
+	{
+		auto row = *m_model->append();
+		row[m_columns.m_timestamp] =
+			HistoryWindow::FormatDate(h.m_key.first, h.m_key.second) + " " +
+			HistoryWindow::FormatTimestamp(h.m_key.first, h.m_key.second);
+		row[m_columns.m_channel] = h.m_stream.GetName();
+		row[m_columns.m_offset] = fs.PrettyPrint(h.m_offset);
+		row[m_columns.m_description] = h.m_description;
+		row[m_columns.m_index] = m_hits.size();
+		m_hits.push_back(h);
+	}
+
+	char tmp[128];
+	snprintf(tmp, sizeof(tmp), "%zu hits", m_hits.size());
+	m_progressBar.set_text(tmp);
+	m_progressBar.set_fraction(m_search.GetProgress());
+
+	if(running)
+		return true;
+
+	//Done
+	StopSearch();
+	return false;
+}
+
+void HistorySearchDialog::StopSearch()
+{
+	m_search.Stop();
+	m_timerConnection.disconnect();
+	set_modal(false);
+	m_searchButton.set_label("Search");
+}
+
+void HistorySearchDialog::OnRowActivated(const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn* /*column*/)
+{
+	auto row = *m_model->get_iter(path);
+	size_t index = row[m_columns.m_index];
+	if(index >= m_hits.size())
+		return;
+	auto& hit = m_hits[index];
+
+	//Load the waveform, then move the view to the event
+	m_parent->JumpToHistory(hit.m_key);
+	m_parent->MoveViewToTimestamp(hit.m_stream, hit.m_offset);
+
+	for(auto a : m_parent->m_analyzers)
+	{
+		if(a->GetDecoder() == hit.m_stream.m_channel)
+			a->SelectPacket(hit.m_key, hit.m_offset);
+	}
+}
@@ -0,0 +1,107 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of HistorySearchDialog
+ */
+
+#ifndef HistorySearchDialog_h
+#define HistorySearchDialog_h
+
+#include "HistorySearch.h"
+
+class OscilloscopeWindow;
+
+class HistorySearchColumns : public Gtk::TreeModel::ColumnRecord
+{
+public:
+	HistorySearchColumns();
+
+	Gtk::TreeModelColumn<Glib::ustring>		m_timestamp;
+	Gtk::TreeModelColumn<Glib::ustring>		m_channel;
+	Gtk::TreeModelColumn<Glib::ustring>		m_offset;
+	Gtk::TreeModelColumn<Glib::ustring>		m_description;
+	Gtk::TreeModelColumn<size_t>			m_index;
+};
+
+/**
+	@brief Dialog for searching all history windows for an event
+ */
+class HistorySearchDialog	: public Gtk::Dialog
+{
+public:
+	HistorySearchDialog(OscilloscopeWindow* parent);
+	virtual ~HistorySearchDialog();
+
+	void RefreshChannels();
+	void StopSearch();
+
+protected:
+	virtual void on_hide();
+
+	void OnTypeChanged();
+	void OnSearch();
+	void OnRowActivated(const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn* column);
+	bool OnTimer();
+
+	Gtk::Grid m_grid;
+		Gtk::Label m_typeLabel;
+			Gtk::ComboBoxText m_typeBox;
+		Gtk::Label m_channelLabel;
+			Gtk::ComboBoxText m_channelBox;
+		Gtk::Label m_conditionLabel;
+			Gtk::ComboBoxText m_operatorBox;
+			Gtk::ComboBoxText m_measurementBox;
+			Gtk::Entry m_targetEntry;
+			Gtk::Label m_maxLabel;
+			Gtk::Entry m_maxEntry;
+		Gtk::Button m_searchButton;
+		Gtk::ProgressBar m_progressBar;
+	Gtk::ScrolledWindow m_scroller;
+		Gtk::TreeView m_tree;
+	Glib::RefPtr<Gtk::ListStore> m_model;
+	HistorySearchColumns m_columns;
+
+	OscilloscopeWindow* m_parent;
+
+	///@brief Streams available for the selected search type
+	std::map<std::string, StreamDescriptor> m_chanptrs;
+
+	///@brief The search engine
+	HistorySearch m_search;
+
+	///@brief All hits found so far in the current search
+	std::vector<HistorySearchHit> m_hits;
+
+	sigc::connection m_timerConnection;
+};
+
+#endif
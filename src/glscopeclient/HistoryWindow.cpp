@@ -36,6 +36,8 @@
 #include "OscilloscopeWindow.h"
 #include "HistoryWindow.h"
 #include "FileProgressDialog.h"
+#include "pthread_compat.h"
+#include "../scopehal/MockOscilloscope.h"
 
 using namespace std;
 
@@ -116,6 +118,8 @@ HistoryWindow::HistoryWindow(OscilloscopeWindow* parent, Oscilloscope* scope)
 
 HistoryWindow::~HistoryWindow()
 {
+	m_parent->StopHistorySearch();
+
 	//Delete old waveform data
 	auto children = m_model->children();
 	for(auto it : children)
@@ -227,6 +231,7 @@ void HistoryWindow::OnWaveformDataReady(bool loading, bool pin, const string& la
 
 	//Add waveform data
 	WaveformHistory hist;
+	bool offline = (dynamic_cast<MockOscilloscope*>(m_scope) != NULL);
 	for(size_t i=0; i<m_scope->GetChannelCount(); i++)
 	{
 		auto c = m_scope->GetChannel(i);
@@ -246,6 +251,11 @@ void HistoryWindow::OnWaveformDataReady(bool loading, bool pin, const string& la
 			auto uadat = dynamic_cast<UniformAnalogWaveform*>(data);
 			if(uadat)
 				uadat->m_samples.shrink_to_fit();
+
+			//The history now owns this waveform, so give the driver a recycled one for the next trigger.
+			//Offline scopes never acquire, anything we gave them would just sit there.
+			if(!loading && !offline)
+				m_parent->GetWaveformPool().RefillScopePool(m_scope, dat);
 		}
 	}
 	row[m_columns.m_history] = hist;
@@ -313,6 +323,9 @@ void HistoryWindow::ClearOldHistoryItems()
 
 void HistoryWindow::DeleteHistoryRow(const Gtk::TreeModel::iterator& it)
 {
+	//Make sure no search threads are still looking at the waveforms we're about to free
+	m_parent->StopHistorySearch();
+
 	//Delete any protocol analyzer state from the waveform being deleted
 	auto key = (*it)[m_columns.m_capturekey];
 	m_parent->RemoveProtocolHistoryFrom(key);
@@ -324,15 +337,13 @@ void HistoryWindow::DeleteHistoryRow(const Gtk::TreeModel::iterator& it)
 	//Remove the row from the tree view
 	m_model->erase(it);
 
-	//then delete the history (or add to the pool for reuse)
+	//then add the history to the pool for reuse
+	auto& pool = m_parent->GetWaveformPool();
 	for(auto w : hist)
 	{
-		if(dynamic_cast<UniformAnalogWaveform*>(w.second) != nullptr)
-			m_scope->AddWaveformToAnalogPool(w.second);
-		else if(dynamic_cast<SparseDigitalWaveform*>(w.second) != nullptr)
-			m_scope->AddWaveformToDigitalPool(w.second);
-		else
-			delete w.second;
+		//Do *not* recycle the channel's current data!
+		if(w.second && (w.second != w.first.m_channel->GetData(w.first.m_stream)) )
+			pool.Add(w.second);
 	}
 }
 
@@ -347,64 +358,8 @@ void HistoryWindow::UpdateMemoryUsageEstimate()
 		WaveformHistory hist = (*it)[m_columns.m_history];
 		for(auto jt : hist)
 		{
-			auto sacap = dynamic_cast<SparseAnalogWaveform*>(jt.second);
-			if(sacap != NULL)
-			{
-				//Add static size of the capture object
-				bytes_used += sizeof(SparseAnalogWaveform);
-
-				//Add size of each sample
-				bytes_used += sizeof(float) * sacap->m_samples.capacity();
-				bytes_used += sizeof(int64_t) * sacap->m_offsets.capacity();
-				bytes_used += sizeof(int64_t) * sacap->m_durations.capacity();
-			}
-			auto uacap = dynamic_cast<UniformAnalogWaveform*>(jt.second);
-			if(uacap != NULL)
-			{
-				//Add static size of the capture object
-				bytes_used += sizeof(UniformAnalogWaveform);
-
-				//Add size of each sample
-				bytes_used += sizeof(float) * uacap->m_samples.capacity();
-			}
-
-			auto sdcap = dynamic_cast<SparseDigitalWaveform*>(jt.second);
-			if(sdcap != NULL)
-			{
-				//Add static size of the capture object
-				bytes_used += sizeof(SparseDigitalWaveform);
-
-				//Add size of each sample
-				bytes_used += sizeof(bool) * sdcap->m_samples.capacity();
-				bytes_used += sizeof(int64_t) * sdcap->m_offsets.capacity();
-				bytes_used += sizeof(int64_t) * sdcap->m_durations.capacity();
-			}
-			auto udcap = dynamic_cast<UniformDigitalWaveform*>(jt.second);
-			if(udcap != NULL)
-			{
-				//Add static size of the capture object
-				bytes_used += sizeof(UniformDigitalWaveform);
-
-				//Add size of each sample
-				bytes_used += sizeof(bool) * udcap->m_samples.capacity();
-			}
-
-			auto sbcap = dynamic_cast<SparseDigitalBusWaveform*>(jt.second);
-			if(sbcap != NULL)
-			{
-				//Add static size of the capture object
-				bytes_used += sizeof(SparseDigitalBusWaveform);
-
-				if(!sbcap->m_samples.empty())
-				{
-					//Add size of each sample
-					bytes_used +=
-						(sbcap->m_samples[0].size() * sizeof(bool) + sizeof(vector<bool>))
-						* sbcap->m_samples.capacity();
-					bytes_used += sizeof(int64_t) * sbcap->m_offsets.capacity();
-					bytes_used += sizeof(int64_t) * sbcap->m_durations.capacity();
-				}
-			}
+			if(jt.second)
+				bytes_used += WaveformPool::GetMemoryUsage(jt.second);
 		}
 	}
 
@@ -492,6 +447,20 @@ void HistoryWindow::JumpToHistory(TimePoint timestamp)
 	}
 }
 
+/**
+	@brief Appends every acquisition in the history to a list
+ */
+void HistoryWindow::GetEntries(vector<HistoryEntry>& entries)
+{
+	auto children = m_model->children();
+	for(auto it : children)
+	{
+		HistoryEntry e;
+		e.m_key = (*it)[m_columns.m_capturekey];
+		e.m_history = (*it)[m_columns.m_history];
+		entries.push_back(e);
+	}
+}
 
 void HistoryWindow::ReplayHistory()
 {
@@ -886,6 +855,9 @@ void HistoryWindow::DoSaveWaveformDataForSparseStream(
 	volatile int* done
 	)
 {
+	pthread_setname_np_compat("HistorySave");
+	TraceSpan span("SaveWaveformData");
+
 	auto chan = stream.m_channel;
 	int index = chan->GetIndex();
 	size_t nstream = stream.m_stream;
@@ -1006,6 +978,9 @@ void HistoryWindow::DoSaveWaveformDataForDenseStream(
 	volatile int* done
 	)
 {
+	pthread_setname_np_compat("HistorySave");
+	TraceSpan span("SaveWaveformData");
+
 	auto chan = stream.m_channel;
 	int index = chan->GetIndex();
 	size_t nstream = stream.m_stream;
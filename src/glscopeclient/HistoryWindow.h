@@ -42,6 +42,16 @@ class Marker;
 
 typedef std::map<StreamDescriptor, WaveformBase*> WaveformHistory;
 
+/**
+	@brief One acquisition from a history window
+ */
+class HistoryEntry
+{
+public:
+	TimePoint m_key;
+	WaveformHistory m_history;
+};
+
 class HistoryColumns : public Gtk::TreeModel::ColumnRecord
 {
 public:
@@ -84,6 +94,11 @@ public:
 
 	void SetMaxWaveforms(int n);
 
+	void GetEntries(std::vector<HistoryEntry>& entries);
+
+	static std::string FormatTimestamp(time_t base, int64_t offset);
+	static std::string FormatDate(time_t base, int64_t offset);
+
 	void SerializeWaveforms(
 		std::string dir,
 		IDTable& table,
@@ -102,9 +117,6 @@ protected:
 
 	void DeleteHistoryRow(const Gtk::TreeModel::iterator& it);
 
-	std::string FormatTimestamp(time_t base, int64_t offset);
-	std::string FormatDate(time_t base, int64_t offset);
-
 	static void DoSaveWaveformDataForSparseStream(
 		std::string wname,
 		StreamDescriptor stream,
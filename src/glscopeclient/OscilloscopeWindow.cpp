@@ -49,6 +49,7 @@
 #include "FunctionGeneratorDialog.h"
 #include "SCPIConsoleDialog.h"
 #include "FileSystem.h"
+#include "pthread_compat.h"
 #include <unistd.h>
 #include <fcntl.h>
 #include "../../lib/scopeprotocols/EyePattern.h"
@@ -79,6 +80,7 @@ OscilloscopeWindow::OscilloscopeWindow(const vector<Oscilloscope*>& scopes)
 	, m_syncComplete(false)
 	, m_graphEditor(NULL)
 	, m_haltConditionsDialog(this)
+	, m_historySearchDialog(NULL)
 	, m_timebasePropertiesDialog(NULL)
 	, m_addFilterDialog(NULL)
 	, m_pendingGenerator(NULL)
@@ -110,6 +112,8 @@ OscilloscopeWindow::OscilloscopeWindow(const vector<Oscilloscope*>& scopes)
 	SaveRecentInstrumentList();
 	RefreshInstrumentMenus();
 
+	ApplyMemoryPreferences();
+
 	ArmTrigger(TRIGGER_TYPE_NORMAL);
 	m_toggleInProgress = false;
 
@@ -316,6 +320,10 @@ void OscilloscopeWindow::CreateWidgets()
 						m_windowFilterGraphItem.set_label("Filter Graph");
 						m_windowFilterGraphItem.signal_activate().connect(
 							sigc::mem_fun(*this, &OscilloscopeWindow::OnFilterGraph));
+					m_windowMenu.append(m_windowHistorySearchItem);
+						m_windowHistorySearchItem.set_label("Search History...");
+						m_windowHistorySearchItem.signal_activate().connect(
+							sigc::mem_fun(*this, &OscilloscopeWindow::OnHistorySearch));
 					m_windowMenu.append(m_windowAnalyzerMenuItem);
 						m_windowAnalyzerMenuItem.set_label("Analyzer");
 						m_windowAnalyzerMenuItem.set_submenu(m_windowAnalyzerMenu);
@@ -337,6 +345,26 @@ void OscilloscopeWindow::CreateWidgets()
 						m_windowScpiConsoleMenuItem.set_label("SCPI Console");
 						m_windowScpiConsoleMenuItem.set_submenu(m_windowScpiConsoleMenu);
 
+					item = Gtk::manage(new Gtk::SeparatorMenuItem);
+					m_windowMenu.append(*item);
+
+					m_windowMenu.append(m_windowTraceMenuItem);
+						m_windowTraceMenuItem.set_label("Performance Trace");
+						m_windowTraceMenuItem.set_submenu(m_windowTraceMenu);
+							m_windowTraceMenu.append(m_windowTraceRecordItem);
+								m_windowTraceRecordItem.set_label("Record");
+								m_windowTraceRecordItem.set_active(Tracer::IsEnabled());
+								m_windowTraceRecordItem.signal_toggled().connect(
+									sigc::mem_fun(*this, &OscilloscopeWindow::OnTraceRecord));
+							m_windowTraceMenu.append(m_windowTraceClearItem);
+								m_windowTraceClearItem.set_label("Clear");
+								m_windowTraceClearItem.signal_activate().connect(
+									sigc::ptr_fun(&Tracer::Clear));
+							m_windowTraceMenu.append(m_windowTraceSaveItem);
+								m_windowTraceSaveItem.set_label("Save...");
+								m_windowTraceSaveItem.signal_activate().connect(
+									sigc::mem_fun(*this, &OscilloscopeWindow::OnTraceSave));
+
 			m_menu.append(m_helpMenuItem);
 				m_helpMenuItem.set_label("Help");
 				m_helpMenuItem.set_submenu(m_helpMenu);
@@ -582,6 +610,10 @@ void OscilloscopeWindow::CreateDefaultWaveformAreas(Gtk::Paned* split)
 
 bool OscilloscopeWindow::OnTimer(int /*timer*/)
 {
+	//Save a performance trace if requested by SIGUSR1
+	if(Tracer::m_dumpRequested.exchange(false))
+		Tracer::Dump(string("glscopeclient-trace-") + to_string(time(NULL)) + ".json");
+
 	//Don't process any trigger events, etc during file load
 	if(m_loadInProgress)
 		return true;
@@ -701,6 +733,7 @@ void OscilloscopeWindow::OnPreferenceDialogResponse(int response)
 		SyncFilterColors();
 		PopulateToolbar();
 		SetTitle();
+		ApplyMemoryPreferences();
 		for(auto w : m_waveformAreas)
 		{
 			w->SyncFontPreferences();
@@ -767,6 +800,12 @@ void OscilloscopeWindow::CloseSession()
 		delete m_exportWizard;
 		m_exportWizard = nullptr;
 	}
+	if(m_historySearchDialog)
+	{
+		m_historySearchDialog->hide();
+		delete m_historySearchDialog;
+		m_historySearchDialog = nullptr;
+	}
 
     //Save preferences
     m_preferences.SavePreferences();
@@ -1260,21 +1299,11 @@ void OscilloscopeWindow::LoadWaveformDataForScope(
 	{
 		iwave ++;
 
-		//Top level metadata
-		bool timebase_is_ps = true;
+		//Set up channel metadata first (serialized)
 		auto wfm = it.second;
-		time.first = wfm["timestamp"].as<long long>();
-		if(wfm["time_psec"])
-		{
-			time.second = wfm["time_psec"].as<long long>() * 1000;
-			timebase_is_ps = true;
-		}
-		else
-		{
-			time.second = wfm["time_fsec"].as<long long>();
-			timebase_is_ps = false;
-		}
-		int waveform_id = wfm["id"].as<int>();
+		vector<pair<int, int>> channels;	//pair<channel, stream>
+		vector<string> formats;
+		int waveform_id = PrepareHistoryWaveform(wfm, scope, time, channels, formats, datadir, scope_id, &m_waveformPool);
 		bool pinned = false;
 		if(wfm["pinned"])
 			pinned = wfm["pinned"].as<int>();
@@ -1282,66 +1311,6 @@ void OscilloscopeWindow::LoadWaveformDataForScope(
 		if(wfm["label"])
 			label = wfm["label"].as<string>();
 
-		//Set up channel metadata first (serialized)
-		auto chans = wfm["channels"];
-		vector<pair<int, int>> channels;	//pair<channel, stream>
-		vector<string> formats;
-		for(auto jt : chans)
-		{
-			auto ch = jt.second;
-			int channel_index = ch["index"].as<int>();
-			int stream = 0;
-			if(ch["stream"])
-				stream = ch["stream"].as<int>();
-			auto chan = scope->GetChannel(channel_index);
-			channels.push_back(pair<int, int>(channel_index, stream));
-
-			//Waveform format defaults to sparsev1 as that's what was used before
-			//the metadata file contained a format ID at all
-			string format = "sparsev1";
-			if(ch["format"])
-				format = ch["format"].as<string>();
-			formats.push_back(format);
-
-			bool dense = (format == "densev1");
-
-			//TODO: support non-analog/digital captures (eyes, spectrograms, etc)
-			WaveformBase* cap = NULL;
-			SparseAnalogWaveform* sacap = NULL;
-			UniformAnalogWaveform* uacap = NULL;
-			SparseDigitalWaveform* sdcap = NULL;
-			UniformDigitalWaveform* udcap = NULL;
-			if(chan->GetType(0) == Stream::STREAM_TYPE_ANALOG)
-			{
-				if(dense)
-					cap = uacap = new UniformAnalogWaveform;
-				else
-					cap = sacap = new SparseAnalogWaveform;
-			}
-			else
-			{
-				if(dense)
-					cap = udcap = new UniformDigitalWaveform;
-				else
-					cap = sdcap = new SparseDigitalWaveform;
-			}
-
-			//Channel waveform metadata
-			cap->m_timescale = ch["timescale"].as<long>();
-			cap->m_startTimestamp = time.first;
-			cap->m_startFemtoseconds = time.second;
-			if(timebase_is_ps)
-			{
-				cap->m_timescale *= 1000;
-				cap->m_triggerPhase = ch["trigphase"].as<float>() * 1000;
-			}
-			else
-				cap->m_triggerPhase = ch["trigphase"].as<long long>();
-
-			chan->Detach(stream);
-			chan->SetData(cap, stream);
-		}
-
 		//Kick off a thread to load data for each channel
 		vector<thread*> threads;
 		size_t nchans = channels.size();
@@ -1424,29 +1393,148 @@ void OscilloscopeWindow::LoadWaveformDataForScope(
 	window->JumpToHistory(newest);
 }
 
-void OscilloscopeWindow::DoLoadWaveformDataForScope(
-	int channel_index,
-	int stream,
+/**
+	@brief Creates empty waveforms for every channel of one saved history entry, with metadata from the session
+
+	The sample data itself is loaded afterwards by DoLoadWaveformDataForScope().
+
+	Any waveform already attached to a channel is detached but not freed, since in the interactive path it belongs to
+	the history. Callers with no history must detach and free it themselves.
+
+	@param wfm			Metadata node for the waveform
+	@param scope		The instrument the waveform came from
+	@param time			Set to the timestamp of the waveform
+	@param channels		Set to the (channel, stream) pairs in the waveform
+	@param formats		Set to the sample format of each channel
+	@param datadir		Data directory of the session
+	@param scope_id		ID of the scope within the session
+	@param pool			If not null, new waveforms are taken from this pool rather than allocated
+
+	@return ID of the waveform within the data directory
+ */
+int OscilloscopeWindow::PrepareHistoryWaveform(
+	const YAML::Node& wfm,
 	Oscilloscope* scope,
-	string datadir,
+	TimePoint& time,
+	vector<pair<int, int>>& channels,
+	vector<string>& formats,
+	const string& datadir,
 	int scope_id,
-	int waveform_id,
-	string format,
-	volatile float* progress,
-	volatile int* done
-	)
+	WaveformPool* pool)
 {
-	auto chan = scope->GetChannel(channel_index);
+	int waveform_id = wfm["id"].as<int>();
 
-	auto cap = chan->GetData(stream);
-	auto sacap = dynamic_cast<SparseAnalogWaveform*>(cap);
-	auto uacap = dynamic_cast<UniformAnalogWaveform*>(cap);
-	auto sdcap = dynamic_cast<SparseDigitalWaveform*>(cap);
-	auto udcap = dynamic_cast<UniformDigitalWaveform*>(cap);
+	//Top level metadata
+	bool timebase_is_ps = true;
+	time.first = wfm["timestamp"].as<long long>();
+	if(wfm["time_psec"])
+	{
+		time.second = wfm["time_psec"].as<long long>() * 1000;
+		timebase_is_ps = true;
+	}
+	else
+	{
+		time.second = wfm["time_fsec"].as<long long>();
+		timebase_is_ps = false;
+	}
+
+	//Set up channel metadata first (serialized)
+	auto chans = wfm["channels"];
+	for(auto jt : chans)
+	{
+		auto ch = jt.second;
+		int channel_index = ch["index"].as<int>();
+		int stream = 0;
+		if(ch["stream"])
+			stream = ch["stream"].as<int>();
+		auto chan = scope->GetChannel(channel_index);
+		channels.push_back(pair<int, int>(channel_index, stream));
+
+		//Waveform format defaults to sparsev1 as that's what was used before
+		//the metadata file contained a format ID at all
+		string format = "sparsev1";
+		if(ch["format"])
+			format = ch["format"].as<string>();
+		formats.push_back(format);
+
+		bool dense = (format == "densev1");
+
+		//TODO: support non-analog/digital captures (eyes, spectrograms, etc)
+		WaveformBase* cap = NULL;
+		SparseAnalogWaveform* sacap = NULL;
+		UniformAnalogWaveform* uacap = NULL;
+		SparseDigitalWaveform* sdcap = NULL;
+		UniformDigitalWaveform* udcap = NULL;
+		bool analog = (chan->GetType(0) == Stream::STREAM_TYPE_ANALOG);
+
+		//Size the pooled buffer for the saved depth, so we don't get handed the largest one in the pool
+		size_t depth = 0;
+		if(pool)
+		{
+			depth = GetHistoryChannelDepth(
+				GetHistoryChannelFileName(datadir, scope_id, waveform_id, channel_index, stream),
+				format,
+				analog);
+		}
 
-	cap->PrepareForCpuAccess();
+		if(analog)
+		{
+			if(pool)
+			{
+				if(dense)
+					cap = uacap = pool->Get<UniformAnalogWaveform>(depth);
+				else
+					cap = sacap = pool->Get<SparseAnalogWaveform>(depth);
+			}
+			else if(dense)
+				cap = uacap = new UniformAnalogWaveform;
+			else
+				cap = sacap = new SparseAnalogWaveform;
+		}
+		else
+		{
+			if(pool)
+			{
+				if(dense)
+					cap = udcap = pool->Get<UniformDigitalWaveform>(depth);
+				else
+					cap = sdcap = pool->Get<SparseDigitalWaveform>(depth);
+			}
+			else if(dense)
+				cap = udcap = new UniformDigitalWaveform;
+			else
+				cap = sdcap = new SparseDigitalWaveform;
+		}
 
-	//Load the actual sample data
+		//Channel waveform metadata
+		cap->m_timescale = ch["timescale"].as<long>();
+		cap->m_startTimestamp = time.first;
+		cap->m_startFemtoseconds = time.second;
+		if(timebase_is_ps)
+		{
+			cap->m_timescale *= 1000;
+			cap->m_triggerPhase = ch["trigphase"].as<float>() * 1000;
+		}
+		else
+			cap->m_triggerPhase = ch["trigphase"].as<long long>();
+
+		chan->Detach(stream);
+		chan->SetData(cap, stream);
+	}
+
+	return waveform_id;
+}
+
+/**
+	@brief Gets the path of the sample data file for one channel of a saved history entry
+ */
+string OscilloscopeWindow::GetHistoryChannelFileName(
+	const string& datadir,
+	int scope_id,
+	int waveform_id,
+	int channel_index,
+	int stream)
+{
 	char tmp[512];
 	if(stream == 0)
 	{
@@ -1465,6 +1553,65 @@ void OscilloscopeWindow::DoLoadWaveformDataForScope(
 			channel_index,
 			stream);
 	}
+	return tmp;
+}
+
+/**
+	@brief Figures out how many samples a saved channel holds from the size of its data file
+
+	@return Sample count, or zero if the file can't be read or the format is unknown
+ */
+size_t OscilloscopeWindow::GetHistoryChannelDepth(const string& fname, const string& format, bool analog)
+{
+	//Must match the layouts parsed by DoLoadWaveformDataForScope()
+	size_t samplesize;
+	if(format == "sparsev1")
+		samplesize = 2*sizeof(int64_t) + (analog ? sizeof(float) : sizeof(bool));
+	else if(format == "densev1")
+		samplesize = analog ? sizeof(float) : sizeof(bool);
+	else
+		return 0;
+
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if(!fp)
+		return 0;
+	fseek(fp, 0, SEEK_END);
+	long len = ftell(fp);
+	fclose(fp);
+	if(len <= 0)
+		return 0;
+
+	return len / samplesize;
+}
+
+void OscilloscopeWindow::DoLoadWaveformDataForScope(
+	int channel_index,
+	int stream,
+	Oscilloscope* scope,
+	string datadir,
+	int scope_id,
+	int waveform_id,
+	string format,
+	volatile float* progress,
+	volatile int* done
+	)
+{
+	pthread_setname_np_compat("HistoryLoad");
+	TraceSpan span("LoadWaveformData");
+
+	auto chan = scope->GetChannel(channel_index);
+
+	auto cap = chan->GetData(stream);
+	auto sacap = dynamic_cast<SparseAnalogWaveform*>(cap);
+	auto uacap = dynamic_cast<UniformAnalogWaveform*>(cap);
+	auto sdcap = dynamic_cast<SparseDigitalWaveform*>(cap);
+	auto udcap = dynamic_cast<UniformDigitalWaveform*>(cap);
+
+	cap->PrepareForCpuAccess();
+
+	//Load the actual sample data
+	string fname = GetHistoryChannelFileName(datadir, scope_id, waveform_id, channel_index, stream);
+	const char* tmp = fname.c_str();
 
 	//Load samples into memory
 	unsigned char* buf = NULL;
@@ -1611,6 +1758,143 @@ void OscilloscopeWindow::DoLoadWaveformDataForScope(
 	*progress = 1;
 }
 
+/**
+	@brief Creates an import filter for a file, based on its extension
+
+	The file name isn't set, since that's what triggers the actual parsing.
+
+	@param fname	Path to the file
+	@param param	Set to the name of the filter parameter the file name goes in
+
+	@return The filter, or nullptr if the extension isn't recognized
+ */
+Filter* OscilloscopeWindow::CreateImportFilter(const string& fname, string& param)
+{
+	static const char* formats[][2] =
+	{
+		{ ".wav",		"WAV" },
+		{ ".bin",		"BIN" },
+		{ ".complex",	"Complex" },	//Complex I/Q: user probably will have to override format specifics later
+		{ ".csv",		"CSV" },
+		{ ".trc",		"TRC" },
+		{ ".vcd",		"VCD" },
+		{ ".wfm",		"WFM" }
+	};
+
+	string type;
+	for(auto& f : formats)
+	{
+		if(fname.find(f[0]) != string::npos)
+		{
+			type = f[1];
+			break;
+		}
+	}
+	if(type.empty() && (fname.find(".s") != string::npos) && (fname[fname.length()-1] == 'p') )
+		type = "Touchstone";
+	if(type.empty())
+		return nullptr;
+
+	param = type + " File";
+	return Filter::CreateFilter(type + " Import", GetDefaultChannelColor(g_numDecodes ++));
+}
+
+/**
+	@brief Imports a batch of waveform files, parsing them in parallel
+
+	Filters are created up front, then a pool of worker threads parses the files while we show progress. Channels
+	are only added to the UI once everything has loaded.
+ */
+void OscilloscopeWindow::ImportFiles(const vector<string>& files)
+{
+	//Create the filters
+	vector<ImportJob> jobs;
+	for(auto& f : files)
+	{
+		ImportJob job;
+		job.m_fname = f;
+		job.m_filter = CreateImportFilter(f, job.m_param);
+		if(!job.m_filter)
+		{
+			LogError("Unrecognized file extension, ignoring %s\n", f.c_str());
+			continue;
+		}
+		jobs.push_back(job);
+	}
+	if(jobs.empty())
+		return;
+
+	//Create and show progress dialog
+	FileProgressDialog progress;
+	progress.show();
+
+	//Kick off the worker pool
+	atomic<size_t> nextJob(0);
+	atomic<size_t> jobsDone(0);
+	size_t nthreads = min((size_t)max(thread::hardware_concurrency(), 1U), jobs.size());
+	vector<thread*> threads;
+	for(size_t i=0; i<nthreads; i++)
+		threads.push_back(new thread(&OscilloscopeWindow::DoImportFiles, &jobs, &nextJob, &jobsDone));
+
+	//Process events and update the display as files finish
+	while(true)
+	{
+		size_t done = jobsDone;
+		if(done == jobs.size())
+			break;
+
+		char tmp[256];
+		snprintf(tmp, sizeof(tmp), "Importing files: %zu/%zu complete", done, jobs.size());
+		progress.Update(tmp, done * 1.0f / jobs.size());
+		std::this_thread::sleep_for(std::chrono::microseconds(1000 * 50));
+
+		g_app->DispatchPendingEvents();
+	}
+
+	//Wait for threads to complete
+	for(auto t : threads)
+	{
+		t->join();
+		delete t;
+	}
+
+	//Name the filters and add all of their streams
+	for(auto& job : jobs)
+	{
+		string base = BaseName(job.m_fname);
+		size_t dot = base.find('.');
+		if(dot != string::npos)
+			base = base.substr(0, dot);
+		job.m_filter->SetDisplayName(base);
+
+		for(size_t i=0; i<job.m_filter->GetStreamCount(); i++)
+			OnAddChannel(StreamDescriptor(job.m_filter, i));
+	}
+}
+
+/**
+	@brief Worker thread for ImportFiles(): parses files until there are none left
+ */
+void OscilloscopeWindow::DoImportFiles(vector<ImportJob>* jobs, atomic<size_t>* nextJob, atomic<size_t>* jobsDone)
+{
+	pthread_setname_np_compat("ImportFiles");
+
+	while(true)
+	{
+		size_t i = (*nextJob) ++;
+		if(i >= jobs->size())
+			break;
+
+		TraceSpan span("ImportFile");
+
+		//Setting the file name is what makes the filter load it
+		auto& job = (*jobs)[i];
+		job.m_filter->GetParameter(job.m_param).SetFileName(job.m_fname);
+
+		(*jobsDone) ++;
+	}
+}
+
 /**
 	@brief Apply driver preferences to an instrument
  */
@@ -1627,6 +1911,14 @@ void OscilloscopeWindow::ApplyPreferences(Oscilloscope* scope)
 	}
 }
 
+/**
+	@brief Apply preference settings for the waveform pool
+ */
+void OscilloscopeWindow::ApplyMemoryPreferences()
+{
+	m_waveformPool.SetMaxBytes(m_preferences.GetInt("Memory.waveform_pool_size") * 1024LL * 1024LL);
+}
+
 /**
 	@brief Reconnect to existing instruments and reconfigure them
  */
@@ -1719,17 +2011,7 @@ void OscilloscopeWindow::LoadInstruments(const YAML::Node& node, bool reconnect,
 		}
 
 		if(!scope)
-		{
-			//Create the mock scope
-			scope = new MockOscilloscope(
-				inst["name"].as<string>(),
-				inst["vendor"].as<string>(),
-				inst["serial"].as<string>(),
-				transtype,
-				driver,
-				inst["args"].as<string>()
-				);
-		}
+			scope = CreateOfflineInstrument(inst);
 
 		//Make any config settings to the instrument from our preference settings
 		ApplyPreferences(scope);
@@ -1747,10 +2029,49 @@ void OscilloscopeWindow::LoadInstruments(const YAML::Node& node, bool reconnect,
 	}
 }
 
+/**
+	@brief Creates a mock instrument for offline analysis of a saved instrument
+ */
+Oscilloscope* OscilloscopeWindow::CreateOfflineInstrument(const YAML::Node& inst)
+{
+	return new MockOscilloscope(
+		inst["name"].as<string>(),
+		inst["vendor"].as<string>(),
+		inst["serial"].as<string>(),
+		inst["transport"].as<string>(),
+		inst["driver"].as<string>(),
+		inst["args"].as<string>()
+		);
+}
+
 /**
 	@brief Load protocol decoder configuration
  */
 void OscilloscopeWindow::LoadDecodes(const YAML::Node& node, IDTable& table)
+{
+	vector<string> failed;
+	LoadFilters(node, table, failed);
+
+	for(auto proto : failed)
+	{
+		Gtk::MessageDialog dlg(
+			string("Unable to create filter \"") + proto + "\". Skipping...\n",
+			false,
+			Gtk::MESSAGE_ERROR,
+			Gtk::BUTTONS_OK,
+			true);
+		dlg.run();
+	}
+}
+
+/**
+	@brief Creates and configures the filters in a session, without touching the UI
+
+	@param node		The "decodes" node of the session
+	@param table	ID table for the session
+	@param failed	Set to the names of any filters that couldn't be created
+ */
+void OscilloscopeWindow::LoadFilters(const YAML::Node& node, IDTable& table, vector<string>& failed)
 {
 	//No protocol decodes? Skip this section
 	if(!node)
@@ -1766,13 +2087,7 @@ void OscilloscopeWindow::LoadDecodes(const YAML::Node& node, IDTable& table)
 		auto filter = Filter::CreateFilter(proto, dnode["color"].as<string>());
 		if(filter == NULL)
 		{
-			Gtk::MessageDialog dlg(
-				string("Unable to create filter \"") + proto + "\". Skipping...\n",
-				false,
-				Gtk::MESSAGE_ERROR,
-				Gtk::BUTTONS_OK,
-				true);
-			dlg.run();
+			failed.push_back(proto);
 			continue;
 		}
 
@@ -1891,11 +2206,14 @@ void OscilloscopeWindow::LoadUIConfiguration(const YAML::Node& node, IDTable& ta
 				if(statnode["stream"])
 					stream = statnode["stream"].as<long>();
 
-				group->EnableStats(
-					StreamDescriptor(
-						static_cast<OscilloscopeChannel*>(table[statnode["channel"].as<long>()]),
-						stream),
-					statnode["index"].as<long>());
+				StreamDescriptor desc(
+					static_cast<OscilloscopeChannel*>(table[statnode["channel"].as<long>()]),
+					stream);
+				group->EnableStats(desc, statnode["index"].as<long>());
+
+				auto accum = statnode["accumulated"];
+				if(accum)
+					group->LoadAccumulatedStatistics(desc, accum);
 			}
 		}
 
@@ -3144,13 +3462,8 @@ bool OscilloscopeWindow::CheckForPendingWaveforms()
 		return m_triggerArmed;
 
 	//Wait for every online scope to have triggered
-	for(auto scope : m_scopes)
-	{
-		if(scope->IsOffline())
-			continue;
-		if(!scope->HasPendingWaveforms())
-			return false;
-	}
+	if(!WaveformPipeline::HasPendingWaveforms(m_scopes))
+		return false;
 
 	//Keep track of when the primary instrument triggers.
 	if(m_multiScopeFreeRun)
@@ -3196,83 +3509,15 @@ bool OscilloscopeWindow::CheckForPendingWaveforms()
  */
 void OscilloscopeWindow::DownloadWaveforms()
 {
+	TraceSpan lockSpan("Lock waveform data");
 	lock_guard<recursive_mutex> lock(m_waveformDataMutex);
+	lockSpan.End();
 
-	//Process the waveform data from each instrument
-	for(auto scope : m_scopes)
-	{
-		//Don't touch anything offline
-		if(scope->IsOffline())
-			continue;
-
-		//Make sure we don't free the old waveform data
-		for(size_t i=0; i<scope->GetChannelCount(); i++)
-		{
-			auto chan = scope->GetChannel(i);
-			for(size_t j=0; j<chan->GetStreamCount(); j++)
-				chan->Detach(j);
-		}
-
-		//Download the data
-		scope->PopPendingWaveform();
-	}
+	WaveformPipeline::DownloadWaveforms(m_scopes, m_scopeDeskewCal);
 
 	//If we're in offline one-shot mode, disarm the trigger
 	if( (m_scopes.empty()) && m_triggerOneShot)
 		m_triggerArmed = false;
-
-	//In multi-scope mode, retcon the timestamps of secondary scopes' waveforms so they line up with the primary.
-	if(m_scopes.size() > 1)
-	{
-		LogTrace("Multi scope: patching timestamps\n");
-		LogIndenter li;
-
-		//Get the timestamp of the primary scope's first waveform
-		bool hit = false;
-		time_t timeSec = 0;
-		int64_t timeFs  = 0;
-		auto prim = m_scopes[0];
-		for(size_t i=0; i<prim->GetChannelCount(); i++)
-		{
-			auto chan = prim->GetChannel(i);
-			for(size_t j=0; j<chan->GetStreamCount(); j++)
-			{
-				auto data = chan->GetData(j);
-				if(data != nullptr)
-				{
-					timeSec = data->m_startTimestamp;
-					timeFs = data->m_startFemtoseconds;
-					hit = true;
-					break;
-				}
-			}
-			if(hit)
-				break;
-		}
-
-		//Patch all secondary scopes
-		for(size_t i=1; i<m_scopes.size(); i++)
-		{
-			auto sec = m_scopes[i];
-
-			for(size_t j=0; j<sec->GetChannelCount(); j++)
-			{
-				auto chan = sec->GetChannel(j);
-				for(size_t k=0; k<chan->GetStreamCount(); k++)
-				{
-					auto data = chan->GetData(k);
-					if(data == nullptr)
-						continue;
-
-					auto skew = m_scopeDeskewCal[sec];
-
-					data->m_startTimestamp = timeSec;
-					data->m_startFemtoseconds = timeFs;
-					data->m_triggerPhase -= skew;
-				}
-			}
-		}
-	}
 }
 
 /**
@@ -3280,7 +3525,10 @@ void OscilloscopeWindow::DownloadWaveforms()
  */
 void OscilloscopeWindow::OnAllWaveformsUpdated(bool reconfiguring, bool updateFilters)
 {
+	TraceSpan lockSpan("Lock waveform data");
 	lock_guard<recursive_mutex> lock(m_waveformDataMutex);
+	lockSpan.End();
+	TraceSpan span("OnAllWaveformsUpdated");
 
 	m_totalWaveforms ++;
 
@@ -3289,6 +3537,13 @@ void OscilloscopeWindow::OnAllWaveformsUpdated(bool reconfiguring, bool updateFi
 	if(updateFilters)
 		RefreshAllFilters();
 
+	//Don't hang on to recycled waveforms if the system is running out of RAM
+	m_waveformPool.CheckMemoryPressure(
+		m_preferences.GetInt("Memory.low_memory_threshold") * 1024LL * 1024LL);
+
+	//Update statistic displays with whatever the engine most recently published
+	RefreshAllMeasurements();
+
 	//Update protocol analyzers
 	//TODO: ideal would be to delete all old packets from analyzers then update them with current ones.
 	//This would allow changing settings on a protocol to update correctly.
@@ -3363,33 +3618,16 @@ void OscilloscopeWindow::OnAllWaveformsUpdated(bool reconfiguring, bool updateFi
 			OnStop();
 
 			if(m_haltConditionsDialog.ShouldMoveToHalt())
-			{
-				//Find the waveform area(s) for this channel
-				for(auto a : m_waveformAreas)
-				{
-					if(a->GetChannel() == chan)
-					{
-						a->m_group->m_xAxisOffset = timestamp;
-						a->m_group->m_frame.queue_draw();
-					}
-
-					for(size_t i=0; i<a->GetOverlayCount(); i++)
-					{
-						if(a->GetOverlay(i) == chan)
-						{
-							a->m_group->m_xAxisOffset = timestamp;
-							a->m_group->m_frame.queue_draw();
-						}
-					}
-				}
-			}
+				MoveViewToTimestamp(chan, timestamp);
 		}
 	}
 }
 
 void OscilloscopeWindow::RefreshAllFilters()
 {
+	TraceSpan lockSpan("Lock waveform data");
 	lock_guard<recursive_mutex> lock(m_waveformDataMutex);
+	lockSpan.End();
 
 	SyncFilterColors();
 
@@ -3398,13 +3636,32 @@ void OscilloscopeWindow::RefreshAllFilters()
 		lock_guard<mutex> lock2(m_filterUpdatingMutex);
 		filters = Filter::GetAllInstances();
 	}
-	m_graphExecutor.RunBlocking(filters);
+	WaveformPipeline::RefreshFilters(filters, m_graphExecutor, m_filterProfiler, m_statisticsEngine);
+}
 
-	//Update statistic displays after the filter graph update is complete
+/**
+	@brief Updates every measurement view with the most recently published statistics
+
+	Must be called from the GUI thread after anything there calls RefreshAllFilters().
+ */
+void OscilloscopeWindow::RefreshAllMeasurements()
+{
+	TraceSpan span("RefreshMeasurements");
 	for(auto g : m_waveformGroups)
 		g->RefreshMeasurements();
 }
 
+/**
+	@brief Tells the statistics engine which statistics are currently being displayed
+ */
+void OscilloscopeWindow::UpdateStatisticsRequests()
+{
+	vector<StatisticsRequest> requests;
+	for(auto g : m_waveformGroups)
+		g->GetStatisticsRequests(requests);
+	m_statisticsEngine.SetRequests(requests);
+}
+
 void OscilloscopeWindow::RefreshAllViews()
 {
 	for(auto g : m_waveformGroups)
@@ -3589,6 +3846,7 @@ void OscilloscopeWindow::OnHistoryUpdated()
 	OnStop();
 
 	RefreshAllFilters();
+	RefreshAllMeasurements();
 
 	//Update the views
 	for(auto w : m_waveformAreas)
@@ -3623,6 +3881,40 @@ void OscilloscopeWindow::JumpToHistory(TimePoint timestamp, HistoryWindow* src)
 	}
 }
 
+/**
+	@brief Gets every acquisition from every history window
+ */
+void OscilloscopeWindow::GetHistoryEntries(vector<HistoryEntry>& entries)
+{
+	for(auto it : m_historyWindows)
+		it.second->GetEntries(entries);
+}
+
+/**
+	@brief Scrolls every waveform group displaying a given stream so the given timestamp is at the left edge
+ */
+void OscilloscopeWindow::MoveViewToTimestamp(StreamDescriptor chan, int64_t timestamp)
+{
+	//Find the waveform area(s) for this channel
+	for(auto a : m_waveformAreas)
+	{
+		if(a->GetChannel() == chan)
+		{
+			a->m_group->m_xAxisOffset = timestamp;
+			a->m_group->m_frame.queue_draw();
+		}
+
+		for(size_t i=0; i<a->GetOverlayCount(); i++)
+		{
+			if(a->GetOverlay(i) == chan)
+			{
+				a->m_group->m_xAxisOffset = timestamp;
+				a->m_group->m_frame.queue_draw();
+			}
+		}
+	}
+}
+
 void OscilloscopeWindow::OnTimebaseSettings()
 {
 	if(!m_timebasePropertiesDialog)
@@ -3696,6 +3988,57 @@ void OscilloscopeWindow::OnHaltConditions()
 	m_haltConditionsDialog.RefreshChannels();
 }
 
+/**
+	@brief Shows the history search dialog
+ */
+void OscilloscopeWindow::OnHistorySearch()
+{
+	if(!m_historySearchDialog)
+		m_historySearchDialog = new HistorySearchDialog(this);
+	else
+		m_historySearchDialog->RefreshChannels();
+	m_historySearchDialog->show();
+}
+
+/**
+	@brief Cancels any history search in progress
+
+	Search threads hold pointers into the history, so this must be called before deleting any history waveforms.
+ */
+void OscilloscopeWindow::StopHistorySearch()
+{
+	if(m_historySearchDialog)
+		m_historySearchDialog->StopSearch();
+}
+
+void OscilloscopeWindow::OnTraceRecord()
+{
+	Tracer::Enable(m_windowTraceRecordItem.get_active());
+}
+
+/**
+	@brief Saves the performance trace in Chrome trace event format
+ */
+void OscilloscopeWindow::OnTraceSave()
+{
+	Gtk::FileChooserDialog dlg(*this, "Save Performance Trace", Gtk::FILE_CHOOSER_ACTION_SAVE);
+
+	auto filter = Gtk::FileFilter::create();
+	filter->add_pattern("*.json");
+	filter->set_name("Chrome trace event files (*.json)");
+	dlg.add_filter(filter);
+	dlg.add_button("Save", Gtk::RESPONSE_OK);
+	dlg.add_button("Cancel", Gtk::RESPONSE_CANCEL);
+	dlg.set_current_name("glscopeclient-trace.json");
+	dlg.set_do_overwrite_confirmation();
+	auto response = dlg.run();
+
+	if(response != Gtk::RESPONSE_OK)
+		return;
+
+	Tracer::Dump(dlg.get_filename());
+}
+
 /**
 	@brief Generate a new waveform using a filter
  */
@@ -44,9 +44,14 @@
 #include "HistoryWindow.h"
 #include "ScopeSyncWizard.h"
 #include "HaltConditionsDialog.h"
+#include "HistorySearchDialog.h"
 #include "FileProgressDialog.h"
 #include "PreferenceManager.h"
 #include "FilterGraphEditor.h"
+#include "FilterGraphProfiler.h"
+#include "StatisticsEngine.h"
+#include "WaveformPipeline.h"
+#include "WaveformPool.h"
 #include "../xptools/HzClock.h"
 #include "Marker.h"
 
@@ -120,6 +125,8 @@ public:
 	void OnMarkerNameChanged(Marker* m);
 
 	void JumpToHistory(TimePoint timestamp, HistoryWindow* src = nullptr);
+	void GetHistoryEntries(std::vector<HistoryEntry>& entries);
+	void MoveViewToTimestamp(StreamDescriptor chan, int64_t timestamp);
 
 	std::string GetEyeColor()
 	{ return m_eyeColor; }
@@ -218,6 +225,7 @@ protected:
 			Gtk::MenuItem m_windowMenuItem;
 				Gtk::Menu m_windowMenu;
 					Gtk::MenuItem m_windowFilterGraphItem;
+					Gtk::MenuItem m_windowHistorySearchItem;
 					Gtk::MenuItem m_windowAnalyzerMenuItem;
 						Gtk::Menu m_windowAnalyzerMenu;
 					Gtk::MenuItem m_windowGeneratorMenuItem;
@@ -228,6 +236,11 @@ protected:
 						Gtk::Menu m_windowScopeInfoMenu;
 					Gtk::MenuItem m_windowScpiConsoleMenuItem;
 						Gtk::Menu m_windowScpiConsoleMenu;
+					Gtk::MenuItem m_windowTraceMenuItem;
+						Gtk::Menu m_windowTraceMenu;
+							Gtk::CheckMenuItem m_windowTraceRecordItem;
+							Gtk::MenuItem m_windowTraceClearItem;
+							Gtk::MenuItem m_windowTraceSaveItem;
 			Gtk::MenuItem m_helpMenuItem;
 				Gtk::Menu m_helpMenu;
 					Gtk::MenuItem m_aboutMenuItem;
@@ -283,8 +296,11 @@ public:
 	void ConnectToScope(std::string path);
 	void OnFileOpen(bool reconnect);
 	void DoFileOpen(const std::string& filename, bool loadWaveform = true, bool reconnect = true);
+	void ImportFiles(const std::vector<std::string>& files);
 	void LoadInstruments(const YAML::Node& node, bool reconnect, IDTable& table);
 	void LoadDecodes(const YAML::Node& node, IDTable& table);
+	static void LoadFilters(const YAML::Node& node, IDTable& table, std::vector<std::string>& failed);
+	static Oscilloscope* CreateOfflineInstrument(const YAML::Node& inst);
 	void LoadUIConfiguration(const YAML::Node& node, IDTable& table);
 	void LoadWaveformData(std::string filename, IDTable& table);
 	void LoadWaveformDataForScope(
@@ -295,6 +311,22 @@ public:
 		FileProgressDialog& progress,
 		float base_progress,
 		float progress_range);
+	static int PrepareHistoryWaveform(
+		const YAML::Node& wfm,
+		Oscilloscope* scope,
+		TimePoint& time,
+		std::vector<std::pair<int, int>>& channels,
+		std::vector<std::string>& formats,
+		const std::string& datadir,
+		int scope_id,
+		WaveformPool* pool = NULL);
+	static std::string GetHistoryChannelFileName(
+		const std::string& datadir,
+		int scope_id,
+		int waveform_id,
+		int channel_index,
+		int stream);
+	static size_t GetHistoryChannelDepth(const std::string& fname, const std::string& format, bool analog);
 	static void DoLoadWaveformDataForScope(
 		int channel_index,
 		int stream,
@@ -306,6 +338,21 @@ public:
 		volatile float* progress,
 		volatile int* done
 		);
+
+	///@brief A file being loaded by ImportFiles()
+	class ImportJob
+	{
+	public:
+		std::string m_fname;
+		std::string m_param;
+		Filter* m_filter;
+	};
+
+	static Filter* CreateImportFilter(const std::string& fname, std::string& param);
+	static void DoImportFiles(
+		std::vector<ImportJob>* jobs,
+		std::atomic<size_t>* nextJob,
+		std::atomic<size_t>* jobsDone);
 	void OnEyeColorChanged(std::string color, Gtk::RadioMenuItem* item);
 	void OnTriggerProperties(Oscilloscope* scope);
 	void OnFullscreen();
@@ -319,6 +366,9 @@ public:
 	void OnShowFunctionGenerator(FunctionGenerator* gen);
 	void OnShowSCPIConsole(SCPIDevice* device);
 	void OnFilterGraph();
+	void OnHistorySearch();
+	void OnTraceRecord();
+	void OnTraceSave();
 	void OnAddMultimeter();
 	void ConnectToMultimeter(std::string path);
 	SCPITransport* ConnectToTransport(const std::string& name, const std::string& args);
@@ -365,6 +415,7 @@ public:
 	//Protocol decoding etc
 	std::mutex m_filterUpdatingMutex;
 	void RefreshAllFilters();
+	void RefreshAllMeasurements();
 	void RefreshAllViews();
 	void SyncFilterColors();
 
@@ -429,6 +480,7 @@ public:
 	PreferenceDialog* m_preferenceDialog{nullptr};
 	FilterGraphEditor* m_graphEditor;
 	HaltConditionsDialog m_haltConditionsDialog;
+	HistorySearchDialog* m_historySearchDialog;
 	TimebasePropertiesDialog* m_timebasePropertiesDialog;
 	void RefreshTimebasePropertiesDialog();
 	FilterDialog* m_addFilterDialog;
@@ -488,7 +540,32 @@ public:
 	//Filter graph evaluation
 	FilterGraphExecutor m_graphExecutor;
 
+public:
 	void ApplyPreferences(Oscilloscope* scope);
+
+	FilterGraphProfiler& GetFilterProfiler()
+	{ return m_filterProfiler; }
+
+	StatisticsEngine& GetStatisticsEngine()
+	{ return m_statisticsEngine; }
+
+	void UpdateStatisticsRequests();
+
+	WaveformPool& GetWaveformPool()
+	{ return m_waveformPool; }
+
+	void StopHistorySearch();
+
+protected:
+	FilterGraphProfiler m_filterProfiler;
+
+	//Measurement statistics, evaluated whenever the filter graph is refreshed
+	StatisticsEngine m_statisticsEngine;
+
+	//Waveforms discarded from history, kept for reuse
+	WaveformPool m_waveformPool;
+
+	void ApplyMemoryPreferences();
 };
 
 #endif
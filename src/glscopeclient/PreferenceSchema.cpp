@@ -294,6 +294,22 @@ void PreferenceManager::InitializeDefaults()
 			.Description("Maximum number of recent .scopesession file paths to save in history")
 			.Unit(Unit::UNIT_COUNTS));
 
+	auto& memory = this->m_treeRoot.AddCategory("Memory");
+		memory.AddPreference(
+			Preference::Int("waveform_pool_size", 1024)
+			.Label("Waveform pool size (MB)")
+			.Description(
+				"Maximum amount of memory used to keep waveforms deleted from history around for reuse.\n\n"
+				"Reusing waveforms avoids reallocating large sample buffers on every trigger. Larger values help "
+				"when capturing many channels or very deep memory."
+			));
+		memory.AddPreference(
+			Preference::Int("low_memory_threshold", 512)
+			.Label("Low memory threshold (MB)")
+			.Description(
+				"If free system memory drops below this amount, all waveforms kept for reuse are freed."
+			));
+
 	auto& privacy = this->m_treeRoot.AddCategory("Privacy");
 		 privacy.AddPreference(
 			Preference::Bool("redact_serial_in_title", false)
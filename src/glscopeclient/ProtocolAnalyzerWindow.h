@@ -207,6 +207,9 @@ public:
 	PacketDecoder* GetDecoder()
 	{ return m_decoder; }
 
+	const ProtocolTreeChildren& GetPacketRows()
+	{ return m_internalmodel->GetRows(); }
+
 	void SelectPacket(TimePoint cap, int64_t offset);
 
 protected:
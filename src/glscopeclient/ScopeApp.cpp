@@ -68,6 +68,7 @@ void ScopeApp::run(
 	add_window(*m_window);
 
 	//Handle file loads specified on the command line
+	vector<string> imports;
 	for(auto f : filesToLoad)
 	{
 		//Ignore blank files (should never happen)
@@ -81,76 +82,10 @@ void ScopeApp::run(
 			break;
 		}
 
-		//For any external file format, create an import filter
-		Filter* filter = NULL;
-		string color = GetDefaultChannelColor(g_numDecodes ++);
-
-		if(f.find(".wav") != string::npos)
-		{
-			filter = Filter::CreateFilter("WAV Import", color);
-			filter->GetParameter("WAV File").SetFileName(f);
-		}
-
-		else if(f.find(".bin") != string::npos)
-		{
-			filter = Filter::CreateFilter("BIN Import", color);
-			filter->GetParameter("BIN File").SetFileName(f);
-		}
-
-		//Complex I/Q: user probably will have to override format specifics later
-		else if(f.find(".complex") != string::npos)
-		{
-			filter = Filter::CreateFilter("Complex Import", color);
-			filter->GetParameter("Complex File").SetFileName(f);
-		}
-
-		else if(f.find(".csv") != string::npos)
-		{
-			filter = Filter::CreateFilter("CSV Import", color);
-			filter->GetParameter("CSV File").SetFileName(f);
-		}
-
-		else if(f.find(".trc") != string::npos)
-		{
-			filter = Filter::CreateFilter("TRC Import", color);
-			filter->GetParameter("TRC File").SetFileName(f);
-		}
-
-		else if(f.find(".vcd") != string::npos)
-		{
-			filter = Filter::CreateFilter("VCD Import", color);
-			filter->GetParameter("VCD File").SetFileName(f);
-		}
-
-		else if(f.find(".wfm") != string::npos)
-		{
-			filter = Filter::CreateFilter("WFM Import", color);
-			filter->GetParameter("WFM File").SetFileName(f);
-		}
-
-		else if( (f.find(".s") != string::npos) && (f[f.length()-1] == 'p') )
-		{
-			filter = Filter::CreateFilter("Touchstone Import", color);
-			filter->GetParameter("Touchstone File").SetFileName(f);
-		}
-
-		else
-		{
-			LogError("Unrecognized file extension, ignoring %s\n", f.c_str());
-			continue;
-		}
-
-		//Name the filter
-		string base = BaseName(f);
-		size_t dot = base.find('.');
-		if(dot != string::npos)
-			base = base.substr(0, dot);
-		filter->SetDisplayName(base);
-
-		//Add all of the streams
-		for(size_t i=0; i<filter->GetStreamCount(); i++)
-			m_window->OnAddChannel(StreamDescriptor(filter, i));
+		//Anything else is an external file format, import them all at once
+		imports.push_back(f);
 	}
+	m_window->ImportFiles(imports);
 
 	m_window->present();
 
@@ -38,9 +38,17 @@
 #ifdef __x86_64__
 #include <immintrin.h>
 #endif
+#include <ffts.h>
 
 using namespace std;
 
+//Brute force correlation is O(N*L) so keep the window small there, the FFT path doesn't care
+static const int64_t MAX_SKEW_SAMPLES_BRUTE_FORCE = 10000;
+static const int64_t MAX_SKEW_SAMPLES_FFT = 1000000;
+
+//Upper bound on resampled waveform length for the FFT path, so a tiny sparse timescale can't blow up memory
+static const size_t MAX_FFT_GRID_POINTS = 64 * 1024 * 1024;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ScopeSyncDeskewWelcomePage
 
@@ -188,6 +196,7 @@ ScopeSyncWizard::ScopeSyncWizard(OscilloscopeWindow* parent)
 	, m_activeSetupPage(NULL)
 	, m_activeSecondaryPage(NULL)
 	, m_bestCorrelationOffset(0)
+	, m_bestCorrelationSkew(0)
 	, m_bestCorrelation(0)
 	, m_primaryWaveform(0)
 	, m_secondaryWaveform(0)
@@ -405,12 +414,13 @@ void ScopeSyncWizard::OnWaveformDataReady()
 	//Set up state
 	m_bestCorrelation = -999999;
 	m_bestCorrelationOffset = 0;
+	m_bestCorrelationSkew = 0;
 	m_primaryWaveform = pw;
 	m_secondaryWaveform = sw;
 
-	//Max allowed skew between instruments is 10K points for now (arbitrary limit)
+	//Max allowed skew between instruments is 1M points for now (arbitrary limit)
 	m_maxSkewSamples = static_cast<int64_t>(pw->size() / 2);
-	m_maxSkewSamples = min(m_maxSkewSamples, static_cast<int64_t>(10000LL));
+	m_maxSkewSamples = min(m_maxSkewSamples, MAX_SKEW_SAMPLES_FFT);
 
 	//Set the timer
 	Glib::signal_timeout().connect(sigc::mem_fun(*this, &ScopeSyncWizard::OnTimer), 1);
@@ -418,55 +428,64 @@ void ScopeSyncWizard::OnWaveformDataReady()
 
 bool ScopeSyncWizard::OnTimer()
 {
-	auto upri = dynamic_cast<UniformAnalogWaveform*>(m_primaryWaveform);
-	auto usec = dynamic_cast<UniformAnalogWaveform*>(m_secondaryWaveform);
+	//FFT path handles every combination of sample rates and sparse/uniform waveforms
+	if(!DoProcessWaveformFFT())
+	{
+		LogDebug("FFT cross-correlation failed, falling back to brute force\n");
+		m_maxSkewSamples = min(m_maxSkewSamples, MAX_SKEW_SAMPLES_BRUTE_FORCE);
 
-	auto spri = dynamic_cast<SparseAnalogWaveform*>(m_primaryWaveform);
-	auto ssec = dynamic_cast<SparseAnalogWaveform*>(m_secondaryWaveform);
+		auto upri = dynamic_cast<UniformAnalogWaveform*>(m_primaryWaveform);
+		auto usec = dynamic_cast<UniformAnalogWaveform*>(m_secondaryWaveform);
 
-	//Optimized path (if both waveforms are dense packed)
-	if(upri && usec)
-	{
-		//If sample rates are equal we can simplify things a lot
-		if(m_primaryWaveform->m_timescale == m_secondaryWaveform->m_timescale)
-		{
-			#ifdef __x86_64__
-			if(g_hasAvx512F)
-				DoProcessWaveformDensePackedEqualRateAVX512F();
-			else
-			#endif
-				DoProcessWaveformDensePackedEqualRateGeneric();
-		}
+		auto spri = dynamic_cast<SparseAnalogWaveform*>(m_primaryWaveform);
+		auto ssec = dynamic_cast<SparseAnalogWaveform*>(m_secondaryWaveform);
 
-		//Also special-case 2:1 sample rate ratio (primary 2x speed of secondary)
-		else if((m_primaryWaveform->m_timescale * 2) == m_secondaryWaveform->m_timescale)
+		//Optimized path (if both waveforms are dense packed)
+		if(upri && usec)
 		{
-			#ifdef __x86_64__
-			if(g_hasAvx512F)
-				DoProcessWaveformDensePackedDoubleRateAVX512F();
+			//If sample rates are equal we can simplify things a lot
+			if(m_primaryWaveform->m_timescale == m_secondaryWaveform->m_timescale)
+			{
+				#ifdef __x86_64__
+				if(g_hasAvx512F)
+					DoProcessWaveformDensePackedEqualRateAVX512F();
+				else
+				#endif
+					DoProcessWaveformDensePackedEqualRateGeneric();
+			}
+
+			//Also special-case 2:1 sample rate ratio (primary 2x speed of secondary)
+			else if((m_primaryWaveform->m_timescale * 2) == m_secondaryWaveform->m_timescale)
+			{
+				#ifdef __x86_64__
+				if(g_hasAvx512F)
+					DoProcessWaveformDensePackedDoubleRateAVX512F();
+				else
+				#endif
+					DoProcessWaveformDensePackedDoubleRateGeneric();
+			}
+
+			//Unequal sample rates, more math needed
 			else
-			#endif
-				DoProcessWaveformDensePackedDoubleRateGeneric();
+				DoProcessWaveformDensePackedUnequalRate();
 		}
 
-		//Unequal sample rates, more math needed
-		else
-			DoProcessWaveformDensePackedUnequalRate();
-	}
+		//Fallback path (if at least one waveform is not dense packed)
+		else if(spri && ssec)
+			DoProcessWaveformSparse();
 
-	//Fallback path (if at least one waveform is not dense packed)
-	else if(spri && ssec)
-		DoProcessWaveformSparse();
+		else
+		{
+			LogError("Mixed sparse and uniform waveforms not implemented\n");
+			return false;
+		}
 
-	else
-	{
-		LogError("Mixed sparse and uniform waveforms not implemented\n");
-		return false;
+		m_bestCorrelationSkew = m_bestCorrelationOffset * m_primaryWaveform->m_timescale;
 	}
 
 	//Collect the skew from this round
 	auto scope = m_activeSecondaryPage->GetScope();
-	int64_t skew = m_bestCorrelationOffset * m_primaryWaveform->m_timescale;
+	int64_t skew = m_bestCorrelationSkew;
 	Unit fs(Unit::UNIT_FS);
 	LogTrace("Best correlation = %f (delta = %ld / %s)\n",
 		m_bestCorrelation, m_bestCorrelationOffset, fs.PrettyPrint(skew).c_str());
@@ -509,6 +528,263 @@ bool ScopeSyncWizard::OnTimer()
 	return false;
 }
 
+/**
+	@brief Resamples an analog waveform onto a uniform grid by linear interpolation
+
+	@param wfm		Input waveform (uniform or sparse analog)
+	@param tstart	Timestamp of the first grid point, in fs (including trigger phase)
+	@param step		Grid spacing, in fs
+	@param npoints	Number of grid points
+	@param out		Output buffer. Grid points outside the input waveform are set to zero.
+	@param first	Index of the first grid point inside the input waveform
+	@param last		Index of the last grid point inside the input waveform (inclusive). If no grid point is inside the
+					waveform, first is set to npoints and last to 0.
+
+	@return False if the waveform isn't analog
+ */
+bool ScopeSyncWizard::ResampleToGrid(
+	WaveformBase* wfm,
+	int64_t tstart,
+	int64_t step,
+	size_t npoints,
+	float* out,
+	size_t& first,
+	size_t& last)
+{
+	auto uwfm = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	auto swfm = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	if(!uwfm && !swfm)
+		return false;
+
+	wfm->PrepareForCpuAccess();
+	size_t len = wfm->size();
+	first = npoints;
+	last = 0;
+	if(len < 2)
+	{
+		memset(out, 0, npoints * sizeof(float));
+		return true;
+	}
+
+	//Uniform input: every grid point can be computed independently
+	if(uwfm)
+	{
+		float* samples = uwfm->m_samples.GetCpuPointer();
+		double scale = 1.0 / wfm->m_timescale;
+		int64_t phase = wfm->m_triggerPhase;
+
+		#pragma omp parallel for
+		for(size_t i=0; i<npoints; i++)
+		{
+			double x = (tstart + static_cast<int64_t>(i)*step - phase) * scale;
+			int64_t i0 = floor(x);
+			if( (i0 < 0) || (i0 + 1 >= static_cast<int64_t>(len)) )
+			{
+				out[i] = 0;
+				continue;
+			}
+
+			float frac = x - i0;
+			out[i] = samples[i0] + (samples[i0+1] - samples[i0]) * frac;
+		}
+	}
+
+	//Sparse input: walk the input alongside the grid
+	else
+	{
+		size_t j = 0;
+		for(size_t i=0; i<npoints; i++)
+		{
+			int64_t t = tstart + static_cast<int64_t>(i)*step;
+			while( (j + 1 < len) && (swfm->m_offsets[j+1] * wfm->m_timescale + wfm->m_triggerPhase <= t) )
+				j++;
+
+			int64_t t0 = swfm->m_offsets[j] * wfm->m_timescale + wfm->m_triggerPhase;
+			if( (t < t0) || (j + 1 >= len) )
+			{
+				out[i] = 0;
+				continue;
+			}
+
+			int64_t t1 = swfm->m_offsets[j+1] * wfm->m_timescale + wfm->m_triggerPhase;
+			float frac = (t1 > t0) ? static_cast<float>(t - t0) / (t1 - t0) : 0;
+			out[i] = swfm->m_samples[j] + (swfm->m_samples[j+1] - swfm->m_samples[j]) * frac;
+		}
+	}
+
+	//Find the valid range. Grid is monotonic so this is just the first/last point inside the waveform
+	int64_t tfirst;
+	int64_t tlast;
+	if(uwfm)
+	{
+		tfirst = wfm->m_triggerPhase;
+		tlast = (len - 1) * wfm->m_timescale + wfm->m_triggerPhase;
+	}
+	else
+	{
+		tfirst = swfm->m_offsets[0] * wfm->m_timescale + wfm->m_triggerPhase;
+		tlast = swfm->m_offsets[len-1] * wfm->m_timescale + wfm->m_triggerPhase;
+	}
+
+	int64_t ifirst = (tfirst - tstart + step - 1) / step;
+	int64_t ilast = (tlast - tstart) / step;
+	ifirst = max(ifirst, static_cast<int64_t>(0));
+	ilast = min(ilast, static_cast<int64_t>(npoints) - 1);
+	if(ilast >= ifirst)
+	{
+		first = ifirst;
+		last = ilast;
+	}
+	return true;
+}
+
+/**
+	@brief Cross-correlates the primary and secondary waveforms in the frequency domain
+
+	Both waveforms are resampled to a common timebase (the faster of the two sample rates) aligned to the first primary
+	sample. The correlation for every lag is then computed at once as IFFT(conj(FFT(primary)) * FFT(secondary)),
+	which is O(N log N) regardless of the skew window. The peak is refined to sub-sample precision by fitting a
+	parabola through it and its neighbors.
+
+	@return False if the waveforms can't be processed this way (not analog, or FFT setup failed)
+ */
+bool ScopeSyncWizard::DoProcessWaveformFFT()
+{
+	auto upri = dynamic_cast<UniformAnalogWaveform*>(m_primaryWaveform);
+	auto spri = dynamic_cast<SparseAnalogWaveform*>(m_primaryWaveform);
+	if( (!upri && !spri) || (m_primaryWaveform->size() < 2) )
+		return false;
+
+	//Common timebase
+	int64_t step = min(m_primaryWaveform->m_timescale, m_secondaryWaveform->m_timescale);
+	if(step <= 0)
+		return false;
+
+	//Span of the primary waveform
+	size_t plen = m_primaryWaveform->size();
+	int64_t tstart;
+	int64_t tend;
+	if(upri)
+	{
+		tstart = m_primaryWaveform->m_triggerPhase;
+		tend = (plen - 1) * m_primaryWaveform->m_timescale + m_primaryWaveform->m_triggerPhase;
+	}
+	else
+	{
+		tstart = spri->m_offsets[0] * m_primaryWaveform->m_timescale + m_primaryWaveform->m_triggerPhase;
+		tend = spri->m_offsets[plen-1] * m_primaryWaveform->m_timescale + m_primaryWaveform->m_triggerPhase;
+	}
+
+	//Don't let a very fine timescale blow up memory usage
+	int64_t skewFs = m_maxSkewSamples * m_primaryWaveform->m_timescale;
+	while( (static_cast<size_t>((tend - tstart + 2*skewFs) / step) + 1) > MAX_FFT_GRID_POINTS)
+		step *= 2;
+
+	//Lag window, in grid points
+	size_t nlag = skewFs / step;
+	size_t npri = (tend - tstart) / step + 1;
+	size_t nsec = npri + 2*nlag;
+
+	//Zero padding to avoid circular wraparound
+	size_t npoints = 1;
+	while(npoints < nsec)
+		npoints *= 2;
+	size_t nouts = npoints/2 + 1;
+
+	ffts_plan_t* forwardPlan = ffts_init_1d_real(npoints, FFTS_FORWARD);
+	ffts_plan_t* reversePlan = ffts_init_1d_real(npoints, FFTS_BACKWARD);
+	if(!forwardPlan || !reversePlan)
+	{
+		if(forwardPlan)
+			ffts_free(forwardPlan);
+		if(reversePlan)
+			ffts_free(reversePlan);
+		return false;
+	}
+
+	//Resample both waveforms. Secondary starts nlag points earlier so lag zero is at index nlag.
+	vector<float, AlignedAllocator<float, 64> > pri(npoints, 0.0f);
+	vector<float, AlignedAllocator<float, 64> > sec(npoints, 0.0f);
+	size_t pfirst;
+	size_t plast;
+	size_t sfirst;
+	size_t slast;
+	if(!ResampleToGrid(m_primaryWaveform, tstart, step, npri, &pri[0], pfirst, plast) ||
+		!ResampleToGrid(m_secondaryWaveform, tstart - nlag*step, step, nsec, &sec[0], sfirst, slast) )
+	{
+		ffts_free(forwardPlan);
+		ffts_free(reversePlan);
+		return false;
+	}
+
+	//Forward FFTs
+	vector<float, AlignedAllocator<float, 64> > pspec(nouts * 2);
+	vector<float, AlignedAllocator<float, 64> > sspec(nouts * 2);
+	ffts_execute(forwardPlan, &pri[0], &pspec[0]);
+	ffts_execute(forwardPlan, &sec[0], &sspec[0]);
+
+	//Cross-power spectrum conj(P) * S, in place in the secondary spectrum
+	float* ps = &pspec[0];
+	float* ss = &sspec[0];
+	#pragma omp parallel for
+	for(size_t i=0; i<nouts; i++)
+	{
+		float pr = ps[i*2];
+		float pi = ps[i*2 + 1];
+		float sr = ss[i*2];
+		float si = ss[i*2 + 1];
+
+		ss[i*2]		= pr*sr + pi*si;
+		ss[i*2 + 1]	= pr*si - pi*sr;
+	}
+
+	//Back to the time domain. Index j is lag (j - nlag) grid points.
+	ffts_execute(reversePlan, &sspec[0], &sec[0]);
+	ffts_free(forwardPlan);
+	ffts_free(reversePlan);
+
+	//Normalize each lag by the number of overlapping valid samples (as the brute force path does) and find the peak
+	int64_t ibest = -1;
+	float best = 0;
+	vector<float> normalized(2*nlag + 1, 0.0f);
+	for(size_t j=0; j<=2*nlag; j++)
+	{
+		int64_t lo = max(static_cast<int64_t>(pfirst), static_cast<int64_t>(sfirst) - static_cast<int64_t>(j));
+		int64_t hi = min(static_cast<int64_t>(plast), static_cast<int64_t>(slast) - static_cast<int64_t>(j));
+		int64_t count = hi - lo + 1;
+		if(count <= 0)
+			continue;
+
+		float v = sec[j] / (static_cast<float>(npoints) * count);
+		normalized[j] = v;
+		if( (ibest < 0) || (v > best) )
+		{
+			best = v;
+			ibest = j;
+		}
+	}
+	if(ibest < 0)
+		return false;
+
+	//Parabolic interpolation for sub-sample peak position
+	double frac = 0;
+	if( (ibest > 0) && (ibest < static_cast<int64_t>(2*nlag)) )
+	{
+		double ym = normalized[ibest-1];
+		double y0 = normalized[ibest];
+		double yp = normalized[ibest+1];
+		double denom = ym - 2*y0 + yp;
+		if(denom < 0)
+			frac = 0.5 * (ym - yp) / denom;
+	}
+
+	int64_t lag = ibest - static_cast<int64_t>(nlag);
+	m_bestCorrelation = best;
+	m_bestCorrelationOffset = lag * step / m_primaryWaveform->m_timescale;
+	m_bestCorrelationSkew = round((lag + frac) * step);
+	return true;
+}
+
 void ScopeSyncWizard::DoProcessWaveformSparse()
 {
 	//Calculate cross-correlation between the primary and secondary waveforms at up to +/- half the waveform length
@@ -139,11 +139,22 @@ protected:
 #endif
 	void DoProcessWaveformDensePackedUnequalRate();
 	void DoProcessWaveformSparse();
+	bool DoProcessWaveformFFT();
+
+	static bool ResampleToGrid(
+		WaveformBase* wfm,
+		int64_t tstart,
+		int64_t step,
+		size_t npoints,
+		float* out,
+		size_t& first,
+		size_t& last);
 
 	//Cross-correlation
 	ScopeSyncDeskewSetupPage* m_activeSetupPage;
 	ScopeSyncDeskewProgressPage* m_activeSecondaryPage;
 	int64_t m_bestCorrelationOffset;
+	int64_t m_bestCorrelationSkew;
 	double m_bestCorrelation;
 	WaveformBase* m_primaryWaveform;
 	WaveformBase* m_secondaryWaveform;
@@ -0,0 +1,309 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of StatisticsEngine
+ */
+#include "../scopehal/scopehal.h"
+#include "../scopehal/Filter.h"
+#include "StatisticsEngine.h"
+#include "../../lib/scopehal/AverageStatistic.h"
+#include "../../lib/scopehal/MaximumStatistic.h"
+#include "../../lib/scopehal/MinimumStatistic.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+StatisticsEngine::StatisticsEngine()
+	: m_revision(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Configuration
+
+/**
+	@brief Replaces the set of statistics to evaluate
+
+	Running state of statistics which are no longer requested is discarded.
+ */
+void StatisticsEngine::SetRequests(const vector<StatisticsRequest>& requests)
+{
+	lock_guard<mutex> lock(m_requestMutex);
+	m_requests = requests;
+
+	set<ResultKey> keys;
+	for(auto& r : m_requests)
+		keys.emplace(r.m_stat, r.m_stream);
+
+	for(auto it = m_accumulators.begin(); it != m_accumulators.end(); )
+	{
+		if(keys.find(it->first) == keys.end())
+			it = m_accumulators.erase(it);
+		else
+			++it;
+	}
+}
+
+/**
+	@brief Forgets about a statistic which is about to be deleted
+
+	Blocks until any evaluation in progress has finished with it.
+ */
+void StatisticsEngine::RemoveStatistic(Statistic* stat)
+{
+	lock_guard<mutex> lock(m_requestMutex);
+
+	for(size_t i=0; i<m_requests.size(); )
+	{
+		if(m_requests[i].m_stat == stat)
+			m_requests.erase(m_requests.begin() + i);
+		else
+			i++;
+	}
+
+	for(auto it = m_accumulators.begin(); it != m_accumulators.end(); )
+	{
+		if(it->first.first == stat)
+			it = m_accumulators.erase(it);
+		else
+			++it;
+	}
+
+	lock_guard<mutex> lock2(m_resultMutex);
+	for(auto it = m_results.begin(); it != m_results.end(); )
+	{
+		if(it->first.first == stat)
+			it = m_results.erase(it);
+		else
+			++it;
+	}
+}
+
+/**
+	@brief Resets the history of a statistic
+ */
+void StatisticsEngine::Clear(Statistic* stat)
+{
+	lock_guard<mutex> lock(m_requestMutex);
+
+	stat->Clear();
+	for(auto& it : m_accumulators)
+	{
+		if(it.first.first == stat)
+			it.second = Accumulator();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Evaluation
+
+/**
+	@brief Figures out if a statistic can be computed from a StreamSummary
+ */
+StatisticsEngine::FusedType StatisticsEngine::GetFusedType(Statistic* stat)
+{
+	if(dynamic_cast<MaximumStatistic*>(stat))
+		return FUSED_MAXIMUM;
+	else if(dynamic_cast<MinimumStatistic*>(stat))
+		return FUSED_MINIMUM;
+	else if(dynamic_cast<AverageStatistic*>(stat))
+		return FUSED_AVERAGE;
+	return FUSED_NONE;
+}
+
+/**
+	@brief Computes everything the fused statistics need from a waveform, in one pass
+ */
+void StatisticsEngine::Summarize(WaveformBase* data, StreamSummary& summary)
+{
+	summary.m_valid = false;
+	summary.m_min = FLT_MAX;
+	summary.m_max = -FLT_MAX;
+	summary.m_sum = 0;
+	summary.m_count = 0;
+
+	const float* samples = nullptr;
+	size_t len = 0;
+
+	auto uadata = dynamic_cast<UniformAnalogWaveform*>(data);
+	auto sadata = dynamic_cast<SparseAnalogWaveform*>(data);
+	if(uadata)
+	{
+		samples = uadata->m_samples.GetCpuPointer();
+		len = uadata->m_samples.size();
+	}
+	else if(sadata)
+	{
+		samples = sadata->m_samples.GetCpuPointer();
+		len = sadata->m_samples.size();
+	}
+	if( (samples == nullptr) || (len == 0) )
+		return;
+
+	float vmin = FLT_MAX;
+	float vmax = -FLT_MAX;
+	double sum = 0;
+	for(size_t i=0; i<len; i++)
+	{
+		float v = samples[i];
+		vmin = min(vmin, v);
+		vmax = max(vmax, v);
+		sum += v;
+	}
+
+	summary.m_valid = true;
+	summary.m_min = vmin;
+	summary.m_max = vmax;
+	summary.m_sum = sum;
+	summary.m_count = len;
+}
+
+/**
+	@brief Evaluates every requested statistic against the current waveforms and publishes the results
+
+	Must be called with the waveform data locked.
+ */
+void StatisticsEngine::Evaluate()
+{
+	lock_guard<mutex> lock(m_requestMutex);
+
+	//Figure out which streams need summarizing, and get them into CPU memory before going parallel
+	vector<StreamDescriptor> streams;
+	map<StreamDescriptor, size_t> streamIndexes;
+	vector<FusedType> types;
+	for(auto& r : m_requests)
+	{
+		auto type = GetFusedType(r.m_stat);
+		types.push_back(type);
+		if(type == FUSED_NONE)
+			continue;
+
+		if(streamIndexes.find(r.m_stream) != streamIndexes.end())
+			continue;
+
+		streamIndexes[r.m_stream] = streams.size();
+		streams.push_back(r.m_stream);
+
+		auto data = r.m_stream.GetData();
+		if(data)
+			data->PrepareForCpuAccess();
+	}
+
+	//One pass over each stream, all streams in parallel
+	vector<StreamSummary> summaries(streams.size());
+	#pragma omp parallel for
+	for(size_t i=0; i<streams.size(); i++)
+	{
+		auto data = streams[i].GetData();
+		if(data)
+			Summarize(data, summaries[i]);
+		else
+			summaries[i].m_valid = false;
+	}
+
+	//Fold each summary into the running state of its statistics
+	map<ResultKey, Result> results;
+	for(size_t i=0; i<m_requests.size(); i++)
+	{
+		auto& r = m_requests[i];
+		ResultKey key(r.m_stat, r.m_stream);
+		Result& result = results[key];
+		result.m_valid = false;
+		result.m_value = 0;
+
+		//Anything we don't have a fused kernel for is evaluated by the statistic itself
+		if(types[i] == FUSED_NONE)
+		{
+			auto data = r.m_stream.GetData();
+			if(data == nullptr)
+				continue;
+			data->PrepareForCpuAccess();
+			result.m_valid = r.m_stat->Calculate(r.m_stream, result.m_value);
+			continue;
+		}
+
+		auto& summary = summaries[streamIndexes[r.m_stream]];
+		auto& acc = m_accumulators[key];
+		if(summary.m_valid)
+		{
+			acc.m_min = min(acc.m_min, summary.m_min);
+			acc.m_max = max(acc.m_max, summary.m_max);
+			acc.m_sum += summary.m_sum;
+			acc.m_count += summary.m_count;
+		}
+		if(acc.m_count == 0)
+			continue;
+
+		result.m_valid = true;
+		switch(types[i])
+		{
+			case FUSED_MAXIMUM:
+				result.m_value = acc.m_max;
+				break;
+
+			case FUSED_MINIMUM:
+				result.m_value = acc.m_min;
+				break;
+
+			case FUSED_AVERAGE:
+				result.m_value = acc.m_sum / acc.m_count;
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	//Publish
+	lock_guard<mutex> lock2(m_resultMutex);
+	m_results = move(results);
+	m_revision ++;
+}
+
+/**
+	@brief Gets the most recently published value of a statistic
+
+	@return True if the value is valid, false if it couldn't be calculated or hasn't been evaluated yet
+ */
+bool StatisticsEngine::GetResult(Statistic* stat, StreamDescriptor stream, double& value)
+{
+	lock_guard<mutex> lock(m_resultMutex);
+
+	auto it = m_results.find(ResultKey(stat, stream));
+	if( (it == m_results.end()) || !it->second.m_valid )
+		return false;
+
+	value = it->second.m_value;
+	return true;
+}
@@ -0,0 +1,154 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of StatisticsEngine
+ */
+
+#ifndef StatisticsEngine_h
+#define StatisticsEngine_h
+
+#include <cfloat>
+
+/**
+	@brief A single statistic to be evaluated on a single stream
+ */
+class StatisticsRequest
+{
+public:
+	StatisticsRequest(Statistic* stat, StreamDescriptor stream)
+		: m_stat(stat)
+		, m_stream(stream)
+	{}
+
+	Statistic* m_stat;
+	StreamDescriptor m_stream;
+};
+
+/**
+	@brief Evaluates every statistic shown in the measurement views
+
+	All statistics requested for a given stream are computed from a single pass over its samples, and streams are
+	processed in parallel. Evaluation runs from RefreshAllFilters(), on whichever thread re-ran the filter graph
+	(usually the waveform processing thread). The measurement views only format the published results.
+
+	Only the statistics libscopehal provides (maximum, minimum, average) have fused kernels. Anything else is
+	evaluated by Statistic::Calculate().
+ */
+class StatisticsEngine
+{
+public:
+	StatisticsEngine();
+
+	void SetRequests(const std::vector<StatisticsRequest>& requests);
+	void RemoveStatistic(Statistic* stat);
+	void Clear(Statistic* stat);
+
+	void Evaluate();
+
+	bool GetResult(Statistic* stat, StreamDescriptor stream, double& value);
+
+	///@brief Incremented every time a new set of results is published
+	uint64_t GetRevision()
+	{ return m_revision; }
+
+protected:
+
+	///@brief Summary of a single waveform, computed in one pass
+	class StreamSummary
+	{
+	public:
+		bool m_valid;
+		float m_min;
+		float m_max;
+		double m_sum;
+		size_t m_count;
+	};
+
+	///@brief Running state of a fused statistic since it was last cleared
+	class Accumulator
+	{
+	public:
+		Accumulator()
+			: m_min(FLT_MAX)
+			, m_max(-FLT_MAX)
+			, m_sum(0)
+			, m_count(0)
+		{}
+
+		float m_min;
+		float m_max;
+		double m_sum;
+		size_t m_count;
+	};
+
+	///@brief Statistics we know how to compute from a StreamSummary
+	enum FusedType
+	{
+		FUSED_NONE,
+		FUSED_MAXIMUM,
+		FUSED_MINIMUM,
+		FUSED_AVERAGE
+	};
+
+	static FusedType GetFusedType(Statistic* stat);
+	static void Summarize(WaveformBase* data, StreamSummary& summary);
+
+	typedef std::pair<Statistic*, StreamDescriptor> ResultKey;
+
+	///@brief Result of one statistic on one stream
+	class Result
+	{
+	public:
+		bool m_valid;
+		double m_value;
+	};
+
+	///@brief Held for the duration of an evaluation, so statistics can't be deleted out from under us
+	std::mutex m_requestMutex;
+
+	///@brief The statistics to evaluate
+	std::vector<StatisticsRequest> m_requests;
+
+	///@brief Running state of each fused statistic (only touched by Evaluate(), or under m_requestMutex)
+	std::map<ResultKey, Accumulator> m_accumulators;
+
+	///@brief Protects m_results
+	std::mutex m_resultMutex;
+
+	///@brief Most recently published results
+	std::map<ResultKey, Result> m_results;
+
+	///@brief Revision of m_results
+	std::atomic<uint64_t> m_revision;
+};
+
+#endif
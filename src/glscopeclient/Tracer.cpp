@@ -0,0 +1,325 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of Tracer
+ */
+#include "../scopehal/scopehal.h"
+#include "Tracer.h"
+#include <chrono>
+
+using namespace std;
+
+//Max events kept per thread before the oldest are overwritten
+static const size_t TRACE_BUFFER_SIZE = 65536;
+
+atomic<bool> Tracer::m_enabled(false);
+atomic<bool> Tracer::m_dumpRequested(false);
+mutex Tracer::m_buffersMutex;
+vector<TraceBuffer*> Tracer::m_buffers;
+int Tracer::m_nextTid = 1;
+double Tracer::m_epoch = Tracer::Now();
+
+/**
+	@brief Per-thread trace state, which hands the thread's buffer back for reuse when the thread exits
+ */
+class ThreadTraceState
+{
+public:
+	ThreadTraceState()
+		: m_buffer(nullptr)
+	{}
+
+	~ThreadTraceState()
+	{
+		if(m_buffer)
+			Tracer::ReleaseThreadBuffer(m_buffer);
+	}
+
+	TraceBuffer* m_buffer;
+	string m_name;
+};
+
+static thread_local ThreadTraceState g_threadTraceState;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TraceBuffer
+
+TraceBuffer::TraceBuffer(int tid, const string& name)
+	: m_tid(tid)
+	, m_threadName(name)
+	, m_events(new TraceEvent[TRACE_BUFFER_SIZE])
+	, m_writeIndex(0)
+	, m_readStart(0)
+	, m_inUse(true)
+{
+}
+
+/**
+	@brief Records a span, overwriting the oldest one if the ring is full
+
+	Must only be called by the owning thread.
+ */
+void TraceBuffer::Add(const char* name, double start, double end)
+{
+	uint64_t i = m_writeIndex.load(memory_order_relaxed);
+	auto& ev = m_events[i % TRACE_BUFFER_SIZE];
+
+	strncpy(ev.m_name, name, sizeof(ev.m_name) - 1);
+	ev.m_name[sizeof(ev.m_name) - 1] = '\0';
+	ev.m_start = start;
+	ev.m_end = end;
+
+	//Publish the event
+	m_writeIndex.store(i + 1, memory_order_release);
+}
+
+/**
+	@brief Copies out every event currently in the ring, oldest first
+
+	Safe to call while the owning thread is recording.
+ */
+void TraceBuffer::Copy(vector<TraceEvent>& events)
+{
+	uint64_t end = m_writeIndex.load(memory_order_acquire);
+	uint64_t start = m_readStart.load(memory_order_relaxed);
+	if(end > TRACE_BUFFER_SIZE)
+		start = max(start, end - TRACE_BUFFER_SIZE);
+
+	events.clear();
+	events.reserve(end - start);
+	for(uint64_t i=start; i<end; i++)
+		events.push_back(m_events[i % TRACE_BUFFER_SIZE]);
+
+	//The owner finished every event before endAfter and may be part way through writing endAfter itself,
+	//which reuses the slot of event endAfter - TRACE_BUFFER_SIZE. Drop anything that may have been overwritten.
+	atomic_thread_fence(memory_order_acquire);
+	uint64_t endAfter = m_writeIndex.load(memory_order_relaxed);
+	if(endAfter + 1 > start + TRACE_BUFFER_SIZE)
+	{
+		uint64_t stale = min<uint64_t>(endAfter + 1 - TRACE_BUFFER_SIZE - start, events.size());
+		events.erase(events.begin(), events.begin() + stale);
+	}
+}
+
+/**
+	@brief Discards every event recorded so far. Safe to call while the owning thread is recording.
+ */
+void TraceBuffer::Discard()
+{
+	m_readStart = m_writeIndex.load();
+}
+
+/**
+	@brief Empties the ring for a new owner. Must only be called when no thread owns the buffer.
+ */
+void TraceBuffer::Reset()
+{
+	m_writeIndex = 0;
+	m_readStart = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tracer
+
+/**
+	@brief Monotonic timestamp in seconds (GetTime() is wall clock and can jump)
+ */
+double Tracer::Now()
+{
+	return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::Enable(bool enable)
+{
+	if(enable && !m_enabled)
+		LogNotice("Performance tracing enabled\n");
+	m_enabled = enable;
+}
+
+/**
+	@brief Discards all recorded events (thread names are kept)
+ */
+void Tracer::Clear()
+{
+	lock_guard<mutex> lock(m_buffersMutex);
+	for(auto b : m_buffers)
+		b->Discard();
+}
+
+/**
+	@brief Gets (creating if needed) the calling thread's buffer
+
+	Only called while tracing is enabled, so threads which never record anything never get a buffer.
+ */
+TraceBuffer* Tracer::GetThreadBuffer()
+{
+	auto& state = g_threadTraceState;
+	if(state.m_buffer)
+		return state.m_buffer;
+
+	lock_guard<mutex> lock(m_buffersMutex);
+
+	string name = state.m_name;
+	if(name.empty())
+		name = string("Thread ") + to_string(m_nextTid);
+
+	//Buffers of exited threads are kept so their spans still show up in the dump, until a new thread needs one.
+	//Reuse one of those (with a fresh ID, so the dump doesn't merge the two threads) rather than growing forever.
+	for(size_t i=0; i<m_buffers.size(); i++)
+	{
+		auto buf = m_buffers[i];
+		if(buf->m_inUse)
+			continue;
+
+		lock_guard<mutex> lock2(buf->m_mutex);
+		buf->m_inUse = true;
+		buf->m_tid = m_nextTid++;
+		buf->m_threadName = name;
+		buf->Reset();
+
+		state.m_buffer = buf;
+		return buf;
+	}
+
+	state.m_buffer = new TraceBuffer(m_nextTid++, name);
+	m_buffers.push_back(state.m_buffer);
+	return state.m_buffer;
+}
+
+/**
+	@brief Called when a thread exits, so its buffer can be reused by a new thread
+ */
+void Tracer::ReleaseThreadBuffer(TraceBuffer* buf)
+{
+	lock_guard<mutex> lock(m_buffersMutex);
+	buf->m_inUse = false;
+}
+
+/**
+	@brief Names the calling thread in the trace output
+
+	This is called for every thread we create, so it doesn't allocate a trace buffer; the name is applied when (and
+	if) the thread records its first span.
+ */
+void Tracer::SetThreadName(const char* name)
+{
+	auto& state = g_threadTraceState;
+	state.m_name = name;
+	if(state.m_buffer)
+	{
+		lock_guard<mutex> lock(state.m_buffer->m_mutex);
+		state.m_buffer->m_threadName = name;
+	}
+}
+
+void Tracer::Record(const char* name, double start, double end)
+{
+	GetThreadBuffer()->Add(name, start, end);
+}
+
+static string JsonEscape(const string& s)
+{
+	string ret;
+	for(auto c : s)
+	{
+		if( (c == '\"') || (c == '\\') )
+			ret += '\\';
+		if(static_cast<unsigned char>(c) < 0x20)
+			continue;
+		ret += c;
+	}
+	return ret;
+}
+
+/**
+	@brief Writes everything currently in the per-thread buffers to a Chrome trace event JSON file
+ */
+bool Tracer::Dump(const string& path)
+{
+	//Copy the events out, then do the file I/O after releasing the lock, so threads starting or exiting
+	//(which need m_buffersMutex) aren't held up by it
+	class ThreadEvents
+	{
+	public:
+		int m_tid;
+		string m_name;
+		vector<TraceEvent> m_events;
+	};
+	vector<ThreadEvents> threads;
+	{
+		lock_guard<mutex> lock(m_buffersMutex);
+		threads.resize(m_buffers.size());
+		for(size_t i=0; i<m_buffers.size(); i++)
+		{
+			auto b = m_buffers[i];
+			{
+				lock_guard<mutex> lock2(b->m_mutex);
+				threads[i].m_tid = b->m_tid;
+				threads[i].m_name = b->m_threadName;
+			}
+			b->Copy(threads[i].m_events);
+		}
+	}
+
+	FILE* fp = fopen(path.c_str(), "w");
+	if(!fp)
+	{
+		LogError("Couldn't open trace file %s\n", path.c_str());
+		return false;
+	}
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"glscopeclient\"}}");
+
+	size_t count = 0;
+	for(auto& t : threads)
+	{
+		fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+			t.m_tid, JsonEscape(t.m_name).c_str());
+
+		for(auto& ev : t.m_events)
+		{
+			fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				JsonEscape(ev.m_name).c_str(),
+				t.m_tid,
+				(ev.m_start - m_epoch) * 1e6,
+				(ev.m_end - ev.m_start) * 1e6);
+		}
+		count += t.m_events.size();
+	}
+
+	fprintf(fp, "\n]}\n");
+	fclose(fp);
+
+	LogNotice("Wrote %zu trace events from %zu threads to %s\n", count, threads.size(), path.c_str());
+	return true;
+}
@@ -0,0 +1,159 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of Tracer and TraceSpan
+ */
+
+#ifndef Tracer_h
+#define Tracer_h
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+	@brief A single completed span
+ */
+class TraceEvent
+{
+public:
+	char m_name[48];
+	double m_start;
+	double m_end;
+};
+
+/**
+	@brief Ring buffer of spans recorded by a single thread
+
+	The ring is allocated up front and only the owning thread ever writes to it, so recording a span is a copy plus
+	an atomic store, with no lock and no allocation. Readers copy the events out and then discard any the owner may
+	have overwritten while they were copying (seqlock style).
+ */
+class TraceBuffer
+{
+public:
+	TraceBuffer(int tid, const std::string& name);
+
+	void Add(const char* name, double start, double end);
+	void Copy(std::vector<TraceEvent>& events);
+	void Discard();
+	void Reset();
+
+	///@brief Protects m_tid and m_threadName
+	std::mutex m_mutex;
+	int m_tid;
+	std::string m_threadName;
+
+	///@brief Fixed size ring of events
+	std::unique_ptr<TraceEvent[]> m_events;
+
+	///@brief Number of events ever written. Event i is in slot i % TRACE_BUFFER_SIZE.
+	std::atomic<uint64_t> m_writeIndex;
+
+	///@brief Events before this index were discarded by Tracer::Clear()
+	std::atomic<uint64_t> m_readStart;
+
+	///@brief True while owned by a running thread. Buffers of exited threads are kept (for dumping) until reused.
+	bool m_inUse;
+};
+
+/**
+	@brief Opt-in low overhead timeline recorder, exported in Chrome trace event format
+
+	Load the output in chrome://tracing or https://ui.perfetto.dev.
+ */
+class Tracer
+{
+public:
+	static void Enable(bool enable);
+
+	static bool IsEnabled()
+	{ return m_enabled.load(std::memory_order_relaxed); }
+
+	static void Clear();
+	static bool Dump(const std::string& path);
+
+	static void SetThreadName(const char* name);
+	static void Record(const char* name, double start, double end);
+
+	static double Now();
+
+	///@brief Set from a signal handler to request a dump at the next opportunity
+	static std::atomic<bool> m_dumpRequested;
+
+	static void ReleaseThreadBuffer(TraceBuffer* buf);
+
+protected:
+	static TraceBuffer* GetThreadBuffer();
+
+	static std::atomic<bool> m_enabled;
+
+	static std::mutex m_buffersMutex;
+	static std::vector<TraceBuffer*> m_buffers;
+	static int m_nextTid;
+	static double m_epoch;
+};
+
+/**
+	@brief Records the time from construction to destruction (or End()) as a span, if tracing is enabled
+ */
+class TraceSpan
+{
+public:
+	TraceSpan(const char* name)
+	: m_name(name)
+	, m_active(Tracer::IsEnabled())
+	{
+		if(m_active)
+			m_start = Tracer::Now();
+	}
+
+	~TraceSpan()
+	{ End(); }
+
+	void End()
+	{
+		if(!m_active)
+			return;
+		Tracer::Record(m_name, m_start, Tracer::Now());
+		m_active = false;
+	}
+
+protected:
+	const char* m_name;
+	bool m_active;
+	double m_start;
+};
+
+#endif
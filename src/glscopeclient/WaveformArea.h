@@ -39,6 +39,8 @@
 #include "FilterDialog.h"
 #include "EdgeTrigger.h"
 #include "Rect.h"
+#include "CursorRangeSums.h"
+#include "WaveformGeometry.h"
 #include <utility>
 
 class WaveformArea;
@@ -459,7 +461,7 @@ protected:
 	void MakePathSignalBody(
 		const Cairo::RefPtr<Cairo::Context>& cr,
 		float xstart, float xoff, float xend, float ybot, float ymid, float ytop);
-	void RemoveOverlaps(std::vector<Rect>& rects, std::vector<vec2f>& peaks);
+	void RemoveOverlaps(std::vector<Rect>& rects, std::vector<vec2f>& peaks, const std::vector<bool>& fixed);
 
 	void ResetTextureFiltering();
 
@@ -473,7 +475,6 @@ protected:
 	float XAxisUnitsToPixels(int64_t t);
 	float XAxisUnitsToXPosition(int64_t t);
 	float PickStepSize(float volts_per_half_span, int min_steps = 2, int max_steps = 5);
-	template<class T> static size_t BinarySearchForGequal(T* buf, size_t len, T value);
 	std::pair<bool, float> GetValueAtTime(int64_t time_fs);
 
 	float GetDPIScale()
@@ -567,6 +568,22 @@ protected:
 	Pango::FontDescription m_infoBoxFont;
 	Pango::FontDescription m_cursorLabelFont;
 	Pango::FontDescription m_decodeFont;
+
+	//Prefix sums for measurements between the X cursors
+	CursorRangeSums m_cursorSums;
+
+	//Where a FFT peak label ended up last frame
+	class PeakLabelPlacement
+	{
+	public:
+		vec2f m_peak;
+		vec2f m_center;
+		int m_width;
+		int m_height;
+	};
+
+	//Peak label placements from the last frame, indexed by peak position in X axis units
+	std::map<int64_t, PeakLabelPlacement> m_peakLabels;
 };
 
 #endif
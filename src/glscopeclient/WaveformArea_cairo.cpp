@@ -1026,7 +1026,7 @@ pair<bool, float> WaveformArea::GetValueAtTime(int64_t time_fs)
 	int64_t target = ceil(ticks);
 	if(swaveform)
 	{
-		index = BinarySearchForGequal(
+		index = WaveformGeometry::BinarySearchForGequal(
 			swaveform->m_offsets.GetCpuPointer(),
 			waveform->size(),
 			target);
@@ -1164,9 +1164,11 @@ void WaveformArea::RenderInBandPower(Cairo::RefPtr< Cairo::Context > cr)
 {
 	//If no data, we obviously can't do anything
 	auto data = m_channel.GetData();
-	auto udata = dynamic_cast<UniformAnalogWaveform*>(data);
-	auto sdata = dynamic_cast<SparseAnalogWaveform*>(data);
-	if(!udata && !sdata)
+	if(data == nullptr)
+		return;
+	auto yunit = m_channel.GetYAxisUnits();
+	bool dbm = (yunit == Unit(Unit::UNIT_DBM));
+	if(!m_cursorSums.Update(data, dbm) || (data->size() == 0) )
 		return;
 
 	//Bounds check cursors
@@ -1178,29 +1180,17 @@ void WaveformArea::RenderInBandPower(Cairo::RefPtr< Cairo::Context > cr)
 	vsecond = max(vsecond, (double)0);
 	vsecond = min(vsecond, (double)data->size()-1);
 
-	size_t ifirst = vfirst;
-	size_t isecond = vsecond;
+	size_t ifirst = min(vfirst, vsecond);
+	size_t isecond = max(vfirst, vsecond);
 
 	//This gets a bit more complicated because we can't just sum dB!
 	string text;
-	auto yunit = m_channel.GetYAxisUnits();
-	if(yunit == Unit(Unit::UNIT_DBM))
-	{
-		float total_watts = 0;
-		for(size_t i=ifirst; i<=isecond; i++)
-			total_watts += pow(10, (GetValue(sdata, udata, i) - 30) / 10);
-		float total_dbm = 10 * log10(total_watts) + 30;
-		text = string("Band: ") + yunit.PrettyPrint(total_dbm);
-	}
+	if(dbm)
+		text = string("Band: ") + yunit.PrettyPrint(m_cursorSums.GetPowerDbm(ifirst, isecond));
 
 	//But if we're using linear display it's easy
 	else
-	{
-		float total = 0;
-		for(size_t i=ifirst; i<=isecond; i++)
-			total += GetValue(sdata, udata, i);
-		text = string("Band: ") + yunit.PrettyPrint(total);
-	}
+		text = string("Band: ") + yunit.PrettyPrint(m_cursorSums.GetSum(ifirst, isecond));
 
 	//Calculate text size
 	int twidth;
@@ -1531,6 +1521,8 @@ void WaveformArea::RenderFFTPeaks(Cairo::RefPtr< Cairo::Context > cr)
 	vector<string> texts;
 	vector<vec2f> centers;
 	vector<Rect> rects;
+	vector<bool> fixed;
+	vector<int64_t> keys;
 	for(size_t i=0; i<peaks.size(); i++)
 	{
 		int64_t nx = peaks[i].m_x * timescale + data->m_triggerPhase;
@@ -1549,13 +1541,40 @@ void WaveformArea::RenderFFTPeaks(Cairo::RefPtr< Cairo::Context > cr)
 		if( (x < 0) || (x > m_plotRight) )
 			continue;
 
+		Rect rect(x, y, twidth + 2*margin, theight + 2*margin);
+
+		//If we placed this label last frame, start from where it was.
+		//If its peak didn't move either, there's nothing to solve so leave it where it is.
+		bool pinned = false;
+		auto it = m_peakLabels.find(nx);
+		if( (it != m_peakLabels.end()) &&
+			(it->second.m_width == rect.get_width()) && (it->second.m_height == rect.get_height()) )
+		{
+			auto& last = it->second;
+			pinned = (fabs(last.m_peak.x - x) < 0.5) && (fabs(last.m_peak.y - y) < 0.5);
+			rect.recenter(vec2f(last.m_center.x - last.m_peak.x + x, last.m_center.y - last.m_peak.y + y));
+		}
+
 		texts.push_back(text);
-		rects.push_back(Rect(x, y, twidth + 2*margin, theight + 2*margin));
+		rects.push_back(rect);
 		centers.push_back(vec2f(x, y));
+		fixed.push_back(pinned);
+		keys.push_back(nx);
 	}
 
 	//Move the labels around to remove overlaps
-	RemoveOverlaps(rects, centers);
+	RemoveOverlaps(rects, centers, fixed);
+
+	//Remember where everything went for next frame (forgetting any peaks that went away)
+	m_peakLabels.clear();
+	for(size_t i=0; i<rects.size(); i++)
+	{
+		auto& p = m_peakLabels[keys[i]];
+		p.m_peak = centers[i];
+		p.m_center = rects[i].center();
+		p.m_width = rects[i].get_width();
+		p.m_height = rects[i].get_height();
+	}
 
 	//Second pass: Lines from rectangle location to peak location
 	Gdk::Color outline_color = m_parent->GetPreferences().GetColor("Appearance.Peaks.peak_outline_color");
@@ -1612,10 +1631,28 @@ void WaveformArea::RenderFFTPeaks(Cairo::RefPtr< Cairo::Context > cr)
 /**
 	@brief Performs point-feature label placement given a list of nominal label positions
 
-	Simple energy minimization using linear springs.
+	Simple energy minimization using linear springs. Labels and peak markers are binned into a uniform grid so each
+	label is only tested against things in nearby cells, rather than against every other label.
+
+	@param rects	Label rectangles
+	@param peaks	Location of the peak each label belongs to
+	@param fixed	True for labels which are already in place and should only act as obstacles
  */
-void WaveformArea::RemoveOverlaps(vector<Rect>& rects, vector<vec2f>& peaks)
+void WaveformArea::RemoveOverlaps(vector<Rect>& rects, vector<vec2f>& peaks, const vector<bool>& fixed)
 {
+	//If everything is already placed, we're done
+	bool anyFree = false;
+	for(auto f : fixed)
+	{
+		if(!f)
+		{
+			anyFree = true;
+			break;
+		}
+	}
+	if(!anyFree)
+		return;
+
 	//Centroids of each rectangle
 	vector<vec2f> centers;
 	for(auto r : rects)
@@ -1624,42 +1661,108 @@ void WaveformArea::RemoveOverlaps(vector<Rect>& rects, vector<vec2f>& peaks)
 		centers.push_back(c);
 
 	int margin = 3;
+	int clearance = 8;
+
+	//Markers around each peak we can collide with (these never move)
+	vector<Rect> targets = rects;
+	for(auto c : peaks)
+		targets.push_back(Rect(c.x - clearance, c.y - clearance, 2*clearance, 2*clearance));
+
+	//Grid cells are as big as the biggest thing in them, so an object never spans more than 2x2 cells
+	int cellsize = 2*clearance;
+	for(auto& r : rects)
+		cellsize = max(cellsize, max(r.get_width(), r.get_height()));
+	cellsize += 2*margin;
+
+	typedef pair<int, int> Cell;
+	map<Cell, vector<size_t> > grid;
+	auto insert = [&](size_t k)
+	{
+		Rect r = targets[k];
+		r.expand(margin, margin);
+		int x0 = floor(r.get_left() * 1.0f / cellsize);
+		int x1 = floor(r.get_right() * 1.0f / cellsize);
+		int y0 = floor(r.get_top() * 1.0f / cellsize);
+		int y1 = floor(r.get_bottom() * 1.0f / cellsize);
+		for(int y=y0; y<=y1; y++)
+		{
+			for(int x=x0; x<=x1; x++)
+				grid[Cell(x, y)].push_back(k);
+		}
+	};
+
+	//Last label each target was checked against, so targets spanning several cells are only counted once
+	vector<size_t> lastChecked(targets.size(), SIZE_MAX);
+	vector<size_t> candidates;
 
 	for(int i=0; i<100; i++)
 	{
 		//Things we can collide with
-		int clearance = 8;
-		vector<Rect> targets = rects;
-		for(auto c : peaks)
-			targets.push_back(Rect(c.x - clearance, c.y - clearance, 2*clearance, 2*clearance));
+		grid.clear();
+		for(size_t k=0; k<targets.size(); k++)
+		{
+			if(k < rects.size())
+				targets[k] = rects[k];
+			insert(k);
+		}
+		for(auto& l : lastChecked)
+			l = SIZE_MAX;
 
 		bool done = true;
 
 		for(size_t j=0; j<rects.size(); j++)
 		{
+			if(fixed[j])
+				continue;
+
+			Rect rj = rects[j];
+			rj.expand(margin, margin);
+
+			//Find everything in the cells we touch
+			candidates.clear();
+			int x0 = floor(rj.get_left() * 1.0f / cellsize);
+			int x1 = floor(rj.get_right() * 1.0f / cellsize);
+			int y0 = floor(rj.get_top() * 1.0f / cellsize);
+			int y1 = floor(rj.get_bottom() * 1.0f / cellsize);
+			for(int y=y0; y<=y1; y++)
+			{
+				for(int x=x0; x<=x1; x++)
+				{
+					auto it = grid.find(Cell(x, y));
+					if(it == grid.end())
+						continue;
+					for(auto k : it->second)
+					{
+						if(lastChecked[k] == j)
+							continue;
+						lastChecked[k] = j;
+						candidates.push_back(k);
+					}
+				}
+			}
+
 			vec2f force(0, 0);
 
 			//Repulsive force pushing us away from the centroid of all other rectangles.
-			for(size_t k=0; k<targets.size(); k++)
+			for(auto k : candidates)
 			{
 				//no self-intersection
 				if(j == k)
 					continue;
 
-				Rect rj = rects[j];
+				Rect overlap = rj;
 				Rect rk = targets[k];
-				rj.expand(margin, margin);
 				rk.expand(margin, margin);
 
 				//if no overlap, ignore
-				if(!rj.intersects(rk))
+				if(!overlap.intersects(rk))
 					continue;
 
 				done = false;
 
 				//Scale force by amount of overlap.
-				rj.intersect(rk);
-				float scale = rj.get_width() * rj.get_height();
+				overlap.intersect(rk);
+				float scale = overlap.get_width() * overlap.get_height();
 
 				auto delta = (centers[k] - centers[j]);
 				force -= delta.norm() * scale * 0.01;
@@ -1293,6 +1293,9 @@ void WaveformArea::OnCoupling(OscilloscopeChannel::CouplingType type, Gtk::Radio
 
 void WaveformArea::OnWaveformDataReady()
 {
+	//Cursor measurements need to be recomputed against the new waveform
+	m_cursorSums.Invalidate();
+
 	//If we're a fixed width curve, refresh the parent's time scale
 	if(IsEyeOrBathtub())
 	{
@@ -1914,7 +1917,7 @@ int64_t WaveformArea::SnapX(int64_t time, int x, int y)
 	//Binary search to find the closest start point to the target timestamp.
 	size_t ibest;
 	if(swfm)
-		ibest = BinarySearchForGequal(swfm->m_offsets.GetCpuPointer(), data->size(), wtime);
+		ibest = WaveformGeometry::BinarySearchForGequal(swfm->m_offsets.GetCpuPointer(), data->size(), wtime);
 	else
 		ibest = wtime;
 
@@ -44,9 +44,6 @@
 
 using namespace std;
 
-template size_t WaveformArea::BinarySearchForGequal<float>(float* buf, size_t len, float value);
-template size_t WaveformArea::BinarySearchForGequal<int64_t>(int64_t* buf, size_t len, int64_t value);
-
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // WaveformRenderData
 
@@ -135,193 +132,47 @@ void WaveformArea::PrepareGeometry(WaveformRenderData* wdata, bool update_wavefo
 		wdata->m_geometryOK = false;
 		return;
 	}
-	auto pdat = wdata->m_channel.GetData();
-	if( (pdat == NULL) || pdat->empty() || (wdata->m_count == 0) )
-	{
-		wdata->m_geometryOK = false;
-		return;
-	}
-
-	//Bail if timebase is garbage
-	if(pdat->m_timescale == 0)
-	{
-		wdata->m_geometryOK = false;
-		return;
-	}
-
-	//Make sure capture is the right type
-	auto sandat = dynamic_cast<SparseAnalogWaveform*>(pdat);
-	auto uandat = dynamic_cast<UniformAnalogWaveform*>(pdat);
-	auto sdigdat = dynamic_cast<SparseDigitalWaveform*>(pdat);
-	auto udigdat = dynamic_cast<UniformDigitalWaveform*>(pdat);
-	if(!sandat && !uandat && !sdigdat && !udigdat)
-	{
-		wdata->m_geometryOK = false;
-		return;
-	}
-
-	//FIXME: Until we implement a Vulkan based rendering shader, need to have the data on the CPU
-	pdat->PrepareForCpuAccess();
 
 	//Figure out zero voltage level and scaling
+	WaveformGeometry geom;
 	auto height = area->m_height;
-	float ybase = height/2;
-	float yscale = area->m_pixelsPerYAxisUnit;
-	if(sdigdat || udigdat)
+	geom.m_ybase = height/2;
+	geom.m_yscale = area->m_pixelsPerYAxisUnit;
+	if(wdata->IsDigital())
 	{
-		float digheight;
-
 		//Overlay?
 		if(area->m_overlayPositions.find(wdata->m_channel) != area->m_overlayPositions.end())
 		{
-			ybase = area->m_height - (area->m_overlayPositions[wdata->m_channel] + 10);
-			digheight = 20;
+			geom.m_ybase = area->m_height - (area->m_overlayPositions[wdata->m_channel] + 10);
+			geom.m_yscale = 20;
 		}
 
 		//Main channel
 		else
 		{
-			ybase = 2;
-			digheight = height - 5;
+			geom.m_ybase = 2;
+			geom.m_yscale = height - 5;
 		}
-
-		yscale = digheight;
 	}
 
-	//Download actual waveform timestamps and voltages
-	if(update_waveform)
-	{
-		if(sandat)
-			memcpy(wdata->m_mappedYBuffer, sandat->m_samples.GetCpuPointer(), wdata->m_count*sizeof(float));
-		else if(uandat)
-			memcpy(wdata->m_mappedYBuffer, uandat->m_samples.GetCpuPointer(), wdata->m_count*sizeof(float));
-		else if(sdigdat)
-			memcpy(wdata->m_mappedDigitalYBuffer, sdigdat->m_samples.GetCpuPointer(), wdata->m_count*sizeof(bool));
-		else if(udigdat)
-			memcpy(wdata->m_mappedDigitalYBuffer, udigdat->m_samples.GetCpuPointer(), wdata->m_count*sizeof(bool));
-
-		//Copy the X axis timestamps, no conversion needed.
-		//But if dense packed, we can skip this
-		if(sandat)
-			memcpy(wdata->m_mappedXBuffer, sandat->m_offsets.GetCpuPointer(), wdata->m_count*sizeof(int64_t));
-		else if(sdigdat)
-			memcpy(wdata->m_mappedXBuffer, sdigdat->m_offsets.GetCpuPointer(), wdata->m_count*sizeof(int64_t));
-
-		//TODO: skip for dense packed digital path too once the shader supports that
-		//For now, fill it beacuse apparently the shader still needs it?
-		else if(udigdat)
-		{
-			for(size_t i=0; i<wdata->m_count; i++)
-				wdata->m_mappedXBuffer[i] = i;
-		}
-	}
+	geom.m_count = wdata->m_count;
+	geom.m_width = area->m_width;
+	geom.m_plotRight = area->m_plotRight;
+	geom.m_height = height;
+	geom.m_yoff = wdata->m_channel.GetOffset();
+	geom.m_xAxisOffset = area->m_group->m_xAxisOffset;
+	geom.m_pixelsPerXUnit = area->m_group->m_pixelsPerXUnit;
+	geom.m_persistDecay = wdata->m_persistence ? persistDecay : 0;
 
-	//Calculate indexes for rendering of sparse waveforms
-	//TODO: can we parallelize this? move to a compute shader?
-	auto group = wdata->m_area->m_group;
-	int64_t offset_samples = (group->m_xAxisOffset - pdat->m_triggerPhase) / pdat->m_timescale;
-	double xscale = (pdat->m_timescale * group->m_pixelsPerXUnit);
-	if(sandat || sdigdat || udigdat)
-	{
-		int64_t* offsets;
-		if(sandat)
-			offsets = sandat->m_offsets.GetCpuPointer();
-		else if(sdigdat)
-			offsets = sdigdat->m_offsets.GetCpuPointer();
-		else
-			offsets = wdata->m_mappedXBuffer;
+	geom.m_xBuffer = wdata->m_mappedXBuffer;
+	geom.m_yBuffer = wdata->m_mappedYBuffer;
+	geom.m_digitalYBuffer = wdata->m_mappedDigitalYBuffer;
+	geom.m_indexBuffer = wdata->m_mappedIndexBuffer;
+	geom.m_configBuffer = wdata->m_mappedConfigBuffer;
+	geom.m_configBuffer64 = wdata->m_mappedConfigBuffer64;
+	geom.m_floatConfigBuffer = wdata->m_mappedFloatConfigBuffer;
 
-		for(int j=0; j<wdata->m_area->m_width; j++)
-		{
-			int64_t target = floor(j / xscale) + offset_samples;
-			wdata->m_mappedIndexBuffer[j] = BinarySearchForGequal(
-				offsets,
-				wdata->m_count,
-				target-2);
-		}
-	}
-
-	//Scale alpha by zoom.
-	//As we zoom out more, reduce alpha to get proper intensity grading
-	int64_t lastOff;
-	auto end = pdat->size() - 1;
-	if(sandat || uandat)
-		lastOff = GetOffsetScaled(sandat, uandat, end);
-	else
-		lastOff = GetOffsetScaled(sdigdat, udigdat, end);
-	float capture_len = lastOff;
-	float avg_sample_len = capture_len / pdat->size();
-	float samplesPerPixel = 1.0 / (group->m_pixelsPerXUnit * avg_sample_len);
-	float alpha_scaled = alpha / sqrt(samplesPerPixel);
-	alpha_scaled = min(1.0f, alpha_scaled) * 2;
-
-	//Config stuff
-	int64_t innerxoff = group->m_xAxisOffset / pdat->m_timescale;
-	int64_t fractional_offset = group->m_xAxisOffset % pdat->m_timescale;
-	wdata->m_mappedConfigBuffer64[0] = -innerxoff;											//innerXoff
-	wdata->m_mappedConfigBuffer[2] = height;												//windowHeight
-	wdata->m_mappedConfigBuffer[3] = wdata->m_area->m_plotRight;							//windowWidth
-	wdata->m_mappedConfigBuffer[4] = wdata->m_count;										//depth
-	wdata->m_mappedConfigBuffer[5] = offset_samples - 2;									//offset_samples
-	wdata->m_mappedFloatConfigBuffer[6] = alpha_scaled;										//alpha
-	wdata->m_mappedFloatConfigBuffer[7] = (pdat->m_triggerPhase - fractional_offset) * group->m_pixelsPerXUnit;	//xoff
-	wdata->m_mappedFloatConfigBuffer[8] = xscale;											//xscale
-	wdata->m_mappedFloatConfigBuffer[9] = ybase;											//ybase
-	wdata->m_mappedFloatConfigBuffer[10] = yscale;											//yscale
-	wdata->m_mappedFloatConfigBuffer[11] = wdata->m_channel.GetOffset();					//yoff
-
-	//persistScale
-	if(!wdata->m_persistence)
-		wdata->m_mappedFloatConfigBuffer[12] = 0;
-	else
-		wdata->m_mappedFloatConfigBuffer[12] = persistDecay;
-
-	//Done
-	wdata->m_geometryOK = true;
-}
-
-/**
-	@brief Look for a value greater than or equal to "value" in buf and return the index
- */
-template<class T>
-size_t WaveformArea::BinarySearchForGequal(T* buf, size_t len, T value)
-{
-	size_t pos = len/2;
-	size_t last_lo = 0;
-	size_t last_hi = len-1;
-
-	//Clip if out of range
-	if(buf[0] >= value)
-		return 0;
-	if(buf[last_hi] < value)
-		return len-1;
-
-	while(true)
-	{
-		LogIndenter li;
-
-		//Stop if we've bracketed the target
-		if( (last_hi - last_lo) <= 1)
-			break;
-
-		//Move down
-		if(buf[pos] > value)
-		{
-			size_t delta = pos - last_lo;
-			last_hi = pos;
-			pos = last_lo + delta/2;
-		}
-
-		//Move up
-		else
-		{
-			size_t delta = last_hi - pos;
-			last_lo = pos;
-			pos = last_hi - delta/2;
-		}
-	}
-
-	return last_lo;
+	wdata->m_geometryOK = geom.Prepare(wdata->m_channel.GetData(), update_waveform, alpha);
 }
 
 void WaveformArea::ResetTextureFiltering()
@@ -415,6 +266,8 @@ bool WaveformArea::on_render(const Glib::RefPtr<Gdk::GLContext>& /*context*/)
 	if(m_parent->IsLoadInProgress())
 		return true;
 
+	TraceSpan span("WaveformArea::on_render");
+
 	LogIndenter li;
 	float persistDecay = GetPersistenceDecayCoefficient();
 
@@ -424,7 +277,9 @@ bool WaveformArea::on_render(const Glib::RefPtr<Gdk::GLContext>& /*context*/)
 
 	//This block cares about waveform data.
 	{
+		TraceSpan lockSpan("Lock waveform data");
 		lock_guard<recursive_mutex> lock(m_parent->m_waveformDataMutex);
+		lockSpan.End();
 
 		UpdateCachedScales();
 
@@ -0,0 +1,200 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformGeometry
+ */
+#include "../scopehal/scopehal.h"
+#include "WaveformGeometry.h"
+
+using namespace std;
+
+/**
+	@brief Copies a waveform into the destination buffers and calculates the shader configuration for it
+
+	@param pdat				Analog or digital waveform to draw
+	@param update_waveform	True to copy the sample data, false to only update the index and config buffers
+	@param alpha			Trace alpha at 1 sample per pixel
+
+	@return True if the geometry is good to render
+ */
+bool WaveformGeometry::Prepare(WaveformBase* pdat, bool update_waveform, float alpha)
+{
+	if( (pdat == NULL) || pdat->empty() || (m_count == 0) )
+		return false;
+
+	//Bail if timebase is garbage
+	if(pdat->m_timescale == 0)
+		return false;
+
+	//Make sure capture is the right type
+	auto sandat = dynamic_cast<SparseAnalogWaveform*>(pdat);
+	auto uandat = dynamic_cast<UniformAnalogWaveform*>(pdat);
+	auto sdigdat = dynamic_cast<SparseDigitalWaveform*>(pdat);
+	auto udigdat = dynamic_cast<UniformDigitalWaveform*>(pdat);
+	if(!sandat && !uandat && !sdigdat && !udigdat)
+		return false;
+
+	//FIXME: Until we implement a Vulkan based rendering shader, need to have the data on the CPU
+	pdat->PrepareForCpuAccess();
+
+	//Download actual waveform timestamps and voltages
+	if(update_waveform)
+	{
+		if(sandat)
+			memcpy(m_yBuffer, sandat->m_samples.GetCpuPointer(), m_count*sizeof(float));
+		else if(uandat)
+			memcpy(m_yBuffer, uandat->m_samples.GetCpuPointer(), m_count*sizeof(float));
+		else if(sdigdat)
+			memcpy(m_digitalYBuffer, sdigdat->m_samples.GetCpuPointer(), m_count*sizeof(bool));
+		else if(udigdat)
+			memcpy(m_digitalYBuffer, udigdat->m_samples.GetCpuPointer(), m_count*sizeof(bool));
+
+		//Copy the X axis timestamps, no conversion needed.
+		//But if dense packed, we can skip this
+		if(sandat)
+			memcpy(m_xBuffer, sandat->m_offsets.GetCpuPointer(), m_count*sizeof(int64_t));
+		else if(sdigdat)
+			memcpy(m_xBuffer, sdigdat->m_offsets.GetCpuPointer(), m_count*sizeof(int64_t));
+
+		//TODO: skip for dense packed digital path too once the shader supports that
+		//For now, fill it beacuse apparently the shader still needs it?
+		else if(udigdat)
+		{
+			for(size_t i=0; i<m_count; i++)
+				m_xBuffer[i] = i;
+		}
+	}
+
+	//Calculate indexes for rendering of sparse waveforms
+	//TODO: can we parallelize this? move to a compute shader?
+	int64_t offset_samples = (m_xAxisOffset - pdat->m_triggerPhase) / pdat->m_timescale;
+	double xscale = (pdat->m_timescale * m_pixelsPerXUnit);
+	if(sandat || sdigdat || udigdat)
+	{
+		int64_t* offsets;
+		if(sandat)
+			offsets = sandat->m_offsets.GetCpuPointer();
+		else if(sdigdat)
+			offsets = sdigdat->m_offsets.GetCpuPointer();
+		else
+			offsets = m_xBuffer;
+
+		for(int j=0; j<m_width; j++)
+		{
+			int64_t target = floor(j / xscale) + offset_samples;
+			m_indexBuffer[j] = BinarySearchForGequal(
+				offsets,
+				m_count,
+				target-2);
+		}
+	}
+
+	//Scale alpha by zoom.
+	//As we zoom out more, reduce alpha to get proper intensity grading
+	int64_t lastOff;
+	auto end = pdat->size() - 1;
+	if(sandat || uandat)
+		lastOff = GetOffsetScaled(sandat, uandat, end);
+	else
+		lastOff = GetOffsetScaled(sdigdat, udigdat, end);
+	float capture_len = lastOff;
+	float avg_sample_len = capture_len / pdat->size();
+	float samplesPerPixel = 1.0 / (m_pixelsPerXUnit * avg_sample_len);
+	float alpha_scaled = alpha / sqrt(samplesPerPixel);
+	alpha_scaled = min(1.0f, alpha_scaled) * 2;
+
+	//Config stuff
+	int64_t innerxoff = m_xAxisOffset / pdat->m_timescale;
+	int64_t fractional_offset = m_xAxisOffset % pdat->m_timescale;
+	m_configBuffer64[0] = -innerxoff;											//innerXoff
+	m_configBuffer[2] = m_height;												//windowHeight
+	m_configBuffer[3] = m_plotRight;											//windowWidth
+	m_configBuffer[4] = m_count;												//depth
+	m_configBuffer[5] = offset_samples - 2;										//offset_samples
+	m_floatConfigBuffer[6] = alpha_scaled;										//alpha
+	m_floatConfigBuffer[7] = (pdat->m_triggerPhase - fractional_offset) * m_pixelsPerXUnit;	//xoff
+	m_floatConfigBuffer[8] = xscale;											//xscale
+	m_floatConfigBuffer[9] = m_ybase;											//ybase
+	m_floatConfigBuffer[10] = m_yscale;											//yscale
+	m_floatConfigBuffer[11] = m_yoff;											//yoff
+	m_floatConfigBuffer[12] = m_persistDecay;									//persistScale
+
+	return true;
+}
+
+/**
+	@brief Look for a value greater than or equal to "value" in buf and return the index
+ */
+template<class T>
+size_t WaveformGeometry::BinarySearchForGequal(T* buf, size_t len, T value)
+{
+	size_t pos = len/2;
+	size_t last_lo = 0;
+	size_t last_hi = len-1;
+
+	//Clip if out of range
+	if(buf[0] >= value)
+		return 0;
+	if(buf[last_hi] < value)
+		return len-1;
+
+	while(true)
+	{
+		LogIndenter li;
+
+		//Stop if we've bracketed the target
+		if( (last_hi - last_lo) <= 1)
+			break;
+
+		//Move down
+		if(buf[pos] > value)
+		{
+			size_t delta = pos - last_lo;
+			last_hi = pos;
+			pos = last_lo + delta/2;
+		}
+
+		//Move up
+		else
+		{
+			size_t delta = last_hi - pos;
+			last_lo = pos;
+			pos = last_hi - delta/2;
+		}
+	}
+
+	return last_lo;
+}
+
+template size_t WaveformGeometry::BinarySearchForGequal<float>(float* buf, size_t len, float value);
+template size_t WaveformGeometry::BinarySearchForGequal<int64_t>(int64_t* buf, size_t len, int64_t value);
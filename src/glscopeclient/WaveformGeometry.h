@@ -0,0 +1,114 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformGeometry
+ */
+
+#ifndef WaveformGeometry_h
+#define WaveformGeometry_h
+
+/**
+	@brief CPU side of preparing a waveform for the rendering shaders
+
+	Holds the plot parameters and destination buffers WaveformArea::PrepareGeometry() fills in from a
+	WaveformRenderData. The buffers are normally mapped GL buffers, but Prepare() doesn't touch GL so it can be run
+	(and benchmarked) without a GL context.
+ */
+class WaveformGeometry
+{
+public:
+	WaveformGeometry()
+	: m_count(0)
+	, m_width(0)
+	, m_plotRight(0)
+	, m_height(0)
+	, m_ybase(0)
+	, m_yscale(1)
+	, m_yoff(0)
+	, m_xAxisOffset(0)
+	, m_pixelsPerXUnit(1)
+	, m_persistDecay(0)
+	, m_xBuffer(nullptr)
+	, m_yBuffer(nullptr)
+	, m_digitalYBuffer(nullptr)
+	, m_indexBuffer(nullptr)
+	, m_configBuffer(nullptr)
+	, m_configBuffer64(nullptr)
+	, m_floatConfigBuffer(nullptr)
+	{}
+
+	bool Prepare(WaveformBase* pdat, bool update_waveform, float alpha);
+
+	template<class T> static size_t BinarySearchForGequal(T* buf, size_t len, T value);
+
+	///@brief Number of samples in the buffers
+	size_t m_count;
+
+	///@brief Plot width in pixels (one index buffer entry per column)
+	int m_width;
+
+	///@brief X position of the right edge of the plot
+	float m_plotRight;
+
+	///@brief Plot height in pixels
+	int m_height;
+
+	///@brief Y position of zero, in pixels
+	float m_ybase;
+
+	///@brief Pixels per Y axis unit
+	float m_yscale;
+
+	///@brief Channel offset, in Y axis units
+	float m_yoff;
+
+	///@brief X axis position of the left edge of the plot
+	int64_t m_xAxisOffset;
+
+	///@brief Pixels per X axis unit
+	float m_pixelsPerXUnit;
+
+	///@brief Persistence decay coefficient, or zero if persistence is off
+	float m_persistDecay;
+
+	//Destination buffers
+	int64_t* m_xBuffer;
+	float* m_yBuffer;
+	bool* m_digitalYBuffer;
+	uint32_t* m_indexBuffer;
+	uint32_t* m_configBuffer;
+	int64_t* m_configBuffer64;
+	float* m_floatConfigBuffer;
+};
+
+#endif
@@ -107,6 +107,10 @@ WaveformGroup::WaveformGroup(OscilloscopeWindow* parent)
 		m_hideItem.set_label("Hide");
 		m_hideItem.signal_activate().connect(sigc::mem_fun(*this, &WaveformGroup::OnHideStatistic));
 
+	m_contextMenu.append(m_resetAccumItem);
+		m_resetAccumItem.set_label("Reset Accumulated Statistics");
+		m_resetAccumItem.signal_activate().connect(sigc::mem_fun(*this, &WaveformGroup::OnResetAccumulated));
+
 	m_contextMenu.show_all();
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -124,14 +128,19 @@ WaveformGroup::~WaveformGroup()
 	if(m_propertiesDialog)
 		delete m_propertiesDialog;
 
+	//Make sure the statistics engine is done with our statistics before we free anything.
+	//Don't go through DisableStats() here, the other groups may already have been deleted.
+	auto& engine = m_parent->GetStatisticsEngine();
+	auto children = m_treeModel->children();
+	for(auto row : children)
+		engine.RemoveStatistic(row[m_treeColumns.m_statColumn]);
+
 	//Free each of our channels
-	for(size_t i=1; i<32; i++)
-	{
-		if(m_indexToColumnMap.find(i) != m_indexToColumnMap.end())
-			DisableStats(m_indexToColumnMap[i]);
-	}
+	for(auto it : m_indexToColumnMap)
+		it.second.m_channel->Release();
+	m_indexToColumnMap.clear();
+	m_columnToIndexMap.clear();
 
-	auto children = m_treeModel->children();
 	for(auto row : children)
 	{
 		Statistic* stat = row[m_treeColumns.m_statColumn];
@@ -221,10 +230,16 @@ void WaveformGroup::EnableStats(StreamDescriptor stream, size_t index)
 	col->get_first_cell()->property_xalign() = 1.0;
 	col->set_alignment(Gtk::ALIGN_END);
 
-	RefreshMeasurements();
-
 	stream.m_channel->AddRef();
 
+	//Evaluate the new column right away so it isn't blank until the next trigger
+	m_parent->UpdateStatisticsRequests();
+	{
+		lock_guard<recursive_mutex> lock(m_parent->m_waveformDataMutex);
+		m_parent->GetStatisticsEngine().Evaluate();
+	}
+	RefreshMeasurements();
+
 	m_measurementView.show_all();
 	HideInactiveColumns();
 }
@@ -237,11 +252,20 @@ void WaveformGroup::DisableStats(StreamDescriptor stream)
 	m_measurementView.get_column(index)->set_title("");
 	auto children = m_treeModel->children();
 	for(auto row : children)
+	{
 		row[m_treeColumns.m_columns[index]] = "";
+		for(auto child : row.children())
+			child[m_treeColumns.m_columns[index]] = "";
+
+		pair<Statistic*, StreamDescriptor> key(row[m_treeColumns.m_statColumn], stream);
+		m_accumulated.erase(key);
+		m_lastAccumulatedWaveform.erase(key);
+	}
 
 	//Remove everything from our column records and free the channel
 	m_columnToIndexMap.erase(stream);
 	m_indexToColumnMap.erase(index);
+	m_parent->UpdateStatisticsRequests();
 	stream.m_channel->Release();
 
 	HideInactiveColumns();
@@ -261,17 +285,72 @@ void WaveformGroup::AddStatistic(Statistic* stat)
 	auto row = *m_treeModel->append();
 	row[m_treeColumns.m_statColumn] = stat;
 	row[m_treeColumns.m_filterColumn] = stat->GetStatisticDisplayName();
+
+	//Child rows for the accumulated statistics
+	static const char* names[ACCUM_COUNT_MAX] =
+	{
+		"Count",
+		"Mean",
+		"Std dev",
+		"Minimum",
+		"Maximum",
+		"1st percentile",
+		"Median",
+		"99th percentile"
+	};
+	for(int i=0; i<ACCUM_COUNT_MAX; i++)
+	{
+		auto child = *m_treeModel->append(row.children());
+		child[m_treeColumns.m_statColumn] = nullptr;
+		child[m_treeColumns.m_accumColumn] = i;
+		child[m_treeColumns.m_filterColumn] = names[i];
+	}
+
+	m_parent->UpdateStatisticsRequests();
 }
 
 void WaveformGroup::ClearStatistics()
+{
+	auto& engine = m_parent->GetStatisticsEngine();
+	auto children = m_treeModel->children();
+	for(auto row : children)
+		engine.Clear(row[m_treeColumns.m_statColumn]);
+
+	OnResetAccumulated();
+}
+
+void WaveformGroup::OnResetAccumulated()
+{
+	for(auto& it : m_accumulated)
+		it.second.Clear();
+	m_lastAccumulatedWaveform.clear();
+
+	RefreshMeasurements();
+}
+
+/**
+	@brief Appends every (statistic, stream) pair shown in this group to a list
+ */
+void WaveformGroup::GetStatisticsRequests(vector<StatisticsRequest>& requests)
 {
 	auto children = m_treeModel->children();
 	for(auto row : children)
-		static_cast<Statistic*>(row[m_treeColumns.m_statColumn])->Clear();
+	{
+		Statistic* stat = row[m_treeColumns.m_statColumn];
+		for(auto it : m_indexToColumnMap)
+			requests.push_back(StatisticsRequest(stat, it.second));
+	}
 }
 
+/**
+	@brief Displays the most recent results from the statistics engine
+
+	Must be called from the GUI thread. The statistics themselves are evaluated by StatisticsEngine.
+ */
 void WaveformGroup::RefreshMeasurements()
 {
+	auto& engine = m_parent->GetStatisticsEngine();
+
 	//New tree view
 	auto children = m_treeModel->children();
 	for(auto row : children)
@@ -283,19 +362,33 @@ void WaveformGroup::RefreshMeasurements()
 			if(m_indexToColumnMap.find(i) == m_indexToColumnMap.end())
 				continue;
 			auto chan = m_indexToColumnMap[i];
-
-			//Make sure the inputs of the block are on the CPU
 			auto data = chan.GetData();
 			if(data == nullptr)
 				continue;
-			data->PrepareForCpuAccess();
 
-			//Evaluate the statistic
+			//Fetch the result
+			auto unit = chan.GetYAxisUnits();
+			pair<Statistic*, StreamDescriptor> key(stat, chan);
+			auto& acc = m_accumulated[key];
 			double value;
-			if(!stat->Calculate(chan, value))
+			if(!engine.GetResult(stat, chan, value))
 				row[m_treeColumns.m_columns[i]] = "(error)";
 			else
-				row[m_treeColumns.m_columns[i]] = chan.GetYAxisUnits().PrettyPrint(value);
+			{
+				row[m_treeColumns.m_columns[i]] = unit.PrettyPrint(value);
+
+				//Results are re-published whenever the filter graph runs (parameter changes, history browsing, etc).
+				//Only accumulate waveforms newer than anything we've seen, so each trigger is counted once.
+				pair<time_t, int64_t> stamp(data->m_startTimestamp, data->m_startFemtoseconds);
+				auto it = m_lastAccumulatedWaveform.find(key);
+				if( (it == m_lastAccumulatedWaveform.end()) || (stamp > it->second) )
+				{
+					acc.Add(value);
+					m_lastAccumulatedWaveform[key] = stamp;
+				}
+			}
+
+			RefreshAccumulatedRows(row, i, acc, unit);
 		}
 	}
 
@@ -320,6 +413,78 @@ void WaveformGroup::RefreshMeasurements()
 	}
 }
 
+/**
+	@brief Displays an accumulated statistic in the child rows of its statistic
+ */
+void WaveformGroup::RefreshAccumulatedRows(Gtk::TreeRow row, size_t col, AccumulatedStatistic& acc, Unit unit)
+{
+	for(auto child : row.children())
+	{
+		string text;
+		if(acc.GetCount() != 0)
+		{
+			int prop = child[m_treeColumns.m_accumColumn];
+			switch(prop)
+			{
+				case ACCUM_COUNT:
+					text = to_string(acc.GetCount());
+					break;
+
+				case ACCUM_MEAN:
+					text = unit.PrettyPrint(acc.GetMean());
+					break;
+
+				case ACCUM_STDDEV:
+					text = unit.PrettyPrint(acc.GetStdDev());
+					break;
+
+				case ACCUM_MIN:
+					text = unit.PrettyPrint(acc.GetMin());
+					break;
+
+				case ACCUM_MAX:
+					text = unit.PrettyPrint(acc.GetMax());
+					break;
+
+				case ACCUM_P1:
+					text = unit.PrettyPrint(acc.GetQuantile(0.01));
+					break;
+
+				case ACCUM_P50:
+					text = unit.PrettyPrint(acc.GetQuantile(0.5));
+					break;
+
+				case ACCUM_P99:
+					text = unit.PrettyPrint(acc.GetQuantile(0.99));
+					break;
+
+				default:
+					break;
+			}
+		}
+		child[m_treeColumns.m_columns[col]] = text;
+	}
+}
+
+/**
+	@brief Restores the accumulated statistics of a stream from a saved session
+
+	@param stream	The stream (must already have stats enabled)
+	@param node		The "accumulated" node of the stream's stats config
+ */
+void WaveformGroup::LoadAccumulatedStatistics(StreamDescriptor stream, const YAML::Node& node)
+{
+	auto children = m_treeModel->children();
+	for(auto row : children)
+	{
+		Statistic* stat = row[m_treeColumns.m_statColumn];
+		auto snode = node[stat->GetStatisticDisplayName()];
+		if(snode)
+			m_accumulated[pair<Statistic*, StreamDescriptor>(stat, stream)].Load(snode);
+	}
+	RefreshMeasurements();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 string WaveformGroup::SerializeConfiguration(IDTable& table)
@@ -398,6 +563,22 @@ string WaveformGroup::SerializeConfiguration(IDTable& table)
 			config += tmp;
 			snprintf(tmp, sizeof(tmp), "                    stream: %zu\n", it.second.m_stream);
 			config += tmp;
+
+			//Accumulated statistics, so soak tests can pick up where they left off
+			string accum;
+			auto rows = m_treeModel->children();
+			for(auto row : rows)
+			{
+				Statistic* stat = row[m_treeColumns.m_statColumn];
+				auto ait = m_accumulated.find(pair<Statistic*, StreamDescriptor>(stat, it.second));
+				if( (ait == m_accumulated.end()) || (ait->second.GetCount() == 0) )
+					continue;
+
+				accum += "                        \"" + stat->GetStatisticDisplayName() + "\":\n";
+				accum += ait->second.Serialize("                            ");
+			}
+			if(!accum.empty())
+				config += "                    accumulated:\n" + accum;
 		}
 	}
 
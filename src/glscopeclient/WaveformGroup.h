@@ -37,6 +37,8 @@
 #define WaveformGroup_h
 
 #include "Timeline.h"
+#include "StatisticsEngine.h"
+#include "AccumulatedStatistic.h"
 
 class OscilloscopeWindow;
 class WaveformGroupPropertiesDialog;
@@ -57,12 +59,16 @@ public:
 			add(m_columns[i]);
 		}
 		add(m_statColumn);
+		add(m_accumColumn);
 	}
 
 	Gtk::TreeModelColumn<std::string> m_filterColumn;
 	std::vector<Gtk::TreeModelColumn<std::string>> m_columns;
 
 	Gtk::TreeModelColumn<Statistic*> m_statColumn;
+
+	//For child rows, which property of the accumulated statistic they show
+	Gtk::TreeModelColumn<int> m_accumColumn;
 };
 
 class WaveformGroup
@@ -82,6 +88,8 @@ public:
 
 	void AddStatistic(Statistic* stat);
 	void ClearStatistics();
+	void GetStatisticsRequests(std::vector<StatisticsRequest>& requests);
+	void LoadAccumulatedStatistics(StreamDescriptor stream, const YAML::Node& node);
 
 	int GetIndexOfChild(Gtk::Widget* child);
 	bool IsLastChild(Gtk::Widget* child);
@@ -142,9 +150,34 @@ protected:
 	Gtk::Menu m_contextMenu;
 		Gtk::MenuItem m_propertiesItem;
 		Gtk::MenuItem m_hideItem;
+		Gtk::MenuItem m_resetAccumItem;
 
 	void OnStatisticProperties();
 	void OnHideStatistic();
+	void OnResetAccumulated();
+
+	void RefreshAccumulatedRows(Gtk::TreeRow row, size_t col, AccumulatedStatistic& acc, Unit unit);
+
+	//Properties of an accumulated statistic shown in the child rows of each statistic
+	enum AccumulatedProperty
+	{
+		ACCUM_COUNT,
+		ACCUM_MEAN,
+		ACCUM_STDDEV,
+		ACCUM_MIN,
+		ACCUM_MAX,
+		ACCUM_P1,
+		ACCUM_P50,
+		ACCUM_P99,
+
+		ACCUM_COUNT_MAX
+	};
+
+	//Per-trigger values of every statistic accumulated since the last reset
+	std::map<std::pair<Statistic*, StreamDescriptor>, AccumulatedStatistic> m_accumulated;
+
+	//Start time of the newest waveform folded into each accumulated statistic, so each trigger is only counted once
+	std::map<std::pair<Statistic*, StreamDescriptor>, std::pair<time_t, int64_t> > m_lastAccumulatedWaveform;
 
 	WaveformGroupPropertiesDialog* m_propertiesDialog;
 	void OnPropertiesDialogResponse(int response);
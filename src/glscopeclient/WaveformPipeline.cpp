@@ -0,0 +1,176 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformPipeline
+ */
+#include "../scopehal/scopehal.h"
+#include "../scopehal/Filter.h"
+#include "Tracer.h"
+#include "FilterGraphProfiler.h"
+#include "StatisticsEngine.h"
+#include "WaveformPipeline.h"
+
+using namespace std;
+
+/**
+	@brief Checks if every online instrument has a waveform ready to download
+ */
+bool WaveformPipeline::HasPendingWaveforms(const vector<Oscilloscope*>& scopes)
+{
+	for(auto scope : scopes)
+	{
+		if(scope->IsOffline())
+			continue;
+		if(!scope->HasPendingWaveforms())
+			return false;
+	}
+	return true;
+}
+
+/**
+	@brief Pulls the oldest pending waveform out of each online instrument's queue and makes it current
+
+	The previous waveforms are detached from their channels first, not freed: the history window owns them.
+
+	@param scopes	All instruments, primary first
+	@param deskew	Trigger skew of each secondary instrument relative to the primary
+ */
+void WaveformPipeline::DownloadWaveforms(const vector<Oscilloscope*>& scopes, map<Oscilloscope*, int64_t>& deskew)
+{
+	//Process the waveform data from each instrument
+	for(auto scope : scopes)
+	{
+		//Don't touch anything offline
+		if(scope->IsOffline())
+			continue;
+
+		//Make sure we don't free the old waveform data
+		for(size_t i=0; i<scope->GetChannelCount(); i++)
+		{
+			auto chan = scope->GetChannel(i);
+			for(size_t j=0; j<chan->GetStreamCount(); j++)
+				chan->Detach(j);
+		}
+
+		//Download the data
+		TraceSpan span("PopPendingWaveform");
+		scope->PopPendingWaveform();
+	}
+
+	if(scopes.size() > 1)
+		PatchSecondaryTimestamps(scopes, deskew);
+}
+
+/**
+	@brief In multi-scope mode, retcon the timestamps of secondary scopes' waveforms so they line up with the primary
+ */
+void WaveformPipeline::PatchSecondaryTimestamps(const vector<Oscilloscope*>& scopes, map<Oscilloscope*, int64_t>& deskew)
+{
+	LogTrace("Multi scope: patching timestamps\n");
+	LogIndenter li;
+
+	//Get the timestamp of the primary scope's first waveform
+	bool hit = false;
+	time_t timeSec = 0;
+	int64_t timeFs  = 0;
+	auto prim = scopes[0];
+	for(size_t i=0; i<prim->GetChannelCount(); i++)
+	{
+		auto chan = prim->GetChannel(i);
+		for(size_t j=0; j<chan->GetStreamCount(); j++)
+		{
+			auto data = chan->GetData(j);
+			if(data != nullptr)
+			{
+				timeSec = data->m_startTimestamp;
+				timeFs = data->m_startFemtoseconds;
+				hit = true;
+				break;
+			}
+		}
+		if(hit)
+			break;
+	}
+
+	//Patch all secondary scopes
+	for(size_t i=1; i<scopes.size(); i++)
+	{
+		auto sec = scopes[i];
+
+		for(size_t j=0; j<sec->GetChannelCount(); j++)
+		{
+			auto chan = sec->GetChannel(j);
+			for(size_t k=0; k<chan->GetStreamCount(); k++)
+			{
+				auto data = chan->GetData(k);
+				if(data == nullptr)
+					continue;
+
+				auto skew = deskew[sec];
+
+				data->m_startTimestamp = timeSec;
+				data->m_startFemtoseconds = timeFs;
+				data->m_triggerPhase -= skew;
+			}
+		}
+	}
+}
+
+/**
+	@brief Re-runs the filter graph, then evaluates statistics on the results
+
+	@param filters	Snapshot of every filter instance, taken under the filter updating lock
+	@param executor	Executor to run the graph on
+	@param profiler	If profiling is enabled, the graph is run through this instead (one filter at a time, with a trace
+					span per filter). The executor's worker threads are in libscopehal and can't be traced per filter.
+	@param stats	Statistics engine to publish new results from
+ */
+void WaveformPipeline::RefreshFilters(
+	const set<Filter*>& filters,
+	FilterGraphExecutor& executor,
+	FilterGraphProfiler& profiler,
+	StatisticsEngine& stats)
+{
+	{
+		TraceSpan span("FilterGraphExecutor::RunBlocking");
+		if(profiler.IsEnabled())
+			profiler.Run(executor, filters);
+		else
+			executor.RunBlocking(filters);
+	}
+
+	//Evaluate statistics after the filter graph update is complete.
+	//The GUI picks up the results in OnAllWaveformsUpdated().
+	TraceSpan span("StatisticsEngine::Evaluate");
+	stats.Evaluate();
+}
@@ -0,0 +1,71 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformPipeline
+ */
+
+#ifndef WaveformPipeline_h
+#define WaveformPipeline_h
+
+class FilterGraphProfiler;
+class StatisticsEngine;
+
+/**
+	@brief The GUI independent stages run for every trigger: pulling waveforms from the instruments, re-running the
+	filter graph and evaluating statistics
+
+	OscilloscopeWindow calls these from the waveform processing thread with the waveform data mutex held. They don't
+	touch any GTK or GL state, so they can also be driven without a window (see tests/Benchmarks/pipelinebench).
+ */
+class WaveformPipeline
+{
+public:
+	static bool HasPendingWaveforms(const std::vector<Oscilloscope*>& scopes);
+
+	static void DownloadWaveforms(
+		const std::vector<Oscilloscope*>& scopes,
+		std::map<Oscilloscope*, int64_t>& deskew);
+
+	static void RefreshFilters(
+		const std::set<Filter*>& filters,
+		FilterGraphExecutor& executor,
+		FilterGraphProfiler& profiler,
+		StatisticsEngine& stats);
+
+protected:
+	static void PatchSecondaryTimestamps(
+		const std::vector<Oscilloscope*>& scopes,
+		std::map<Oscilloscope*, int64_t>& deskew);
+};
+
+#endif
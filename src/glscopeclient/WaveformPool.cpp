@@ -0,0 +1,398 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformPool
+ */
+#include "glscopeclient.h"
+#include "WaveformPool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+WaveformPool::WaveformPool()
+	: m_bytes(0)
+	, m_maxBytes(1024LL * 1024LL * 1024LL)
+{
+}
+
+WaveformPool::~WaveformPool()
+{
+	for(auto& it : m_buckets)
+	{
+		for(auto& e : it.second)
+			delete e.m_wfm;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Size estimation
+
+/**
+	@brief Estimates the amount of memory used by a waveform, including its sample buffers
+ */
+size_t WaveformPool::GetMemoryUsage(WaveformBase* wfm)
+{
+	auto sacap = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	if(sacap != NULL)
+	{
+		return sizeof(SparseAnalogWaveform) +
+			sizeof(float) * sacap->m_samples.capacity() +
+			sizeof(int64_t) * sacap->m_offsets.capacity() +
+			sizeof(int64_t) * sacap->m_durations.capacity();
+	}
+
+	auto uacap = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	if(uacap != NULL)
+		return sizeof(UniformAnalogWaveform) + sizeof(float) * uacap->m_samples.capacity();
+
+	auto sdcap = dynamic_cast<SparseDigitalWaveform*>(wfm);
+	if(sdcap != NULL)
+	{
+		return sizeof(SparseDigitalWaveform) +
+			sizeof(bool) * sdcap->m_samples.capacity() +
+			sizeof(int64_t) * sdcap->m_offsets.capacity() +
+			sizeof(int64_t) * sdcap->m_durations.capacity();
+	}
+
+	auto udcap = dynamic_cast<UniformDigitalWaveform*>(wfm);
+	if(udcap != NULL)
+		return sizeof(UniformDigitalWaveform) + sizeof(bool) * udcap->m_samples.capacity();
+
+	auto sbcap = dynamic_cast<SparseDigitalBusWaveform*>(wfm);
+	if(sbcap != NULL)
+	{
+		size_t bytes = sizeof(SparseDigitalBusWaveform);
+		if(!sbcap->m_samples.empty())
+		{
+			bytes +=
+				(sbcap->m_samples[0].size() * sizeof(bool) + sizeof(vector<bool>))
+				* sbcap->m_samples.capacity();
+			bytes += sizeof(int64_t) * sbcap->m_offsets.capacity();
+			bytes += sizeof(int64_t) * sbcap->m_durations.capacity();
+		}
+		return bytes;
+	}
+
+	//Unknown type, we don't know how big the samples are
+	return 0;
+}
+
+/**
+	@brief Gets the number of samples a waveform can hold without reallocating
+ */
+size_t WaveformPool::GetCapacity(WaveformBase* wfm)
+{
+	auto sacap = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	if(sacap != NULL)
+		return sacap->m_samples.capacity();
+	auto uacap = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	if(uacap != NULL)
+		return uacap->m_samples.capacity();
+	auto sdcap = dynamic_cast<SparseDigitalWaveform*>(wfm);
+	if(sdcap != NULL)
+		return sdcap->m_samples.capacity();
+	auto udcap = dynamic_cast<UniformDigitalWaveform*>(wfm);
+	if(udcap != NULL)
+		return udcap->m_samples.capacity();
+	auto sbcap = dynamic_cast<SparseDigitalBusWaveform*>(wfm);
+	if(sbcap != NULL)
+		return sbcap->m_samples.capacity();
+	return 0;
+}
+
+/**
+	@brief Gets the capacity class for a given sample count (index of the highest set bit, plus one)
+ */
+int WaveformPool::GetSizeClass(size_t capacity)
+{
+	int n = 0;
+	while(capacity)
+	{
+		capacity >>= 1;
+		n++;
+	}
+	return n;
+}
+
+/**
+	@brief Gets the amount of physical memory available to new allocations, or SIZE_MAX if we can't tell
+
+	On Linux this is MemAvailable, which unlike MemFree counts page cache the kernel can reclaim.
+ */
+size_t WaveformPool::GetAvailableMemory()
+{
+#ifdef _WIN32
+	MEMORYSTATUSEX status;
+	status.dwLength = sizeof(status);
+	if(GlobalMemoryStatusEx(&status))
+		return status.ullAvailPhys;
+	return SIZE_MAX;
+#else
+
+#ifdef __linux__
+	FILE* fp = fopen("/proc/meminfo", "r");
+	if(fp)
+	{
+		char line[256];
+		unsigned long long kb;
+		while(fgets(line, sizeof(line), fp))
+		{
+			if(1 == sscanf(line, "MemAvailable: %llu kB", &kb))
+			{
+				fclose(fp);
+				return kb * 1024;
+			}
+		}
+		fclose(fp);
+	}
+#endif
+
+	//Older kernels and other platforms: fall back to free pages
+#ifdef _SC_AVPHYS_PAGES
+	long pages = sysconf(_SC_AVPHYS_PAGES);
+	long pagesize = sysconf(_SC_PAGESIZE);
+	if( (pages < 0) || (pagesize < 0) )
+		return SIZE_MAX;
+	return (size_t)pages * pagesize;
+#else
+	return SIZE_MAX;
+#endif
+
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pool management
+
+/**
+	@brief Adds a waveform to the pool, taking ownership of it
+
+	The waveform's samples are cleared but its buffers are kept. If the pool is full, the largest waveforms are freed
+	to make room.
+ */
+void WaveformPool::Add(WaveformBase* wfm)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	//Don't bother pooling anything we can't size
+	size_t bytes = GetMemoryUsage(wfm);
+	if( (bytes == 0) || (bytes > m_maxBytes) )
+	{
+		delete wfm;
+		return;
+	}
+
+	int sizeClass = GetSizeClass(GetCapacity(wfm));
+
+	//Empty the waveform, but keep its buffers
+	auto sacap = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	auto uacap = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	auto sdcap = dynamic_cast<SparseDigitalWaveform*>(wfm);
+	auto udcap = dynamic_cast<UniformDigitalWaveform*>(wfm);
+	auto sbcap = dynamic_cast<SparseDigitalBusWaveform*>(wfm);
+	if(sacap)
+	{
+		sacap->m_samples.clear();
+		sacap->m_offsets.clear();
+		sacap->m_durations.clear();
+	}
+	else if(uacap)
+		uacap->m_samples.clear();
+	else if(sdcap)
+	{
+		sdcap->m_samples.clear();
+		sdcap->m_offsets.clear();
+		sdcap->m_durations.clear();
+	}
+	else if(udcap)
+		udcap->m_samples.clear();
+	else if(sbcap)
+	{
+		sbcap->m_samples.clear();
+		sbcap->m_offsets.clear();
+		sbcap->m_durations.clear();
+	}
+
+	TrimLocked(m_maxBytes - bytes);
+	m_buckets[BucketKey(type_index(typeid(*wfm)), sizeClass)].push_back(PoolEntry(wfm, bytes));
+	m_bytes += bytes;
+}
+
+/**
+	@brief Removes a waveform of the requested type from the pool
+
+	We look in the capacity class of the request first, then up to two classes larger, so we never hand out a buffer
+	more than about 4x larger than needed. If the capacity is not known, the largest waveform available is returned.
+
+	@return The waveform, or NULL if nothing suitable is in the pool
+ */
+WaveformBase* WaveformPool::Remove(type_index type, size_t capacity)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	int firstClass;
+	int lastClass;
+	if(capacity == 0)
+	{
+		firstClass = 8 * sizeof(size_t);
+		lastClass = 0;
+	}
+	else
+	{
+		firstClass = GetSizeClass(capacity);
+		lastClass = firstClass + 2;
+	}
+
+	int step = (firstClass <= lastClass) ? 1 : -1;
+	for(int c = firstClass; ; c += step)
+	{
+		auto it = m_buckets.find(BucketKey(type, c));
+		if(it != m_buckets.end())
+		{
+			auto& bucket = it->second;
+			for(size_t i=bucket.size(); i > 0; i--)
+			{
+				//Waveforms in the same class might still be a bit too small
+				auto entry = bucket[i-1];
+				if(GetCapacity(entry.m_wfm) < capacity)
+					continue;
+
+				bucket.erase(bucket.begin() + (i-1));
+				m_bytes -= entry.m_bytes;
+				return entry.m_wfm;
+			}
+		}
+
+		if(c == lastClass)
+			break;
+	}
+
+	return NULL;
+}
+
+/**
+	@brief Hands a pooled waveform of the same type and size as an existing one to the scope's own allocation pool
+
+	Drivers only recycle waveforms from the scope's analog and digital pools, so we feed those from ours after each
+	acquisition, replacing the buffers the history just took ownership of.
+ */
+void WaveformPool::RefillScopePool(Oscilloscope* scope, WaveformBase* like)
+{
+	auto uacap = dynamic_cast<UniformAnalogWaveform*>(like);
+	auto sdcap = dynamic_cast<SparseDigitalWaveform*>(like);
+
+	WaveformBase* wfm = NULL;
+	if(uacap)
+		wfm = Remove(type_index(typeid(UniformAnalogWaveform)), uacap->m_samples.size());
+	else if(sdcap)
+		wfm = Remove(type_index(typeid(SparseDigitalWaveform)), sdcap->m_samples.size());
+	if(!wfm)
+		return;
+
+	if(uacap)
+		scope->AddWaveformToAnalogPool(wfm);
+	else
+		scope->AddWaveformToDigitalPool(wfm);
+}
+
+/**
+	@brief Sets the maximum size of the pool, freeing waveforms if it's already bigger than that
+ */
+void WaveformPool::SetMaxBytes(size_t bytes)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_maxBytes = bytes;
+	TrimLocked(bytes);
+}
+
+/**
+	@brief Frees waveforms until the pool is no bigger than the requested size
+ */
+void WaveformPool::Trim(size_t bytes)
+{
+	lock_guard<mutex> lock(m_mutex);
+	TrimLocked(bytes);
+}
+
+/**
+	@brief Empties the pool if free system memory drops below a threshold
+
+	Pooled waveforms are only a cache, so it's better to drop them than push the system into swap.
+ */
+void WaveformPool::CheckMemoryPressure(size_t threshold)
+{
+	if(GetBytes() == 0)
+		return;
+	if(GetAvailableMemory() >= threshold)
+		return;
+
+	LogTrace("Low on memory, freeing waveform pool\n");
+	Trim(0);
+}
+
+/**
+	@brief Frees waveforms, largest first, until the pool is no bigger than the requested size
+
+	Must be called with m_mutex held.
+ */
+void WaveformPool::TrimLocked(size_t bytes)
+{
+	while(m_bytes > bytes)
+	{
+		//Find the largest non-empty class
+		auto largest = m_buckets.end();
+		for(auto it = m_buckets.begin(); it != m_buckets.end(); it++)
+		{
+			if(it->second.empty())
+				continue;
+			if( (largest == m_buckets.end()) || (it->first.second > largest->first.second) )
+				largest = it;
+		}
+		if(largest == m_buckets.end())
+			break;
+
+		//Free the oldest waveform in it
+		auto& bucket = largest->second;
+		auto entry = bucket.front();
+		bucket.erase(bucket.begin());
+		m_bytes -= entry.m_bytes;
+		delete entry.m_wfm;
+	}
+}
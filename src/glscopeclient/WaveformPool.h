@@ -0,0 +1,121 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformPool
+ */
+
+#ifndef WaveformPool_h
+#define WaveformPool_h
+
+#include <typeindex>
+
+/**
+	@brief Cache of discarded waveforms, kept around so their sample buffers can be reused
+
+	Waveforms are bucketed by type and capacity class (power-of-two sample count), so a request for a deep capture
+	doesn't get handed a tiny buffer that immediately has to be reallocated. The total size of the pool is capped,
+	and the pool can be emptied when the system is short on memory.
+ */
+class WaveformPool
+{
+public:
+	WaveformPool();
+	~WaveformPool();
+
+	void Add(WaveformBase* wfm);
+	void RefillScopePool(Oscilloscope* scope, WaveformBase* like);
+
+	void SetMaxBytes(size_t bytes);
+	void Trim(size_t bytes);
+	void CheckMemoryPressure(size_t threshold);
+
+	///@brief Total size of all pooled waveforms
+	size_t GetBytes()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_bytes;
+	}
+
+	/**
+		@brief Gets a waveform of type T from the pool
+
+		@param capacity	Number of samples the caller is going to need, or zero if not known
+
+		@return A waveform with no samples, or a newly allocated one if the pool has nothing suitable
+	 */
+	template<class T> T* Get(size_t capacity)
+	{
+		auto wfm = dynamic_cast<T*>(Remove(std::type_index(typeid(T)), capacity));
+		if(wfm)
+			return wfm;
+		return new T;
+	}
+
+	static size_t GetMemoryUsage(WaveformBase* wfm);
+	static size_t GetCapacity(WaveformBase* wfm);
+	static size_t GetAvailableMemory();
+
+protected:
+	WaveformBase* Remove(std::type_index type, size_t capacity);
+	void TrimLocked(size_t bytes);
+
+	static int GetSizeClass(size_t capacity);
+
+	typedef std::pair<std::type_index, int> BucketKey;
+
+	///@brief A pooled waveform, and its size when it was added
+	class PoolEntry
+	{
+	public:
+		PoolEntry(WaveformBase* wfm, size_t bytes)
+			: m_wfm(wfm)
+			, m_bytes(bytes)
+		{}
+
+		WaveformBase* m_wfm;
+		size_t m_bytes;
+	};
+
+	///@brief Protects all of our state
+	std::mutex m_mutex;
+
+	///@brief Pooled waveforms, by type and capacity class
+	std::map<BucketKey, std::vector<PoolEntry> > m_buckets;
+
+	///@brief Total size of the pooled waveforms
+	size_t m_bytes;
+
+	///@brief Maximum size of the pool
+	size_t m_maxBytes;
+};
+
+#endif
@@ -60,11 +60,18 @@ void WaveformProcessingThread(OscilloscopeWindow* window)
 		}
 
 		//We've got data. Download it, then run the filter graph
-		window->DownloadWaveforms();
-		window->RefreshAllFilters();
+		{
+			TraceSpan span("DownloadWaveforms");
+			window->DownloadWaveforms();
+		}
+		{
+			TraceSpan span("RefreshAllFilters");
+			window->RefreshAllFilters();
+		}
 
 		//Unblock the UI threads, then wait for acknowledgement that it's processed
 		g_waveformReadyEvent.Signal();
+		TraceSpan span("Wait for UI");
 		g_waveformProcessedEvent.Block();
 	}
 }
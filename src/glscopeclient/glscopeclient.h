@@ -61,6 +61,7 @@
 #include <thread>
 #include <vector>
 #include "Event.h"
+#include "Tracer.h"
 
 #include <giomm.h>
 #include <gtkmm.h>
@@ -42,6 +42,7 @@
 #include "../scopeprotocols/scopeprotocols.h"
 #include "../scopeexports/scopeexports.h"
 #include <libgen.h>
+#include <signal.h>
 #include <omp.h>
 #include <chrono>
 #include <iostream>
@@ -53,6 +54,7 @@
 #endif
 
 #include "PreferenceManager.h"
+#include "BatchProcessor.h"
 using namespace std;
 
 //for color selection
@@ -82,6 +84,8 @@ void help()
 			"    --retrigger : when loading a .scopesession from the command line, start triggering immediately\n"
 			"                  (default is to be paused)\n"
 			"    --version   : print version number. (not yet implemented)\n"
+			"    --batch <dir> : run the filter graph of a .scopesession over each saved waveform without a GUI,\n"
+			"                    writing measurements and protocol decodes as CSV to an existing directory\n"
 			"\n"
 			"  [logger options]:\n"
 			"    levels: ERROR, WARNING, NOTICE, VERBOSE, DEBUG\n"
@@ -101,6 +105,8 @@ void help()
 			"    --nogpufilter                 : Do not use Vulkan accelerated versions of filter blocks, use CPU reference implementation only\n"
 			"    --quit-after-loading          : Exit immediately after loading the specified file.\n"
 			"                                    Typically used for profiling/benchmarking file load or filter graph operations.\n"
+			"    --perf-trace                  : Record a performance trace from startup (see Window | Performance Trace).\n"
+			"                                    On Linux, sending SIGUSR1 saves the trace to glscopeclient-trace-<time>.json.\n"
 			"\n"
 			"  [filename|scope]:\n"
 			"    filename : path to a .scopesession to load on startup\n"
@@ -118,6 +124,14 @@ void help()
 
 #ifndef _WIN32
 void Relaunch(int argc, char* argv[]);
+
+/**
+	@brief Requests a performance trace dump. The actual file I/O happens in OscilloscopeWindow::OnTimer.
+ */
+void OnTraceDumpSignal(int /*sig*/)
+{
+	Tracer::m_dumpRequested = true;
+}
 #endif
 
 int main(int argc, char* argv[])
@@ -137,6 +151,8 @@ int main(int argc, char* argv[])
 	#endif
 	bool quitAfterLoading = false;
 	bool nogpufilter = false;
+	bool perfTrace = false;
+	string batchDir;
 	for(int i=1; i<argc; i++)
 	{
 		string s(argv[i]);
@@ -174,6 +190,18 @@ int main(int argc, char* argv[])
 			nogpufilter = true;
 		else if(s == "--quit-after-loading")
 			quitAfterLoading = true;
+		else if(s == "--perf-trace")
+			perfTrace = true;
+		else if(s == "--batch")
+		{
+			if(i+1 < argc)
+				batchDir = argv[++i];
+			else
+			{
+				fprintf(stderr, "--batch requires an argument\n");
+				return 1;
+			}
+		}
 		else if(s[0] == '-')
 		{
 			fprintf(stderr, "Unrecognized command-line argument \"%s\", use --help\n", s.c_str());
@@ -228,7 +256,9 @@ int main(int argc, char* argv[])
 		}
 	#endif
 
-	g_app = new ScopeApp;
+	//No GTK at all in batch mode, we may not have a display
+	if(batchDir.empty())
+		g_app = new ScopeApp;
 
 	//Initialize object creation tables for predefined libraries
 	if(!VulkanInit(true))
@@ -256,10 +286,34 @@ int main(int argc, char* argv[])
 		g_gpuFilterEnabled = false;
 		LogDebug("Disabling GPU filters because --nogpufilter argument was passed\n");
 	}
+	if(perfTrace)
+		Tracer::Enable(true);
+	#ifndef _WIN32
+		signal(SIGUSR1, OnTraceDumpSignal);
+	#endif
 
 	//Initialize object creation tables for plugins
 	InitializePlugins();
 
+	//Headless processing of a saved session
+	if(!batchDir.empty())
+	{
+		if( (filesToLoad.size() != 1) || (filesToLoad[0].find(".scopesession") == string::npos) )
+		{
+			fprintf(stderr, "--batch requires exactly one .scopesession file\n");
+			return 1;
+		}
+
+		bool ok;
+		{
+			BatchProcessor batch;
+			ok = batch.Load(filesToLoad[0]) && batch.Run(batchDir);
+		}
+
+		ScopehalStaticCleanup();
+		return ok ? 0 : 1;
+	}
+
 	//Connect to the scope(s)
 	g_app->run(
 		g_app->ConnectToScopes(scopes),
@@ -325,7 +379,10 @@ void ScopeThread(Oscilloscope* scope)
 	{
 		//Push any pending queued commands
 		if(sscope)
+		{
+			TraceSpan span("FlushCommandQueue");
 			sscope->GetTransport()->FlushCommandQueue();
+		}
 
 		//If the queue is too big, stop grabbing data
 		size_t npending = scope->GetPendingWaveformCount();
@@ -369,12 +426,17 @@ void ScopeThread(Oscilloscope* scope)
 			continue;
 		}
 
+		TraceSpan pollSpan("PollTrigger");
 		auto stat = scope->PollTrigger();
+		pollSpan.End();
 
 		if(stat == Oscilloscope::TRIGGER_MODE_TRIGGERED)
 		{
 			//Collect the data, fail if that doesn't work
-			if(!scope->AcquireData())
+			TraceSpan acquireSpan("AcquireData");
+			bool ok = scope->AcquireData();
+			acquireSpan.End();
+			if(!ok)
 			{
 				tlast = GetTime();
 				continue;
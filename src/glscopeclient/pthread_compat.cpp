@@ -32,9 +32,12 @@
 #endif
 
 #include "pthread_compat.h"
+#include "Tracer.h"
 
 void pthread_setname_np_compat(const char *name)
 {
+	Tracer::SetThreadName(name);
+
 #if defined(unix) || defined(__unix__) || defined(__unix)
 	#if __linux__
 		// on Linux, max 16 chars including \0, see man page
@@ -57,6 +57,8 @@ MainWindow::MainWindow(vk::raii::Queue& queue)
 	, m_showPlot(false)
 	, m_session(this)
 {
+	SetMaxFps(m_preferences.GetInt("Appearance.Windows.max_fps"));
+
 	m_waveformGroups.push_back(make_shared<WaveformGroup>("Waveform Group 1", 2));
 	m_waveformGroups.push_back(make_shared<WaveformGroup>("Waveform Group 2", 3));
 
@@ -120,9 +122,13 @@ void MainWindow::RenderUI()
 	//Docking area to put all of the groups in
 	DockingArea();
 
+	//Pick up the newest processed waveforms. Everything drawn this frame comes from this one snapshot, so the
+	//display is consistent even while the waveform thread is working on the next acquisition.
+	auto snapshot = m_session.GetLatestWaveforms();
+
 	//Waveform groups
 	for(auto g : m_waveformGroups)
-		g->Render();
+		g->Render(snapshot);
 
 	//Dialog boxes
 	set< shared_ptr<Dialog> > dlgsToClose;
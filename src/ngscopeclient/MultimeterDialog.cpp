@@ -119,12 +119,18 @@ bool MultimeterDialog::DoRender()
 	bool hasSecondary = m_meter->GetSecondaryMeterMode() != Multimeter::NONE;
 	if(firstUpdateDone)
 	{
-		m_primaryHistory.AddPoint(etime, pri);
-		if(hasSecondary)
-			m_secondaryHistory.AddPoint(etime, sec);
+		//Add every reading taken since the last frame, at the time it was actually measured
+		TimestampedSample sample;
+		while(m_state->m_primaryHistory.Pop(sample))
+			m_primaryHistory.AddPoint(sample.m_time - m_tstart, sample.m_value);
+		while(m_state->m_secondaryHistory.Pop(sample))
+		{
+			if(hasSecondary)
+				m_secondaryHistory.AddPoint(sample.m_time - m_tstart, sample.m_value);
+		}
 
-		m_primaryHistory.Span = m_historyDepth;
-		m_secondaryHistory.Span = m_historyDepth;
+		m_primaryHistory.SetSpan(m_historyDepth);
+		m_secondaryHistory.SetSpan(m_historyDepth);
 	}
 
 	float valueWidth = 100;
@@ -155,7 +161,10 @@ bool MultimeterDialog::DoRender()
 		if(m_secondaryModeNames.empty())
 			ImGui::BeginDisabled();
 		if(Combo("Secondary Mode", m_secondaryModeNames, m_secondaryModeSelector))
+		{
 			m_meter->SetSecondaryMeterMode(m_secondaryModes[m_secondaryModeSelector]);
+			m_state->m_secondaryModeChanged = true;
+		}
 		if(m_secondaryModeNames.empty())
 			ImGui::EndDisabled();
 
@@ -191,6 +200,9 @@ bool MultimeterDialog::DoRender()
 			ImGui::EndDisabled();
 			HelpMarker("Most recent value for the secondary measurement");
 		}
+
+		ImGui::TextDisabled("%.1f Hz, %.1f ms/query", m_state->m_updateRate.load(), m_state->m_pollLatency.load() * 1000);
+		HelpMarker("Rate at which new primary readings are arriving, and round trip time to read each one.");
 	}
 
 	auto csize = ImGui::GetContentRegionAvail();
@@ -200,15 +212,7 @@ bool MultimeterDialog::DoRender()
 		{
 			ImPlot::SetupAxisLimits(ImAxis_X1, etime - m_historyDepth, etime, ImGuiCond_Always);
 
-			auto& hist = m_primaryHistory;
-			ImPlot::PlotLine(
-				primaryMode.c_str(),
-				&hist.Data[0].x,
-				&hist.Data[0].y,
-				hist.Data.size(),
-				0,
-				0,
-				2*sizeof(float));
+			m_primaryHistory.Plot(primaryMode.c_str(), etime - m_historyDepth, etime, ImPlot::GetPlotSize().x);
 
 			ImPlot::EndPlot();
 		}
@@ -223,16 +227,7 @@ bool MultimeterDialog::DoRender()
 		{
 			ImPlot::SetupAxisLimits(ImAxis_X1, etime - m_historyDepth, etime, ImGuiCond_Always);
 
-			auto& hist = m_secondaryHistory;
-
-			ImPlot::PlotLine(
-				secondaryMode.c_str(),
-				&hist.Data[0].x,
-				&hist.Data[0].y,
-				hist.Data.size(),
-				0,
-				0,
-				2*sizeof(float));
+			m_secondaryHistory.Plot(secondaryMode.c_str(), etime - m_historyDepth, etime, ImPlot::GetPlotSize().x);
 
 			ImPlot::EndPlot();
 		}
@@ -249,6 +244,9 @@ void MultimeterDialog::OnPrimaryModeChanged()
 	//Push the new mode to the meter
 	m_meter->SetMeterMode(m_primaryModes[m_primaryModeSelector]);
 
+	//Changing the primary mode may also change (or turn off) the secondary measurement
+	m_state->m_secondaryModeChanged = true;
+
 	//Clear historical data since we're not measuring the same thing anymore
 	m_primaryHistory.Clear();
 	m_secondaryHistory.Clear();
@@ -47,11 +47,27 @@ public:
 		m_primaryMeasurement = 0;
 		m_secondaryMeasurement = 0;
 		m_firstUpdateDone = false;
+		m_updateRate = 0;
+		m_pollLatency = 0;
+		m_secondaryModeChanged = false;
 	}
 
 	std::atomic<float> m_primaryMeasurement;
 	std::atomic<float> m_secondaryMeasurement;
 	std::atomic<bool> m_firstUpdateDone;
+
+	///@brief Achieved primary measurement update rate, in Hz
+	std::atomic<float> m_updateRate;
+
+	///@brief Round trip time of the primary measurement query, in seconds
+	std::atomic<float> m_pollLatency;
+
+	///@brief Set by the UI after changing the meter mode, so the meter thread re-reads the secondary mode
+	std::atomic<bool> m_secondaryModeChanged;
+
+	//Every reading since the UI last drained them, for trend plots
+	SampleQueue<> m_primaryHistory;
+	SampleQueue<> m_secondaryHistory;
 };
 
 #endif
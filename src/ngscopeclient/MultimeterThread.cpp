@@ -34,6 +34,7 @@
  */
 #include "ngscopeclient.h"
 #include "pthread_compat.h"
+#include "VulkanWindow.h"
 
 using namespace std;
 
@@ -43,17 +44,62 @@ void MultimeterThread(MultimeterThreadArgs args)
 
 	auto meter = args.meter;
 	auto state = args.state;
+
+	PollScheduler scheduler;
+	double lastUpdate = 0;
+
+	//Cached secondary mode. Not every driver caches this, so don't query it every time we need to know whether a
+	//secondary reading is due. It's re-read right away when the UI changes the mode, and at a low rate in case it
+	//was changed from the front panel.
+	bool hasSecondary = (meter->GetSecondaryMeterMode() != Multimeter::NONE);
+	scheduler.AddTask(1, [meter, &hasSecondary]()
+		{ hasSecondary = (meter->GetSecondaryMeterMode() != Multimeter::NONE); });
+
+	//Primary measurement: as fast as the meter can keep up with, capped at 50 Hz
+	scheduler.AddTask(0.02, [meter, state, &lastUpdate]()
+		{
+			//Timestamp each reading at the midpoint of the query
+			double tstart = GetTime();
+			float pri = meter->GetMeterValue();
+			double tend = GetTime();
+
+			state->m_primaryMeasurement = pri;
+			state->m_primaryHistory.Push((tstart + tend) / 2, pri);
+
+			//Smoothed stats for display
+			state->m_pollLatency = 0.9f*state->m_pollLatency + 0.1f*(tend - tstart);
+			if(lastUpdate > 0)
+				state->m_updateRate = 0.9f*state->m_updateRate + 0.1f/(tend - lastUpdate);
+			lastUpdate = tend;
+		});
+
+	//Secondary measurement, only if the meter is configured to make one
+	scheduler.AddTask(0.05, [meter, state]()
+		{
+			double tstart = GetTime();
+			float sec = meter->GetSecondaryMeterValue();
+			double tend = GetTime();
+
+			state->m_secondaryMeasurement = sec;
+			state->m_secondaryHistory.Push((tstart + tend) / 2, sec);
+		},
+		[&hasSecondary]() { return hasSecondary; });
+
 	while(!*args.shuttingDown)
 	{
 		//Flush any pending commands
 		meter->GetTransport()->FlushCommandQueue();
 
-		//Poll status
-		state->m_primaryMeasurement = meter->GetMeterValue();
-		state->m_secondaryMeasurement = meter->GetSecondaryMeterValue();
+		if(state->m_secondaryModeChanged.exchange(false))
+			hasSecondary = (meter->GetSecondaryMeterMode() != Multimeter::NONE);
+
+		//Poll everything that's due, and redraw if we got anything new
+		bool updated = scheduler.RunDue();
 		state->m_firstUpdateDone = true;
+		if(updated)
+			VulkanWindow::RequestRedraw();
 
-		//Cap update rate to 20 Hz
-		this_thread::sleep_for(chrono::milliseconds(50));
+		//Wake up in time for the next poll, but not so long that shutdown or queued commands get delayed
+		scheduler.WaitForNextDue(0.05);
 	}
 }
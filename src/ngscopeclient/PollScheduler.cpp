@@ -0,0 +1,112 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PollScheduler
+ */
+#include "ngscopeclient.h"
+#include "PollScheduler.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+PollScheduler::PollScheduler()
+	: m_lastBurstTime(0)
+{
+}
+
+/**
+	@brief Adds a new task
+
+	@param interval	Minimum time between polls, in seconds (zero means every pass)
+	@param poll		Function that queries the instrument
+	@param enabled	Optional function that returns false if the task should be skipped for now
+ */
+void PollScheduler::AddTask(double interval, function<void()> poll, function<bool()> enabled)
+{
+	m_tasks.push_back(PollTask(interval, poll, enabled));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Scheduling
+
+/**
+	@brief Runs every task whose interval has elapsed
+
+	@return True if any tasks were run
+ */
+bool PollScheduler::RunDue()
+{
+	bool ran = false;
+	double start = GetTime();
+	for(auto& task : m_tasks)
+	{
+		double now = GetTime();
+		if(now < task.m_nextDue)
+			continue;
+
+		//Skipped tasks get checked again on the next pass, so they start right back up once re-enabled
+		if(task.m_enabled && !task.m_enabled())
+			continue;
+
+		task.m_poll();
+		ran = true;
+
+		//Schedule relative to when we started, not when we finished, so slow queries don't drift the rate.
+		//If we fell more than a whole interval behind, don't try to catch up with a burst of back-to-back polls.
+		task.m_nextDue += task.m_interval;
+		if(task.m_nextDue < now)
+			task.m_nextDue = now + task.m_interval;
+	}
+	m_lastBurstTime = GetTime() - start;
+	return ran;
+}
+
+/**
+	@brief Sleeps until the next task is due, or maxWait seconds, whichever comes first
+ */
+void PollScheduler::WaitForNextDue(double maxWait)
+{
+	double now = GetTime();
+	double next = now + maxWait;
+	for(auto& task : m_tasks)
+	{
+		if(task.m_enabled && !task.m_enabled())
+			continue;
+		next = min(next, task.m_nextDue);
+	}
+
+	if(next > now)
+		this_thread::sleep_for(chrono::microseconds(static_cast<int64_t>((next - now) * 1e6)));
+}
@@ -0,0 +1,93 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PollScheduler
+ */
+#ifndef PollScheduler_h
+#define PollScheduler_h
+
+#include <functional>
+
+/**
+	@brief A single quantity polled periodically from an instrument
+ */
+class PollTask
+{
+public:
+	PollTask(double interval, std::function<void()> poll, std::function<bool()> enabled)
+	: m_interval(interval)
+	, m_nextDue(0)
+	, m_poll(poll)
+	, m_enabled(enabled)
+	{}
+
+	///@brief Minimum time between polls, in seconds
+	double m_interval;
+
+	///@brief Time at which the task should next run
+	double m_nextDue;
+
+	///@brief Queries the instrument and publishes the result
+	std::function<void()> m_poll;
+
+	///@brief Returns false if the task should be skipped for now (e.g. channel is turned off). May be empty.
+	std::function<bool()> m_enabled;
+};
+
+/**
+	@brief Runs a set of instrument queries, each at its own rate
+
+	Intended to be driven from an instrument thread: call RunDue() in a loop, then WaitForNextDue(). Every task that
+	is due gets run back to back so the queries go out in one burst rather than being spread over the sleep interval.
+ */
+class PollScheduler
+{
+public:
+	PollScheduler();
+
+	void AddTask(double interval, std::function<void()> poll, std::function<bool()> enabled = nullptr);
+
+	bool RunDue();
+	void WaitForNextDue(double maxWait);
+
+	///@brief Wall time spent running queries during the last RunDue() call, in seconds
+	double GetLastBurstTime()
+	{ return m_lastBurstTime; }
+
+protected:
+	std::vector<PollTask> m_tasks;
+
+	double m_lastBurstTime;
+};
+
+#endif
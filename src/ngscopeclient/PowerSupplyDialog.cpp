@@ -111,11 +111,15 @@ bool PowerSupplyDialog::DoRender()
 		//Update history
 		if(firstUpdateDone)
 		{
-			m_channelUIState[i].m_voltageHistory.AddPoint(t, v);
-			m_channelUIState[i].m_currentHistory.AddPoint(t, a);
+			//Add every reading taken since the last frame, at the time it was actually measured
+			TimestampedSample sample;
+			while(m_state->m_channelVoltageHistory[i].Pop(sample))
+				m_channelUIState[i].m_voltageHistory.AddPoint(sample.m_time - m_tstart, sample.m_value);
+			while(m_state->m_channelCurrentHistory[i].Pop(sample))
+				m_channelUIState[i].m_currentHistory.AddPoint(sample.m_time - m_tstart, sample.m_value);
 		}
-		m_channelUIState[i].m_voltageHistory.Span = m_historyDepth;
-		m_channelUIState[i].m_currentHistory.Span = m_historyDepth;
+		m_channelUIState[i].m_voltageHistory.SetSpan(m_historyDepth);
+		m_channelUIState[i].m_currentHistory.SetSpan(m_historyDepth);
 
 		ChannelSettings(i, v, a, t);
 	}
@@ -239,6 +243,13 @@ void PowerSupplyDialog::ChannelSettings(int i, float v, float a, float etime)
 
 			HelpMarker("Measured current being output by the supply");
 
+			ImGui::TextDisabled("%.1f Hz, %.1f ms/query",
+				m_state->m_channelUpdateRate[i].load(),
+				m_state->m_channelPollLatency[i].load() * 1000);
+			HelpMarker(
+				"Rate at which new voltage/current readings are arriving, and round trip time to read them.\n\n"
+				"Readings are not taken while the channel is turned off.");
+
 			ImGui::TreePop();
 		}
 
@@ -251,15 +262,8 @@ void PowerSupplyDialog::ChannelSettings(int i, float v, float a, float etime)
 			{
 				ImPlot::SetupAxisLimits(ImAxis_X1, etime - m_historyDepth, etime, ImGuiCond_Always);
 
-				auto& hist = m_channelUIState[i].m_voltageHistory;
-				ImPlot::PlotLine(
-					chname.c_str(),
-					&hist.Data[0].x,
-					&hist.Data[0].y,
-					hist.Data.size(),
-					0,
-					0,
-					2*sizeof(float));
+				m_channelUIState[i].m_voltageHistory.Plot(
+					chname.c_str(), etime - m_historyDepth, etime, ImPlot::GetPlotSize().x);
 
 				ImPlot::EndPlot();
 			}
@@ -268,16 +272,8 @@ void PowerSupplyDialog::ChannelSettings(int i, float v, float a, float etime)
 			{
 				ImPlot::SetupAxisLimits(ImAxis_X1, etime - m_historyDepth, etime, ImGuiCond_Always);
 
-				auto& hist = m_channelUIState[i].m_currentHistory;
-
-				ImPlot::PlotLine(
-					chname.c_str(),
-					&hist.Data[0].x,
-					&hist.Data[0].y,
-					hist.Data.size(),
-					0,
-					0,
-					2*sizeof(float));
+				m_channelUIState[i].m_currentHistory.Plot(
+					chname.c_str(), etime - m_historyDepth, etime, ImPlot::GetPlotSize().x);
 
 				ImPlot::EndPlot();
 			}
@@ -303,15 +299,8 @@ void PowerSupplyDialog::CombinedTrendPlot(float etime)
 		for(int i=0; i<m_psu->GetPowerChannelCount(); i++)
 		{
 			auto chname = m_psu->GetPowerChannelName(i);
-			auto& hist = m_channelUIState[i].m_voltageHistory;
-			ImPlot::PlotLine(
-				chname.c_str(),
-				&hist.Data[0].x,
-				&hist.Data[0].y,
-				hist.Data.size(),
-				0,
-				0,
-				2*sizeof(float));
+			m_channelUIState[i].m_voltageHistory.Plot(
+				chname.c_str(), etime - m_historyDepth, etime, ImPlot::GetPlotSize().x);
 		}
 
 		ImPlot::EndPlot();
@@ -324,15 +313,8 @@ void PowerSupplyDialog::CombinedTrendPlot(float etime)
 		for(int i=0; i<m_psu->GetPowerChannelCount(); i++)
 		{
 			auto chname = m_psu->GetPowerChannelName(i);
-			auto& hist = m_channelUIState[i].m_currentHistory;
-			ImPlot::PlotLine(
-				chname.c_str(),
-				&hist.Data[0].x,
-				&hist.Data[0].y,
-				hist.Data.size(),
-				0,
-				0,
-				2*sizeof(float));
+			m_channelUIState[i].m_currentHistory.Plot(
+				chname.c_str(), etime - m_historyDepth, etime, ImPlot::GetPlotSize().x);
 		}
 
 		ImPlot::EndPlot();
@@ -48,6 +48,10 @@ public:
 		m_channelCurrent = std::make_unique<std::atomic<float>[] >(n);
 		m_channelConstantCurrent = std::make_unique<std::atomic<bool>[] >(n);
 		m_channelFuseTripped = std::make_unique<std::atomic<bool>[] >(n);
+		m_channelVoltageHistory = std::make_unique<SampleQueue<>[] >(n);
+		m_channelCurrentHistory = std::make_unique<SampleQueue<>[] >(n);
+		m_channelUpdateRate = std::make_unique<std::atomic<float>[] >(n);
+		m_channelPollLatency = std::make_unique<std::atomic<float>[] >(n);
 
 		for(size_t i=0; i<n; i++)
 		{
@@ -55,6 +59,8 @@ public:
 			m_channelCurrent[i] = 0;
 			m_channelConstantCurrent[i] = false;
 			m_channelFuseTripped[i] = false;
+			m_channelUpdateRate[i] = 0;
+			m_channelPollLatency[i] = 0;
 		}
 
 		m_firstUpdateDone = false;
@@ -65,6 +71,16 @@ public:
 	std::unique_ptr<std::atomic<bool>[]> m_channelConstantCurrent;
 	std::unique_ptr<std::atomic<bool>[]> m_channelFuseTripped;
 
+	//Every reading since the UI last drained them, for trend plots
+	std::unique_ptr<SampleQueue<>[]> m_channelVoltageHistory;
+	std::unique_ptr<SampleQueue<>[]> m_channelCurrentHistory;
+
+	///@brief Achieved voltage/current update rate, in Hz
+	std::unique_ptr<std::atomic<float>[]> m_channelUpdateRate;
+
+	///@brief Round trip time of the voltage and current queries, in seconds
+	std::unique_ptr<std::atomic<float>[]> m_channelPollLatency;
+
 	std::atomic<bool> m_firstUpdateDone;
 };
 
@@ -34,6 +34,7 @@
  */
 #include "ngscopeclient.h"
 #include "pthread_compat.h"
+#include "VulkanWindow.h"
 
 using namespace std;
 
@@ -44,24 +45,82 @@ void PowerSupplyThread(PowerSupplyThreadArgs args)
 	auto psu = args.psu;
 	auto state = args.state;
 	auto nchans = psu->GetPowerChannelCount();
+
+	PollScheduler scheduler;
+	vector<double> lastUpdate(nchans, 0);
+
+	//Cached channel on/off state. Not every driver caches this, so query it at a low rate rather than every time
+	//we need to know whether a reading is due.
+	vector<bool> channelActive(nchans);
+	for(int i=0; i<nchans; i++)
+		channelActive[i] = psu->GetPowerChannelActive(i);
+
+	for(int i=0; i<nchans; i++)
+	{
+		scheduler.AddTask(0.25, [psu, i, &channelActive]()
+			{ channelActive[i] = psu->GetPowerChannelActive(i); });
+
+		//Measured values are only meaningful while the channel is on
+		auto active = [i, &channelActive]() { return channelActive[i]; };
+
+		//Voltage and current: as fast as the instrument can keep up with, capped at 50 Hz
+		scheduler.AddTask(0.02, [psu, state, i, &lastUpdate]()
+			{
+				//Timestamp each reading at the midpoint of the query
+				double tstart = GetTime();
+				float v = psu->GetPowerVoltageActual(i);
+				double tv = GetTime();
+				float a = psu->GetPowerCurrentActual(i);
+				double ta = GetTime();
+
+				state->m_channelVoltage[i] = v;
+				state->m_channelCurrent[i] = a;
+				state->m_channelVoltageHistory[i].Push((tstart + tv) / 2, v);
+				state->m_channelCurrentHistory[i].Push((tv + ta) / 2, a);
+
+				//Smoothed stats for display
+				state->m_channelPollLatency[i] = 0.9f*state->m_channelPollLatency[i] + 0.1f*(ta - tstart);
+				if(lastUpdate[i] > 0)
+					state->m_channelUpdateRate[i] = 0.9f*state->m_channelUpdateRate[i] + 0.1f/(ta - lastUpdate[i]);
+				lastUpdate[i] = ta;
+			},
+			active);
+
+		//Regulation mode doesn't need to be as responsive
+		scheduler.AddTask(0.1, [psu, state, i]()
+			{ state->m_channelConstantCurrent[i] = psu->IsPowerConstantCurrent(i); },
+			active);
+
+		//Overcurrent shutdown turns the channel off, so keep checking this even when it's not active
+		scheduler.AddTask(0.25, [psu, state, i]()
+			{ state->m_channelFuseTripped[i] = psu->GetPowerOvercurrentShutdownTripped(i); });
+	}
+
 	while(!*args.shuttingDown)
 	{
 		//Flush any pending commands
 		psu->GetTransport()->FlushCommandQueue();
 
-		//TODO: skip polling if the channel in question is off
+		//Poll everything that's due, and redraw if we got anything new
+		bool updated = scheduler.RunDue();
 
-		//Poll status
+		//Don't show stale readings for channels that are off
 		for(int i=0; i<nchans; i++)
 		{
-			state->m_channelVoltage[i] = psu->GetPowerVoltageActual(i);
-			state->m_channelCurrent[i] = psu->GetPowerCurrentActual(i);
-			state->m_channelConstantCurrent[i] = psu->IsPowerConstantCurrent(i);
-			state->m_channelFuseTripped[i] = psu->GetPowerOvercurrentShutdownTripped(i);
+			if(!channelActive[i])
+			{
+				state->m_channelVoltage[i] = 0;
+				state->m_channelCurrent[i] = 0;
+				state->m_channelConstantCurrent[i] = false;
+				state->m_channelUpdateRate[i] = 0;
+				lastUpdate[i] = 0;
+			}
 		}
 		state->m_firstUpdateDone = true;
+		if(updated)
+			VulkanWindow::RequestRedraw();
 
-		//Cap update rate to 20 Hz
-		this_thread::sleep_for(chrono::milliseconds(50));
+		//Wake up in time for the next poll, but not so long that shutdown or queued commands get delayed
+		scheduler.WaitForNextDue(0.05);
 	}
 }
@@ -250,6 +250,14 @@ void PreferenceManager::InitializeDefaults()
 				Preference::Color("trigger_bar_color", Gdk::Color("white"))
 				.Label("Trigger bar color")
 				.Description("Color for the dotted line shown when dragging a trigger"));
+			windows.AddPreference(
+				Preference::Int("max_fps", 60)
+				.Label("Max frame rate")
+				.Description(
+					"Upper limit on how often the window is redrawn.\n\n"
+					"The window is only redrawn when something changes (input, new data, or animations), so an idle "
+					"window uses almost no CPU regardless of this setting.")
+				.Unit(Unit::UNIT_HZ));
 
 	auto& drivers = this->m_treeRoot.AddCategory("Drivers");
 		auto& lecroy = drivers.AddCategory("Teledyne LeCroy");
@@ -0,0 +1,236 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of RollingBuffer
+ */
+#include "ngscopeclient.h"
+#include "RollingBuffer.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+RollingBuffer::RollingBuffer(size_t capacity)
+	: m_span(10)
+	, m_points(capacity)
+{
+	//Add levels until a single bucket would cover the whole ring
+	size_t pointsPerBucket = DECIMATION_FACTOR;
+	while(pointsPerBucket < capacity)
+	{
+		m_levels.push_back(RollingRing<Bucket>(capacity / pointsPerBucket + 1));
+		pointsPerBucket *= DECIMATION_FACTOR;
+	}
+}
+
+void RollingBuffer::Clear()
+{
+	m_points.Clear();
+	for(auto& level : m_levels)
+		level.Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Data input
+
+void RollingBuffer::AddPoint(float x, float y)
+{
+	uint64_t index = m_points.GetNext();
+	m_points.Push(ImVec2(x, y));
+
+	//Close out any buckets this point completed
+	uint64_t count = index + 1;
+	for(size_t level=0; level<m_levels.size(); level++)
+	{
+		if( (count % DECIMATION_FACTOR) != 0)
+			break;
+		count /= DECIMATION_FACTOR;
+		AddBucket(level, count - 1);
+	}
+
+	//Expire old history
+	float cutoff = x - m_span;
+	while(!m_points.empty() && (m_points.front().x < cutoff) )
+		m_points.PopFront();
+	for(auto& level : m_levels)
+	{
+		while(!level.empty() && (level.front().m_xend < cutoff) )
+			level.PopFront();
+	}
+}
+
+/**
+	@brief Summarizes the DECIMATION_FACTOR entries of the level below into bucket "index" of m_levels[level]
+ */
+void RollingBuffer::AddBucket(size_t level, uint64_t index)
+{
+	Bucket b;
+	b.m_min = FLT_MAX;
+	b.m_max = -FLT_MAX;
+	b.m_xstart = FLT_MAX;
+	b.m_xend = -FLT_MAX;
+
+	uint64_t start = index * DECIMATION_FACTOR;
+	uint64_t end = start + DECIMATION_FACTOR;
+	if(level == 0)
+	{
+		start = max(start, m_points.GetFirst());
+		for(uint64_t i=start; i<end; i++)
+		{
+			auto& p = m_points[i];
+			b.m_xstart = min(b.m_xstart, p.x);
+			b.m_xend = max(b.m_xend, p.x);
+			b.m_min = min(b.m_min, p.y);
+			b.m_max = max(b.m_max, p.y);
+		}
+	}
+	else
+	{
+		auto& below = m_levels[level-1];
+		start = max(start, below.GetFirst());
+		for(uint64_t i=start; i<end; i++)
+		{
+			auto& c = below[i];
+			b.m_xstart = min(b.m_xstart, c.m_xstart);
+			b.m_xend = max(b.m_xend, c.m_xend);
+			b.m_min = min(b.m_min, c.m_min);
+			b.m_max = max(b.m_max, c.m_max);
+		}
+	}
+
+	//The newest entry of the level below always exists (it was just added), so b is never empty.
+	//Buckets are completed strictly in order, so the ring's next sequence number is always "index".
+	m_levels[level].Push(b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Rendering
+
+/**
+	@brief Returns the sequence number of the first raw point with x >= the given value
+ */
+uint64_t RollingBuffer::FindFirstPoint(float x)
+{
+	uint64_t lo = m_points.GetFirst();
+	uint64_t hi = m_points.GetNext();
+	while(lo < hi)
+	{
+		uint64_t mid = lo + (hi - lo)/2;
+		if(m_points[mid].x < x)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+void RollingBuffer::EmitBucket(size_t level, uint64_t index)
+{
+	//Draw each bucket as a vertical min-max line; adjacent buckets join up into the envelope
+	auto& b = m_levels[level][index];
+	float x = (b.m_xstart + b.m_xend) / 2;
+	m_plotPoints.push_back(ImVec2(x, b.m_min));
+	m_plotPoints.push_back(ImVec2(x, b.m_max));
+}
+
+/**
+	@brief Plots the portion of the history within [xmin, xmax] as an ImPlot line
+
+	Must be called between ImPlot::BeginPlot() and ImPlot::EndPlot().
+
+	@param label	Legend label
+	@param xmin		Left edge of the plot
+	@param xmax		Right edge of the plot
+	@param width	Plot width in pixels
+ */
+void RollingBuffer::Plot(const char* label, float xmin, float xmax, float width)
+{
+	m_plotPoints.clear();
+
+	//Visible range of raw points, plus one on the left so the line starts at the edge of the plot
+	uint64_t start = FindFirstPoint(xmin);
+	if(start > m_points.GetFirst())
+		start --;
+	uint64_t end = FindFirstPoint(xmax);
+	if(end < m_points.GetNext())
+		end ++;
+
+	//Find the coarsest level that still has at least one bucket per pixel
+	auto npixels = static_cast<uint64_t>(max(width, 1.0f));
+	size_t level = 0;
+	uint64_t pointsPerBucket = 1;
+	while( (level < m_levels.size()) && ( (end - start) / (pointsPerBucket * DECIMATION_FACTOR) >= npixels) )
+	{
+		level ++;
+		pointsPerBucket *= DECIMATION_FACTOR;
+	}
+
+	uint64_t pos = start;
+	if(level > 0)
+	{
+		//Whole buckets at the selected level, then progressively finer buckets for the partial one at the end
+		//(which has not been summarized yet)
+		pos = start / pointsPerBucket * pointsPerBucket;
+		for(size_t n=level; n>0; n--)
+		{
+			auto& ring = m_levels[n-1];
+			for(uint64_t i = pos / pointsPerBucket; (i+1)*pointsPerBucket <= end; i++)
+			{
+				if(i >= ring.GetNext())
+					break;
+				if(i >= ring.GetFirst())
+					EmitBucket(n-1, i);
+				pos = (i+1) * pointsPerBucket;
+			}
+			pointsPerBucket /= DECIMATION_FACTOR;
+		}
+		pos = max(pos, m_points.GetFirst());
+	}
+
+	//Remaining raw points
+	for(uint64_t i=pos; i<end; i++)
+		m_plotPoints.push_back(m_points[i]);
+
+	if(m_plotPoints.empty())
+		return;
+
+	ImPlot::PlotLine(
+		label,
+		&m_plotPoints[0].x,
+		&m_plotPoints[0].y,
+		m_plotPoints.size(),
+		0,
+		0,
+		2*sizeof(float));
+}
@@ -27,6 +27,7 @@
 *                                                                                                                      *
 ***********************************************************************************************************************/
 
+
 /**
 	@file
 	@author Andrew D. Zonenberg
@@ -36,35 +37,121 @@
 #define RollingBuffer_h
 
 /**
-	@brief Realtime plot helper (based on implot_demo)
+	@brief Fixed capacity FIFO indexed by absolute sequence number
+
+	Once full, pushing a new element overwrites the oldest. Storage is allocated as it fills, not up front.
  */
-struct RollingBuffer
+template<class T>
+class RollingRing
 {
-	float Span;
-	ImVector<ImVec2> Data;
+public:
+	RollingRing(size_t capacity = 1)
+	: m_capacity(capacity)
+	, m_first(0)
+	, m_next(0)
+	{}
 
-	RollingBuffer()
+	void Clear()
 	{
-		Span = 10.0f;
-		Data.reserve(2000);
+		m_data.clear();
+		m_first = 0;
+		m_next = 0;
 	}
 
-	void Clear()
-	{ Data.clear(); }
-
-	void AddPoint(float x, float y)
+	void Push(const T& value)
 	{
-		Data.push_back(ImVec2(x, y));
-
-		while(!Data.empty())
-		{
-			float tfirst = Data.begin()->x;
-			if(tfirst < (x - Span))
-				Data.erase(Data.begin());
-			else
-				break;
-		}
+		if(m_data.size() < m_capacity)
+			m_data.push_back(value);
+		else
+			m_data[m_next % m_capacity] = value;
+		m_next ++;
+
+		if( (m_next - m_first) > m_capacity)
+			m_first ++;
 	}
+
+	void PopFront()
+	{ m_first ++; }
+
+	bool empty() const
+	{ return m_first == m_next; }
+
+	///@brief Element with absolute sequence number i, which must be in [GetFirst(), GetNext())
+	T& operator[](uint64_t i)
+	{ return m_data[i % m_capacity]; }
+
+	T& front()
+	{ return m_data[m_first % m_capacity]; }
+
+	///@brief Sequence number of the oldest element still present
+	uint64_t GetFirst() const
+	{ return m_first; }
+
+	///@brief Sequence number the next pushed element will get
+	uint64_t GetNext() const
+	{ return m_next; }
+
+protected:
+	std::vector<T> m_data;
+	size_t m_capacity;
+	uint64_t m_first;
+	uint64_t m_next;
+};
+
+/**
+	@brief Realtime trend plot history
+
+	Points are kept in a fixed capacity ring (expiring anything older than the span in O(1)), along with a pyramid
+	of min/max summaries: each bucket at level N covers DECIMATION_FACTOR^N raw points. When plotting, the coarsest
+	level that still has at least one bucket per pixel is used, so the per-frame cost depends on plot width rather
+	than on how much history is stored.
+ */
+class RollingBuffer
+{
+public:
+	RollingBuffer(size_t capacity = 1024*1024);
+
+	void Clear();
+
+	void SetSpan(float span)
+	{ m_span = span; }
+
+	void AddPoint(float x, float y);
+
+	void Plot(const char* label, float xmin, float xmax, float width);
+
+	///@brief Number of raw points currently stored
+	size_t size() const
+	{ return m_points.GetNext() - m_points.GetFirst(); }
+
+protected:
+	void AddBucket(size_t level, uint64_t index);
+	void EmitBucket(size_t level, uint64_t index);
+	uint64_t FindFirstPoint(float x);
+
+	///@brief Number of points (or buckets) summarized by each bucket of the next level up
+	static const size_t DECIMATION_FACTOR = 8;
+
+	///@brief Min/max summary of a range of points
+	struct Bucket
+	{
+		float m_xstart;
+		float m_xend;
+		float m_min;
+		float m_max;
+	};
+
+	///@brief History is discarded once it's this much older than the newest point
+	float m_span;
+
+	///@brief Raw points
+	RollingRing<ImVec2> m_points;
+
+	///@brief Summary buckets. m_levels[0] is level 1 (DECIMATION_FACTOR points per bucket)
+	std::vector< RollingRing<Bucket> > m_levels;
+
+	///@brief Points to actually draw this frame
+	std::vector<ImVec2> m_plotPoints;
 };
 
 #endif
@@ -0,0 +1,118 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SampleQueue
+ */
+#ifndef SampleQueue_h
+#define SampleQueue_h
+
+/**
+	@brief A single instrument reading and the time it was taken
+ */
+struct TimestampedSample
+{
+	double m_time;
+	float m_value;
+};
+
+/**
+	@brief Lock-free single producer / single consumer ring of timestamped readings
+
+	The instrument thread pushes every reading as it comes in and the UI drains everything queued once per frame, so
+	trend plots contain each real reading at the time it was actually measured regardless of frame rate.
+
+	If the consumer falls far enough behind that the ring fills up, new readings are dropped (and counted) rather
+	than blocking the instrument thread.
+ */
+template<size_t N = 1024>
+class SampleQueue
+{
+public:
+	static_assert( (N & (N-1)) == 0, "SampleQueue size must be a power of two");
+
+	SampleQueue()
+	: m_head(0)
+	, m_tail(0)
+	, m_dropped(0)
+	{}
+
+	/**
+		@brief Adds a reading to the queue (producer thread only)
+
+		@return False if the queue was full and the reading was dropped
+	 */
+	bool Push(double t, float value)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if( (head - m_tail.load(std::memory_order_acquire)) >= N)
+		{
+			m_dropped ++;
+			return false;
+		}
+
+		m_samples[head & (N-1)] = { t, value };
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+		@brief Removes the oldest reading from the queue (consumer thread only)
+
+		@return False if the queue was empty
+	 */
+	bool Pop(TimestampedSample& sample)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		if(tail == m_head.load(std::memory_order_acquire))
+			return false;
+
+		sample = m_samples[tail & (N-1)];
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	///@brief Number of readings discarded because the queue was full
+	size_t GetDropCount()
+	{ return m_dropped.load(); }
+
+protected:
+	TimestampedSample m_samples[N];
+
+	//Head and tail live on separate cache lines so producer and consumer don't fight over them
+	alignas(64) std::atomic<size_t> m_head;
+	alignas(64) std::atomic<size_t> m_tail;
+
+	std::atomic<size_t> m_dropped;
+};
+
+#endif
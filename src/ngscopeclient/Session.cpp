@@ -49,6 +49,7 @@ Session::Session(MainWindow* wnd)
 	, m_shuttingDown(false)
 	, m_modifiedSinceLastSave(false)
 {
+	m_waveformThread = make_unique<thread>(WaveformThread, this, &m_shuttingDown);
 }
 
 Session::~Session()
@@ -57,6 +58,8 @@ Session::~Session()
 	m_shuttingDown = true;
 
 	//Block until our processing threads exit
+	m_waveformThread->join();
+	m_waveformThread = nullptr;
 	for(auto& t : m_threads)
 		t->join();
 	m_threads.clear();
@@ -74,7 +77,10 @@ Session::~Session()
 void Session::AddOscilloscope(Oscilloscope* scope)
 {
 	m_modifiedSinceLastSave = true;
-	m_oscilloscopes.push_back(scope);
+	{
+		lock_guard<mutex> lock(m_scopeMutex);
+		m_oscilloscopes.push_back(scope);
+	}
 
 	m_threads.push_back(make_unique<thread>(ScopeThread, scope, &m_shuttingDown));
 
@@ -166,3 +172,106 @@ void Session::RemoveFunctionGenerator(SCPIFunctionGenerator* generator)
 	if(dynamic_cast<Oscilloscope*>(generator) == nullptr)
 		delete generator;
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Waveform processing
+
+/**
+	@brief Gets a copy of the list of scopes that are currently online
+ */
+vector<Oscilloscope*> Session::GetOnlineScopes()
+{
+	lock_guard<mutex> lock(m_scopeMutex);
+
+	vector<Oscilloscope*> scopes;
+	for(auto scope : m_oscilloscopes)
+	{
+		if(!scope->IsOffline())
+			scopes.push_back(scope);
+	}
+	return scopes;
+}
+
+/**
+	@brief Returns true if every online scope has a waveform ready to process
+
+	Waiting for all of them keeps the waveforms in a snapshot from the same trigger event in multi-scope setups.
+ */
+bool Session::CheckForPendingWaveforms()
+{
+	auto scopes = GetOnlineScopes();
+	if(scopes.empty())
+		return false;
+
+	for(auto scope : scopes)
+	{
+		if(scope->GetPendingWaveformCount() == 0)
+			return false;
+	}
+	return true;
+}
+
+/**
+	@brief Pulls the next pending waveform from each scope into its channels
+ */
+void Session::DownloadWaveforms()
+{
+	lock_guard<recursive_mutex> lock(m_waveformDataMutex);
+	for(auto scope : GetOnlineScopes())
+		scope->PopPendingWaveform();
+}
+
+/**
+	@brief Runs the filter graph on the current waveforms
+ */
+void Session::RefreshAllFilters()
+{
+	lock_guard<recursive_mutex> lock(m_waveformDataMutex);
+	m_graphExecutor.RunBlocking(Filter::GetAllInstances());
+}
+
+/**
+	@brief Moves the current waveforms into a snapshot and hands it off to the GUI thread
+
+	Instrument channel data is handed over as-is and detached from the channel, since the next acquisition will
+	replace it anyway. Filter outputs are copied instead: filters reuse their output buffers, and some (eyes,
+	averages, etc) accumulate state in them from one waveform to the next.
+ */
+void Session::PublishWaveforms()
+{
+	lock_guard<recursive_mutex> lock(m_waveformDataMutex);
+	auto snapshot = m_snapshots.GetWriteBuffer();
+
+	for(auto scope : GetOnlineScopes())
+	{
+		for(size_t i=0; i<scope->GetChannelCount(); i++)
+		{
+			auto chan = scope->GetChannel(i);
+			for(size_t j=0; j<chan->GetStreamCount(); j++)
+			{
+				auto data = chan->GetData(j);
+				if(data == nullptr)
+					continue;
+
+				snapshot->m_waveforms[StreamDescriptor(chan, j)] = data;
+				chan->Detach(j);
+			}
+		}
+	}
+
+	for(auto f : Filter::GetAllInstances())
+	{
+		for(size_t i=0; i<f->GetStreamCount(); i++)
+		{
+			auto data = f->GetData(i);
+			if(data == nullptr)
+				continue;
+
+			auto copy = WaveformSnapshot::CopyWaveform(data);
+			if(copy)
+				snapshot->m_waveforms[StreamDescriptor(f, i)] = copy;
+		}
+	}
+
+	m_snapshots.Publish();
+}
@@ -35,6 +35,8 @@
 #ifndef Session_h
 #define Session_h
 
+#include "WaveformSnapshot.h"
+
 class MainWindow;
 
 /**
@@ -132,7 +134,31 @@ public:
 	const std::vector<Oscilloscope*>& GetScopes()
 	{ return m_oscilloscopes; }
 
+	/**
+		@brief Get the most recent set of processed waveforms
+
+		GUI thread only. The snapshot stays valid, and unchanged, until the next call.
+	 */
+	WaveformSnapshot* GetLatestWaveforms()
+	{ return m_snapshots.GetReadBuffer(); }
+
+	/**
+		@brief Lock for channel waveform data and the filter graph
+
+		Held by the waveform thread from download through publishing. Anything else that touches channel data or
+		creates, deletes or reconnects filters must hold it too.
+	 */
+	std::recursive_mutex& GetWaveformDataMutex()
+	{ return m_waveformDataMutex; }
+
+	//Waveform processing (called from WaveformThread)
+	bool CheckForPendingWaveforms();
+	void DownloadWaveforms();
+	void RefreshAllFilters();
+	void PublishWaveforms();
+
 protected:
+	std::vector<Oscilloscope*> GetOnlineScopes();
 
 	///@brief Top level UI window
 	MainWindow* m_mainWindow;
@@ -146,6 +172,9 @@ protected:
 	///@brief Oscilloscopes we are currently connected to
 	std::vector<Oscilloscope*> m_oscilloscopes;
 
+	///@brief Mutex protecting m_oscilloscopes against concurrent modification by the GUI thread
+	std::mutex m_scopeMutex;
+
 	///@brief Power supplies we are currently connected to
 	std::map<PowerSupply*, std::unique_ptr<PowerSupplyConnectionState> > m_psus;
 
@@ -157,6 +186,18 @@ protected:
 
 	///@brief Processing threads for polling and processing scope waveforms
 	std::vector< std::unique_ptr<std::thread> > m_threads;
+
+	///@brief Thread for downloading waveforms and running the filter graph
+	std::unique_ptr<std::thread> m_waveformThread;
+
+	///@brief Filter graph evaluation
+	FilterGraphExecutor m_graphExecutor;
+
+	///@brief Lock for channel waveform data and the filter graph (see GetWaveformDataMutex())
+	std::recursive_mutex m_waveformDataMutex;
+
+	///@brief Completed waveform sets, handed off to the GUI
+	WaveformSnapshotManager m_snapshots;
 };
 
 #endif
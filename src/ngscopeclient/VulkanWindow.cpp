@@ -40,6 +40,11 @@ using namespace std;
 
 #define IMAGE_COUNT 2
 
+///@brief Frames to keep drawing after the last input event, so ImGui layout can settle
+#define SETTLE_FRAMES 3
+
+atomic<bool> VulkanWindow::m_redrawRequested(true);
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -58,6 +63,10 @@ VulkanWindow::VulkanWindow(const string& title, vk::raii::Queue& queue)
 	, m_windowedY(0)
 	, m_windowedWidth(0)
 	, m_windowedHeight(0)
+	, m_maxFps(60)
+	, m_lastFrameTime(0)
+	, m_nextAnimationFrame(DBL_MAX)
+	, m_settleFrames(SETTLE_FRAMES)
 {
 	//Don't configure Vulkan or center the mouse
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -271,12 +280,40 @@ void VulkanWindow::UpdateFramebuffer()
 	m_resizeEventPending = false;
 }
 
+/**
+	@brief Renders a frame, recreating the swapchain and trying again as many times as needed if the window was resized
+ */
 void VulkanWindow::Render()
 {
-	//If we're re-rendering after the window size changed, fix up the framebuffer before we worry about anything else
-	if(m_resizeEventPending)
-		UpdateFramebuffer();
+	m_lastFrameTime = GetTime();
+	if(m_settleFrames > 0)
+		m_settleFrames --;
+
+	//Anything animating will ask for another frame while rendering this one
+	m_nextAnimationFrame = DBL_MAX;
+
+	while(true)
+	{
+		//If we're re-rendering after the window size changed, fix up the framebuffer before we worry about anything else
+		if(m_resizeEventPending)
+			UpdateFramebuffer();
+
+		if(RenderFrame() && !m_resizeEventPending)
+			break;
+	}
+
+	//Keep the text cursor blinking while editing a field
+	if(ImGui::GetIO().WantTextInput)
+		RequestAnimationFrame(0.25);
+}
 
+/**
+	@brief Renders a single frame
+
+	@return False if the swapchain is out of date and the frame has to be redrawn after resizing
+ */
+bool VulkanWindow::RenderFrame()
+{
 	//Start frame
 	ImGui_ImplVulkan_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
@@ -301,8 +338,7 @@ void VulkanWindow::Render()
 			m_resizeEventPending = true;
 			ImGui::UpdatePlatformWindows();
 			ImGui::RenderPlatformWindowsDefault();
-			Render();
-			return;
+			return false;
 		}
 
 		//Make sure the old frame has completed
@@ -355,22 +391,88 @@ void VulkanWindow::Render()
 			if(vk::Result::eSuboptimalKHR == m_renderQueue.presentKHR(presentInfo))
 			{
 				m_resizeEventPending = true;
-				Render();
-				return;
+				return false;
 			}
 		}
 		catch(const vk::OutOfDateKHRError& err)
 		{
 			m_resizeEventPending = true;
-			Render();
-			return;
+			return false;
 		}
 		m_semaphoreIndex = (m_semaphoreIndex + 1) % m_backBuffers.size();
 	}
 
-	//Handle resize events
-	if(m_resizeEventPending)
-		Render();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Frame scheduling
+
+/**
+	@brief Requests that the window be redrawn as soon as the frame rate cap allows
+
+	Safe to call from any thread (e.g. when new data arrives from an instrument).
+ */
+void VulkanWindow::RequestRedraw()
+{
+	m_redrawRequested = true;
+	glfwPostEmptyEvent();
+}
+
+/**
+	@brief Requests another frame no later than the given delay from now
+
+	Called from within RenderUI() by anything that animates (blinking indicators, etc). Only applies to the next
+	frame: keep calling it every frame for as long as the animation runs.
+ */
+void VulkanWindow::RequestAnimationFrame(double delay)
+{
+	m_nextAnimationFrame = min(m_nextAnimationFrame, GetTime() + delay);
+}
+
+/**
+	@brief Blocks until it's time to draw the next frame, processing window events as they come in
+
+	Frames are drawn in response to input, redraw requests from other threads, and animations, and never faster than
+	the frame rate cap. If nothing is happening, we sleep.
+ */
+void VulkanWindow::WaitForNextFrame()
+{
+	double frameInterval = 1.0 / m_maxFps;
+	double now = GetTime();
+	double earliest = m_lastFrameTime + frameInterval;
+
+	//If we don't have anything to draw yet, sleep until an event comes in or an animation frame is due.
+	//There's no periodic redraw: everything that changes what's on screen either is an input event or calls
+	//RequestRedraw() / RequestAnimationFrame(), so an idle window doesn't draw at all.
+	bool pending = (m_settleFrames > 0) || m_redrawRequested.exchange(false);
+	if(!pending)
+	{
+		double timeout = m_nextAnimationFrame - now;
+		bool wokeEarly = true;
+		if(m_nextAnimationFrame == DBL_MAX)
+			glfwWaitEvents();
+		else if(timeout > 0)
+		{
+			glfwWaitEventsTimeout(timeout);
+			wokeEarly = (GetTime() - now) < timeout;
+		}
+		else
+			wokeEarly = false;
+
+		//Woke up early without a redraw request? Must have been an input event, so let the layout settle.
+		//Redraw requests from other threads only need the one frame.
+		bool redraw = m_redrawRequested.exchange(false);
+		if(wokeEarly && !redraw)
+			m_settleFrames = SETTLE_FRAMES;
+		now = GetTime();
+	}
+
+	//Respect the frame rate cap
+	if(now < earliest)
+		this_thread::sleep_for(chrono::microseconds(static_cast<int64_t>((earliest - now) * 1e6)));
+
+	glfwPollEvents();
 }
 
 void VulkanWindow::RenderUI()
@@ -48,8 +48,16 @@ public:
 	{ return m_window; }
 
 	virtual void Render();
+	void WaitForNextFrame();
+
+	static void RequestRedraw();
+	void RequestAnimationFrame(double delay);
+
+	void SetMaxFps(int fps)
+	{ m_maxFps = std::max(fps, 1); }
 
 protected:
+	bool RenderFrame();
 	void UpdateFramebuffer();
 	void SetFullscreen(bool fullscreen);
 
@@ -130,6 +138,21 @@ protected:
 
 	///@brief implot context
 	ImPlotContext* m_plotContext;
+
+	///@brief Set from any thread when something changed that needs to be drawn
+	static std::atomic<bool> m_redrawRequested;
+
+	///@brief Frame rate cap
+	int m_maxFps;
+
+	///@brief Time the last frame started rendering
+	double m_lastFrameTime;
+
+	///@brief Time at which something on screen next needs to be animated (or infinity if nothing is animating)
+	double m_nextAnimationFrame;
+
+	///@brief Number of additional frames to draw after an input event (ImGui layout lags input by a frame or two)
+	int m_settleFrames;
 };
 
 #endif
@@ -34,6 +34,7 @@
  */
 #include "ngscopeclient.h"
 #include "WaveformArea.h"
+#include "WaveformSnapshot.h"
 
 using namespace std;
 
@@ -41,6 +42,9 @@ using namespace std;
 // Construction / destruction
 
 WaveformArea::WaveformArea()
+	: m_dirty(true)
+	, m_lastSnapshotSequence(0)
+	, m_lastPlotSize(0, 0)
 {
 	m_displayedChannels.push_back(make_shared<DisplayedChannel>("ohai"));
 	m_displayedChannels.push_back(make_shared<DisplayedChannel>("asdf"));
@@ -53,7 +57,16 @@ WaveformArea::~WaveformArea()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Rendering
 
-void WaveformArea::Render(int iArea, int numAreas, ImVec2 clientArea)
+/**
+	@brief Draws the area
+
+	@param iArea		Index of this area within its group
+	@param numAreas		Number of areas in the group
+	@param clientArea	Size of the group's client area
+	@param snapshot		Waveforms to display. Never read waveform data from the channels themselves: the waveform
+						thread replaces it at any time.
+ */
+void WaveformArea::Render(int iArea, int numAreas, ImVec2 clientArea, WaveformSnapshot* snapshot)
 {
 	auto height = (clientArea.y - ImGui::GetFrameHeightWithSpacing()) / numAreas;
 	if(ImGui::BeginChild(ImGui::GetID(this), ImVec2(clientArea.x, height)))
@@ -61,6 +74,24 @@ void WaveformArea::Render(int iArea, int numAreas, ImVec2 clientArea)
 		auto csize = ImGui::GetContentRegionAvail();
 		auto start = ImGui::GetWindowContentRegionMin();
 
+		//The waveform image only needs to be redrawn if the data or plot size changed.
+		//Everything else (overlays, controls) is cheap and drawn every frame.
+		if(snapshot->m_sequence != m_lastSnapshotSequence)
+		{
+			m_lastSnapshotSequence = snapshot->m_sequence;
+			m_dirty = true;
+		}
+		if( (csize.x != m_lastPlotSize.x) || (csize.y != m_lastPlotSize.y) )
+		{
+			m_lastPlotSize = csize;
+			m_dirty = true;
+		}
+		if(m_dirty)
+		{
+			//TODO: rasterize snapshot->GetData() for each displayed channel into the texture here
+			m_dirty = false;
+		}
+
 		//Draw texture for the actual waveform
 		//(todo: repeat for each channel)
 		ImTextureID my_tex_id = ImGui::GetIO().Fonts->TexID;
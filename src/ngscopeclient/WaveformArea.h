@@ -35,6 +35,8 @@
 #ifndef WaveformArea_h
 #define WaveformArea_h
 
+class WaveformSnapshot;
+
 /**
 	@brief Placeholder for a single channel being displayed within a WaveformArea
  */
@@ -63,7 +65,7 @@ public:
 	WaveformArea();
 	virtual ~WaveformArea();
 
-	void Render(int iArea, int numAreas, ImVec2 clientArea);
+	void Render(int iArea, int numAreas, ImVec2 clientArea, WaveformSnapshot* snapshot);
 
 protected:
 	void DraggableButton(std::shared_ptr<DisplayedChannel> chan);
@@ -76,6 +78,15 @@ protected:
 		TODO: make this a FlowGraphNode and just hook up inputs
 	 */
 	std::vector<std::shared_ptr<DisplayedChannel>> m_displayedChannels;
+
+	///@brief True if the waveform image is out of date and has to be redrawn
+	bool m_dirty;
+
+	///@brief Sequence number of the snapshot the waveform image was last drawn from
+	uint64_t m_lastSnapshotSequence;
+
+	///@brief Size of the plot the last time the waveform image was drawn
+	ImVec2 m_lastPlotSize;
 };
 
 #endif
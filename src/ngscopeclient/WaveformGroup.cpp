@@ -54,7 +54,7 @@ WaveformGroup::~WaveformGroup()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Rendering
 
-void WaveformGroup::Render()
+void WaveformGroup::Render(WaveformSnapshot* snapshot)
 {
 	bool open = true;
 	ImGui::SetNextWindowSize(ImVec2(320, 240), ImGuiCond_Appearing);
@@ -67,7 +67,7 @@ void WaveformGroup::Render()
 	ImVec2 clientArea = ImGui::GetContentRegionAvail();
 
 	for(size_t i=0; i<m_areas.size(); i++)
-		m_areas[i]->Render(i, m_areas.size(), clientArea);
+		m_areas[i]->Render(i, m_areas.size(), clientArea, snapshot);
 
 	ImGui::End();
 }
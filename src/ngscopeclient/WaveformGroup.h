@@ -46,7 +46,7 @@ public:
 	WaveformGroup(const std::string& title, size_t numAreas);
 	virtual ~WaveformGroup();
 
-	void Render();
+	void Render(WaveformSnapshot* snapshot);
 
 	const std::string& GetTitle()
 	{ return m_title; }
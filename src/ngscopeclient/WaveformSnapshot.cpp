@@ -0,0 +1,181 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformSnapshot and WaveformSnapshotManager
+ */
+#include "ngscopeclient.h"
+#include "WaveformSnapshot.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// WaveformSnapshot
+
+WaveformSnapshot::WaveformSnapshot()
+	: m_sequence(0)
+{
+}
+
+WaveformSnapshot::~WaveformSnapshot()
+{
+	Clear();
+}
+
+/**
+	@brief Frees all waveforms in the snapshot
+ */
+void WaveformSnapshot::Clear()
+{
+	for(auto it : m_waveforms)
+		delete it.second;
+	m_waveforms.clear();
+}
+
+/**
+	@brief Copies the samples of a single buffer
+ */
+template<class T>
+static void CopySamples(AcceleratorBuffer<T>& dst, AcceleratorBuffer<T>& src)
+{
+	src.PrepareForCpuAccess();
+	dst.resize(src.size());
+	dst.PrepareForCpuAccess();
+	if(!src.empty())
+		memcpy(dst.GetCpuPointer(), src.GetCpuPointer(), src.size() * sizeof(T));
+	dst.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Copies timestamps and other metadata shared by all waveform types
+ */
+static void CopyMetadata(WaveformBase* dst, WaveformBase* src)
+{
+	dst->m_timescale = src->m_timescale;
+	dst->m_startTimestamp = src->m_startTimestamp;
+	dst->m_startFemtoseconds = src->m_startFemtoseconds;
+	dst->m_triggerPhase = src->m_triggerPhase;
+	dst->m_flags = src->m_flags;
+}
+
+/**
+	@brief Makes a deep copy of a waveform
+
+	Only analog and digital waveforms are supported for now, returns nullptr for anything else.
+ */
+WaveformBase* WaveformSnapshot::CopyWaveform(WaveformBase* data)
+{
+	if(auto ua = dynamic_cast<UniformAnalogWaveform*>(data))
+	{
+		auto ret = new UniformAnalogWaveform;
+		CopyMetadata(ret, ua);
+		CopySamples(ret->m_samples, ua->m_samples);
+		return ret;
+	}
+	if(auto ud = dynamic_cast<UniformDigitalWaveform*>(data))
+	{
+		auto ret = new UniformDigitalWaveform;
+		CopyMetadata(ret, ud);
+		CopySamples(ret->m_samples, ud->m_samples);
+		return ret;
+	}
+	if(auto sa = dynamic_cast<SparseAnalogWaveform*>(data))
+	{
+		auto ret = new SparseAnalogWaveform;
+		CopyMetadata(ret, sa);
+		CopySamples(ret->m_samples, sa->m_samples);
+		CopySamples(ret->m_offsets, sa->m_offsets);
+		CopySamples(ret->m_durations, sa->m_durations);
+		return ret;
+	}
+	if(auto sd = dynamic_cast<SparseDigitalWaveform*>(data))
+	{
+		auto ret = new SparseDigitalWaveform;
+		CopyMetadata(ret, sd);
+		CopySamples(ret->m_samples, sd->m_samples);
+		CopySamples(ret->m_offsets, sd->m_offsets);
+		CopySamples(ret->m_durations, sd->m_durations);
+		return ret;
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// WaveformSnapshotManager
+
+WaveformSnapshotManager::WaveformSnapshotManager()
+	: m_middle(1)
+	, m_back(0)
+	, m_front(2)
+	, m_sequence(0)
+{
+}
+
+/**
+	@brief Gets an empty snapshot to fill
+
+	Anything left in the buffer from a previous (never displayed, or no longer displayed) snapshot is freed.
+ */
+WaveformSnapshot* WaveformSnapshotManager::GetWriteBuffer()
+{
+	auto buf = &m_buffers[m_back];
+	buf->Clear();
+	return buf;
+}
+
+/**
+	@brief Makes the snapshot returned by GetWriteBuffer() available to the reader
+ */
+void WaveformSnapshotManager::Publish()
+{
+	m_buffers[m_back].m_sequence = ++m_sequence;
+
+	auto prev = m_middle.exchange(m_back | FRESH, memory_order_acq_rel);
+	m_back = prev & ~FRESH;
+}
+
+/**
+	@brief Gets the newest published snapshot
+
+	The returned snapshot stays valid (and is not modified) until the next call to GetReadBuffer(). Its sequence
+	number is zero if nothing has been published yet.
+ */
+WaveformSnapshot* WaveformSnapshotManager::GetReadBuffer()
+{
+	if(m_middle.load(memory_order_acquire) & FRESH)
+	{
+		auto prev = m_middle.exchange(m_front, memory_order_acq_rel);
+		m_front = prev & ~FRESH;
+	}
+	return &m_buffers[m_front];
+}
@@ -0,0 +1,111 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformSnapshot and WaveformSnapshotManager
+ */
+#ifndef WaveformSnapshot_h
+#define WaveformSnapshot_h
+
+/**
+	@brief A consistent set of waveforms (instrument channels plus filter outputs) from a single acquisition
+
+	The snapshot owns all of its waveforms.
+ */
+class WaveformSnapshot
+{
+public:
+	WaveformSnapshot();
+	~WaveformSnapshot();
+
+	void Clear();
+
+	/**
+		@brief Gets the waveform for a stream, or nullptr if it had no data in this acquisition
+	 */
+	WaveformBase* GetData(StreamDescriptor stream)
+	{
+		auto it = m_waveforms.find(stream);
+		if(it == m_waveforms.end())
+			return nullptr;
+		return it->second;
+	}
+
+	static WaveformBase* CopyWaveform(WaveformBase* data);
+
+	///@brief Waveforms in this snapshot
+	std::map<StreamDescriptor, WaveformBase*> m_waveforms;
+
+	///@brief Increments by one for each snapshot published (0 = nothing published yet)
+	uint64_t m_sequence;
+};
+
+/**
+	@brief Lock-free triple buffer of WaveformSnapshot's between the waveform thread and the GUI thread
+
+	The writer fills the back buffer and publishes it by atomically swapping it with the middle buffer. The reader
+	picks up the newest published snapshot by swapping the middle buffer with its front buffer. Neither side ever
+	waits for the other: the GUI can hold on to its snapshot for a whole frame while filters run on the next one, and
+	if the writer gets ahead, stale unread snapshots are simply recycled.
+ */
+class WaveformSnapshotManager
+{
+public:
+	WaveformSnapshotManager();
+
+	//Writer side (waveform thread only)
+	WaveformSnapshot* GetWriteBuffer();
+	void Publish();
+
+	//Reader side (GUI thread only)
+	WaveformSnapshot* GetReadBuffer();
+
+protected:
+	WaveformSnapshot m_buffers[3];
+
+	///@brief Flag set in m_middle when it holds a snapshot the reader hasn't picked up yet
+	static const uint8_t FRESH = 0x4;
+
+	///@brief Index of the middle buffer, plus FRESH flag
+	std::atomic<uint8_t> m_middle;
+
+	///@brief Index of the buffer owned by the writer
+	uint8_t m_back;
+
+	///@brief Index of the buffer owned by the reader
+	uint8_t m_front;
+
+	///@brief Sequence number of the last published snapshot
+	uint64_t m_sequence;
+};
+
+#endif
@@ -146,11 +146,8 @@ int main(int argc, char* argv[])
 		//Main event loop
 		while(!glfwWindowShouldClose(g_mainWindow->GetWindow()))
 		{
-			//poll and return immediately
-			glfwPollEvents();
-
-			//block until we have something to do, then process events
-			//glfwWaitEvents();
+			//Block until there's input, new data, or an animation to draw, then process events
+			g_mainWindow->WaitForNextFrame();
 
 			//Draw the main window
 			g_mainWindow->Render();
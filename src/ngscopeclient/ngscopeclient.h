@@ -45,6 +45,8 @@
 
 #include <atomic>
 
+#include "PollScheduler.h"
+#include "SampleQueue.h"
 #include "PowerSupplyState.h"
 #include "MultimeterState.h"
 
@@ -76,7 +78,10 @@ public:
 	std::shared_ptr<MultimeterState> state;
 };
 
+class Session;
+
 void ScopeThread(Oscilloscope* scope, std::atomic<bool>* shuttingDown);
+void WaveformThread(Session* session, std::atomic<bool>* shuttingDown);
 void PowerSupplyThread(PowerSupplyThreadArgs args);
 void MultimeterThread(MultimeterThreadArgs args);
 
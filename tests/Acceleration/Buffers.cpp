@@ -155,6 +155,13 @@ TEST_CASE("Buffers_CpuOnly")
 
 TEST_CASE("Buffers_CpuGpu")
 {
+	//Nothing to test without a GPU
+	if(g_cpuOnly)
+	{
+		LogNotice("Skipping Buffers_CpuGpu in CPU-only mode\n");
+		return;
+	}
+
 	AcceleratorBuffer<int32_t> buf;
 
 	//CPU-side pinned memory plus GPU-side dedicated buffer,
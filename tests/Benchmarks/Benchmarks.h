@@ -0,0 +1,135 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declarations for the filter/primitive benchmark suite
+ */
+
+#ifndef Benchmarks_h
+#define Benchmarks_h
+
+#include "../Filters/Filters.h"
+#include <map>
+#include <set>
+
+/**
+	@brief An instruction set / execution path a kernel can be benchmarked on
+ */
+enum BenchmarkIsa
+{
+	ISA_GENERIC,
+	ISA_AVX2,
+	ISA_FMA,
+	ISA_AVX512F,
+	ISA_GPU,
+
+	ISA_COUNT
+};
+
+void DetectIsas();
+const char* GetIsaName(BenchmarkIsa isa);
+bool IsIsaAvailable(BenchmarkIsa isa);
+void SelectIsa(BenchmarkIsa isa);
+void RestoreIsa();
+
+/**
+	@brief A single kernel that can be timed at arbitrary depth on one or more ISA paths
+ */
+class Benchmark
+{
+public:
+	Benchmark(const std::string& name)
+	: m_name(name)
+	{}
+
+	virtual ~Benchmark()
+	{}
+
+	const std::string& GetName()
+	{ return m_name; }
+
+	///@brief Returns true if this kernel has an implementation for the given path
+	virtual bool SupportsIsa(BenchmarkIsa isa) =0;
+
+	///@brief Allocates and fills input data for the given depth (not timed)
+	virtual void Setup(size_t depth) =0;
+
+	///@brief Runs the kernel once on the given path (timed)
+	virtual void Run(BenchmarkIsa isa, vk::raii::CommandBuffer& cmdbuf, vk::raii::Queue& queue) =0;
+
+	///@brief Frees anything allocated by Setup()
+	virtual void Teardown()
+	{}
+
+protected:
+	std::string m_name;
+};
+
+/**
+	@brief Summary statistics for one (kernel, ISA, depth) combination
+ */
+class BenchmarkResult
+{
+public:
+	std::string m_kernel;
+	std::string m_isa;
+	size_t m_depth;
+	size_t m_iterations;
+
+	//All times in seconds
+	double m_min;
+	double m_max;
+	double m_mean;
+	double m_median;
+	double m_stdev;
+	double m_p90;
+
+	///@brief Samples per second, based on the median
+	double m_throughput;
+
+	std::string GetKey() const;
+};
+
+void SummarizeTimes(std::vector<double>& times, BenchmarkResult& result);
+
+void WriteJsonResults(const std::string& path, const std::vector<BenchmarkResult>& results);
+void WriteCsvResults(const std::string& path, const std::vector<BenchmarkResult>& results);
+
+bool LoadBaseline(const std::string& path, std::map<std::string, BenchmarkResult>& baseline);
+size_t CompareToBaseline(
+	const std::vector<BenchmarkResult>& results,
+	const std::map<std::string, BenchmarkResult>& baseline,
+	double threshold);
+
+void CreateFilterBenchmarks(std::vector<Benchmark*>& benchmarks);
+void CreatePrimitiveBenchmarks(std::vector<Benchmark*>& benchmarks);
+
+#endif
@@ -0,0 +1,158 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Benchmarks for filter blocks
+ */
+
+#include "Benchmarks.h"
+
+using namespace std;
+
+/**
+	@brief Base class for benchmarking a filter fed by random uniform waveforms on the mock scope channels
+ */
+class FilterBenchmark : public Benchmark
+{
+public:
+	FilterBenchmark(const string& name, const string& protocol, size_t ninputs, int64_t timescale)
+	: Benchmark(name)
+	, m_inputs(ninputs)
+	{
+		m_filter = Filter::CreateFilter(protocol, "#ffffff");
+		m_filter->AddRef();
+
+		for(size_t i=0; i<ninputs; i++)
+		{
+			m_inputs[i].m_timescale = timescale;
+			m_inputs[i].m_triggerPhase = 0;
+			g_scope->GetChannel(i)->SetData(&m_inputs[i], 0);
+			m_filter->SetInput(i, StreamDescriptor(g_scope->GetChannel(i), 0));
+		}
+	}
+
+	virtual ~FilterBenchmark()
+	{
+		for(size_t i=0; i<m_inputs.size(); i++)
+			g_scope->GetChannel(i)->Detach(0);
+		m_filter->Release();
+	}
+
+	virtual bool SupportsIsa(BenchmarkIsa isa)
+	{
+		//Most filters only have a single AVX path, override as needed
+		return (isa == ISA_GENERIC) || (isa == ISA_AVX2) || (isa == ISA_GPU);
+	}
+
+	virtual void Setup(size_t depth)
+	{
+		for(auto& w : m_inputs)
+		{
+			FillRandomWaveform(&w, depth);
+
+			//Make sure data is in the right spot (don't count this towards execution time)
+			if(!g_cpuOnly)
+				w.PrepareForGpuAccess();
+			w.PrepareForCpuAccess();
+		}
+	}
+
+	virtual void Run(BenchmarkIsa /*isa*/, vk::raii::CommandBuffer& cmdbuf, vk::raii::Queue& queue)
+	{
+		m_filter->Refresh(cmdbuf, queue);
+	}
+
+	virtual void Teardown()
+	{
+		for(auto& w : m_inputs)
+		{
+			w.PrepareForCpuAccess();
+			w.Resize(0);
+		}
+	}
+
+protected:
+	Filter* m_filter;
+	vector<UniformAnalogWaveform> m_inputs;
+};
+
+class FIRBenchmark : public FilterBenchmark
+{
+public:
+	FIRBenchmark()
+	: FilterBenchmark("Filter_FIR", "FIR Filter", 1, 100000)
+	{
+		auto fir = dynamic_cast<FIRFilter*>(m_filter);
+		fir->SetFilterType(static_cast<FIRFilter::FilterType>(0));
+		fir->SetFreqLow(0);
+		fir->SetFreqHigh(500e6);
+	}
+
+	virtual bool SupportsIsa(BenchmarkIsa isa)
+	{ return (isa != ISA_FMA); }
+};
+
+class FFTBenchmark : public FilterBenchmark
+{
+public:
+	FFTBenchmark()
+	: FilterBenchmark("Filter_FFT", "FFT", 1, 10000)
+	{
+		dynamic_cast<FFTFilter*>(m_filter)->SetWindowFunction(static_cast<FFTFilter::WindowFunction>(0));
+	}
+};
+
+class SubtractBenchmark : public FilterBenchmark
+{
+public:
+	SubtractBenchmark()
+	: FilterBenchmark("Filter_Subtract", "Subtract", 2, 100000)
+	{}
+};
+
+class UpsampleBenchmark : public FilterBenchmark
+{
+public:
+	UpsampleBenchmark()
+	: FilterBenchmark("Filter_Upsample", "Upsample", 1, 100000)
+	{}
+
+	virtual bool SupportsIsa(BenchmarkIsa isa)
+	{ return (isa == ISA_GENERIC) || (isa == ISA_GPU); }
+};
+
+void CreateFilterBenchmarks(vector<Benchmark*>& benchmarks)
+{
+	benchmarks.push_back(new FFTBenchmark);
+	benchmarks.push_back(new FIRBenchmark);
+	benchmarks.push_back(new SubtractBenchmark);
+	benchmarks.push_back(new UpsampleBenchmark);
+}
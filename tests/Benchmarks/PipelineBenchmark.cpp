@@ -0,0 +1,533 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief End-to-end benchmark of glscopeclient's waveform processing pipeline
+
+	Feeds synthetic waveforms from a mock instrument through the stages glscopeclient runs for every trigger, without
+	any GUI, and reports sustained throughput, per-stage latency and peak memory usage. Download, filter graph refresh
+	(including statistics) and CPU-side geometry prep are the client's own code, from the glscopeclient-pipeline
+	library. Acquisition is a stand-in for ScopeThread and a real driver (sample conversion into a new waveform).
+ */
+
+#include "../Filters/Filters.h"
+#include "../../src/glscopeclient/FilterGraphProfiler.h"
+#include "../../src/glscopeclient/StatisticsEngine.h"
+#include "../../src/glscopeclient/WaveformGeometry.h"
+#include "../../src/glscopeclient/WaveformPipeline.h"
+#include <sys/resource.h>
+
+using namespace std;
+
+minstd_rand g_rng;
+MockOscilloscope* g_scope;
+bool g_cpuOnly = false;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Synthetic instrument
+
+/**
+	@brief Mock instrument which generates a new set of waveforms on every AcquireData() call
+
+	Samples are generated once as raw 16-bit ADC codes and converted to volts on every acquisition, so the per-trigger
+	cost is similar to a real driver (allocation plus sample conversion) rather than to the random number generator.
+ */
+class SyntheticOscilloscope : public MockOscilloscope
+{
+public:
+	SyntheticOscilloscope(size_t nchans, size_t depth, int64_t timescale)
+	: MockOscilloscope("Synthetic Scope", "Antikernel Labs", "12345", "null", "mock", "")
+	, m_depth(depth)
+	, m_timescale(timescale)
+	{
+		auto ndist = normal_distribution<float>(0, 200);
+		for(size_t i=0; i<nchans; i++)
+		{
+			AddChannel(new OscilloscopeChannel(
+				this,
+				string("CH") + to_string(i+1),
+				"#ffffffff",
+				Unit(Unit::UNIT_FS),
+				Unit(Unit::UNIT_VOLTS)));
+
+			//Noisy sine wave, different frequency on each channel
+			vector<int16_t> raw(depth);
+			double period = 100 + 37*i;
+			for(size_t j=0; j<depth; j++)
+				raw[j] = 16000 * sin(2 * M_PI * j / period) + ndist(g_rng);
+			m_raw.push_back(raw);
+		}
+	}
+
+	virtual bool AcquireData()
+	{
+		SequenceSet s;
+		double now = GetTime();
+		for(size_t i=0; i<m_channels.size(); i++)
+		{
+			auto cap = new UniformAnalogWaveform;
+			cap->m_timescale = m_timescale;
+			cap->m_triggerPhase = 0;
+			cap->m_startTimestamp = floor(now);
+			cap->m_startFemtoseconds = (now - floor(now)) * FS_PER_SECOND;
+			cap->PrepareForCpuAccess();
+			cap->Resize(m_depth);
+			Convert16BitSamples(cap->m_samples.GetCpuPointer(), &m_raw[i][0], 1e-4f, 0, m_depth);
+			cap->MarkModifiedFromCpu();
+			s[StreamDescriptor(m_channels[i], 0)] = cap;
+		}
+
+		lock_guard<mutex> lock(m_pendingWaveformsMutex);
+		m_pendingWaveforms.push_back(s);
+		m_triggerTimes.push_back(now);
+		return true;
+	}
+
+	size_t GetPendingCount()
+	{
+		lock_guard<mutex> lock(m_pendingWaveformsMutex);
+		return m_pendingWaveforms.size();
+	}
+
+	///@brief Returns the time at which the oldest pending waveform was acquired
+	double PopTriggerTime()
+	{
+		lock_guard<mutex> lock(m_pendingWaveformsMutex);
+		double t = m_triggerTimes.front();
+		m_triggerTimes.pop_front();
+		return t;
+	}
+
+protected:
+	size_t m_depth;
+	int64_t m_timescale;
+	vector< vector<int16_t> > m_raw;
+	deque<double> m_triggerTimes;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Statistics
+
+/**
+	@brief Latency samples for one pipeline stage
+ */
+class StageTimes
+{
+public:
+	StageTimes(const string& name)
+	: m_name(name)
+	{}
+
+	string m_name;
+	vector<double> m_times;
+
+	double GetPercentile(double p)
+	{
+		if(m_times.empty())
+			return 0;
+		size_t i = min(m_times.size() - 1, static_cast<size_t>(p * m_times.size()));
+		return m_times[i];
+	}
+};
+
+size_t GetPeakRSS()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	//ru_maxrss is in kB on Linux
+	return usage.ru_maxrss * 1024;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pipeline stages
+
+/**
+	@brief Per-stream buffers standing in for the GL buffers WaveformArea maps during geometry prep
+ */
+class GeometryBuffers
+{
+public:
+	GeometryBuffers()
+	: m_config(8)
+	{}
+
+	vector<float> m_y;
+	vector<int64_t> m_x;
+	unique_ptr<bool[]> m_digitalY;
+	vector<uint32_t> m_index;
+
+	///@brief Config block, addressed as 32 and 64 bit integers and floats like the mapped SSBO
+	vector<int64_t> m_config;
+};
+
+/**
+	@brief Runs WaveformArea's geometry prep for one stream, as if the full waveform were on screen
+
+	@return True if the geometry is good to render
+ */
+bool PrepareGeometry(StreamDescriptor stream, GeometryBuffers& buf, int width, int height, float alpha)
+{
+	auto pdat = stream.GetData();
+	if( (pdat == nullptr) || pdat->empty() )
+		return false;
+
+	//Size the buffers the way WaveformRenderData::MapBuffers() does
+	size_t count = pdat->size();
+	buf.m_y.resize(count);
+	buf.m_x.resize(count);
+	buf.m_digitalY.reset(new bool[count]);
+	buf.m_index.resize(width);
+
+	WaveformGeometry geom;
+	geom.m_count = count;
+	geom.m_width = width;
+	geom.m_plotRight = width;
+	geom.m_height = height;
+	if(stream.GetType() == Stream::STREAM_TYPE_DIGITAL)
+	{
+		geom.m_ybase = 2;
+		geom.m_yscale = height - 5;
+	}
+	else
+	{
+		geom.m_ybase = height / 2;
+		geom.m_yscale = height / stream.GetVoltageRange();
+	}
+	geom.m_yoff = stream.GetOffset();
+	geom.m_xAxisOffset = 0;
+	geom.m_pixelsPerXUnit = static_cast<float>(width) / (count * pdat->m_timescale);
+
+	geom.m_xBuffer = &buf.m_x[0];
+	geom.m_yBuffer = &buf.m_y[0];
+	geom.m_digitalYBuffer = buf.m_digitalY.get();
+	geom.m_indexBuffer = &buf.m_index[0];
+	geom.m_configBuffer = reinterpret_cast<uint32_t*>(&buf.m_config[0]);
+	geom.m_configBuffer64 = &buf.m_config[0];
+	geom.m_floatConfigBuffer = reinterpret_cast<float*>(&buf.m_config[0]);
+
+	return geom.Prepare(pdat, true, alpha);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Entry point
+
+void ShowUsage()
+{
+	fprintf(stderr,
+		"Usage: pipelinebench [options]\n"
+		"    --channels <n>         Number of instrument channels (default 4)\n"
+		"    --depth <n>            Samples per channel per waveform (default 1000000)\n"
+		"    --rate <n>             Trigger rate in WFM/s, 0 for as fast as possible (default 0)\n"
+		"    --duration <t>         Seconds to run for (default 10)\n"
+		"    --filter <name>        Attach a filter of this type to every channel (may be repeated, e.g. \"FFT\")\n"
+		"    --width <n>            Plot width in pixels for geometry prep (default 1920)\n"
+		"    --height <n>           Plot height in pixels for geometry prep (default 300)\n"
+		"    --cpu-only             Don't use the GPU even if one is available\n"
+		"    --json <file>          Write results as JSON\n");
+}
+
+int main(int argc, char* argv[])
+{
+	Severity console_verbosity = Severity::NOTICE;
+
+	size_t nchans = 4;
+	size_t depth = 1000000;
+	double rate = 0;
+	double duration = 10;
+	int width = 1920;
+	int height = 300;
+	vector<string> filterNames;
+	string jsonPath;
+
+	for(int i=1; i<argc; i++)
+	{
+		string s(argv[i]);
+
+		//Let the logger eat its args first
+		if(ParseLoggerArguments(i, argc, argv, console_verbosity))
+			continue;
+
+		if(s == "--help")
+		{
+			ShowUsage();
+			return 0;
+		}
+		else if(s == "--cpu-only")
+		{
+			g_cpuOnly = true;
+			continue;
+		}
+
+		if(i+1 >= argc)
+		{
+			fprintf(stderr, "Unrecognized or incomplete command-line option \"%s\"\n", s.c_str());
+			ShowUsage();
+			return 1;
+		}
+
+		string arg(argv[++i]);
+		if(s == "--channels")
+			nchans = max(static_cast<size_t>(1), static_cast<size_t>(stoull(arg)));
+		else if(s == "--depth")
+			depth = max(static_cast<size_t>(2), static_cast<size_t>(stoull(arg)));
+		else if(s == "--rate")
+			rate = stod(arg);
+		else if(s == "--duration")
+			duration = stod(arg);
+		else if(s == "--filter")
+			filterNames.push_back(arg);
+		else if(s == "--width")
+			width = stoi(arg);
+		else if(s == "--height")
+			height = stoi(arg);
+		else if(s == "--json")
+			jsonPath = arg;
+		else
+		{
+			fprintf(stderr, "Unrecognized command-line option \"%s\"\n", s.c_str());
+			ShowUsage();
+			return 1;
+		}
+	}
+
+	g_log_sinks.emplace(g_log_sinks.begin(), new ColoredSTDLogSink(console_verbosity));
+
+	//Global scopehal initialization
+	if(!VulkanInit())
+		g_cpuOnly = true;
+	TransportStaticInit();
+	DriverStaticInit();
+	InitializePlugins();
+	ScopeProtocolStaticInit();
+	g_gpuFilterEnabled = !g_cpuOnly;
+
+	//Add search path
+	g_searchPaths.push_back(GetDirOfCurrentExecutable() + "/../../src/glscopeclient/");
+
+	g_rng.seed(0);
+
+	StageTimes acquire("acquire");
+	StageTimes download("download");
+	StageTimes filters("filters");
+	StageTimes geometry("geometry");
+	StageTimes endToEnd("end_to_end");
+	size_t numWaveforms = 0;
+	size_t numDropped = 0;
+	double elapsed = 0;
+	{
+		SyntheticOscilloscope scope(nchans, depth, 100000);
+		g_scope = &scope;
+
+		//Set up the filter graph
+		vector<Filter*> graph;
+		for(size_t i=0; i<nchans; i++)
+		{
+			for(auto& name : filterNames)
+			{
+				auto f = Filter::CreateFilter(name, "#ffffff");
+				if(!f)
+				{
+					LogError("Unknown filter \"%s\"\n", name.c_str());
+					return 1;
+				}
+				f->AddRef();
+				f->SetInput(0, StreamDescriptor(scope.GetChannel(i), 0));
+				graph.push_back(f);
+			}
+		}
+
+		//Everything we'd be drawing
+		vector<StreamDescriptor> streams;
+		for(size_t i=0; i<nchans; i++)
+			streams.push_back(StreamDescriptor(scope.GetChannel(i), 0));
+		for(auto f : graph)
+		{
+			for(size_t i=0; i<f->GetStreamCount(); i++)
+			{
+				auto type = f->GetType(i);
+				if( (type == Stream::STREAM_TYPE_ANALOG) || (type == Stream::STREAM_TYPE_DIGITAL) )
+					streams.push_back(StreamDescriptor(f, i));
+			}
+		}
+		vector<GeometryBuffers> buffers(streams.size());
+
+		LogNotice("Running %zu channels x %zu points, %zu filters, %zu streams drawn, for %.1f s\n",
+			nchans, depth, graph.size(), streams.size(), duration);
+
+		//Acquisition thread, stands in for ScopeThread
+		atomic<bool> done(false);
+		thread acquisitionThread([&]()
+		{
+			double tnext = GetTime();
+			while(!done)
+			{
+				//Pace triggers if we have a target rate
+				if(rate > 0)
+				{
+					double now = GetTime();
+					if(now < tnext)
+					{
+						this_thread::sleep_for(chrono::microseconds(static_cast<int64_t>((tnext - now) * 1e6)));
+						continue;
+					}
+					tnext += 1.0 / rate;
+				}
+
+				//Same backpressure as ScopeThread: a real instrument would miss these triggers
+				if(scope.GetPendingCount() >= 2)
+				{
+					if(rate > 0)
+						numDropped ++;
+					else
+						this_thread::sleep_for(chrono::microseconds(100));
+					continue;
+				}
+
+				double start = GetTime();
+				scope.AcquireData();
+				acquire.m_times.push_back(GetTime() - start);
+			}
+		});
+
+		//Processing loop, does what WaveformProcessingThread and OnAllWaveformsUpdated() do for each trigger
+		vector<Oscilloscope*> scopes;
+		scopes.push_back(&scope);
+		map<Oscilloscope*, int64_t> deskew;
+		FilterGraphExecutor executor;
+		FilterGraphProfiler profiler;
+		StatisticsEngine stats;
+		double tstart = GetTime();
+		while(true)
+		{
+			double now = GetTime();
+			if( (now - tstart) > duration)
+				break;
+
+			if(!WaveformPipeline::HasPendingWaveforms(scopes))
+			{
+				this_thread::sleep_for(chrono::microseconds(100));
+				continue;
+			}
+
+			//Download. The previous waveforms are detached rather than freed (the history window owns them in the
+			//client), so free them here instead.
+			double t0 = GetTime();
+			double ttrigger = scope.PopTriggerTime();
+			vector<WaveformBase*> old;
+			for(size_t i=0; i<nchans; i++)
+				old.push_back(scope.GetChannel(i)->GetData(0));
+			WaveformPipeline::DownloadWaveforms(scopes, deskew);
+			for(auto w : old)
+				delete w;
+			double t1 = GetTime();
+
+			//Filter graph and statistics
+			WaveformPipeline::RefreshFilters(Filter::GetAllInstances(), executor, profiler, stats);
+			double t2 = GetTime();
+
+			//Geometry
+			#pragma omp parallel for
+			for(size_t i=0; i<streams.size(); i++)
+				PrepareGeometry(streams[i], buffers[i], width, height, 0.5);
+			double t3 = GetTime();
+
+			download.m_times.push_back(t1 - t0);
+			filters.m_times.push_back(t2 - t1);
+			geometry.m_times.push_back(t3 - t2);
+			endToEnd.m_times.push_back(t3 - ttrigger);
+			numWaveforms ++;
+		}
+		elapsed = GetTime() - tstart;
+
+		done = true;
+		acquisitionThread.join();
+
+		for(auto f : graph)
+			f->Release();
+	}
+
+	//Report
+	double wfmRate = numWaveforms / elapsed;
+	size_t rss = GetPeakRSS();
+	LogNotice("%zu waveforms in %.2f s: %.2f WFM/s sustained, %zu triggers dropped\n",
+		numWaveforms, elapsed, wfmRate, numDropped);
+	LogNotice("Peak RSS: %.1f MB\n", rss / (1024.0 * 1024.0));
+
+	StageTimes* stages[] = { &acquire, &download, &filters, &geometry, &endToEnd };
+	for(auto s : stages)
+	{
+		sort(s->m_times.begin(), s->m_times.end());
+		LogNotice("%-12s: p50 %9.3f ms, p90 %9.3f ms, p99 %9.3f ms, max %9.3f ms\n",
+			s->m_name.c_str(),
+			s->GetPercentile(0.5) * 1e3,
+			s->GetPercentile(0.9) * 1e3,
+			s->GetPercentile(0.99) * 1e3,
+			s->GetPercentile(1) * 1e3);
+	}
+
+	if(!jsonPath.empty())
+	{
+		FILE* fp = fopen(jsonPath.c_str(), "w");
+		if(!fp)
+			LogError("Couldn't open %s for writing\n", jsonPath.c_str());
+		else
+		{
+			fprintf(fp, "{\n");
+			fprintf(fp, "\t\"channels\": %zu,\n", nchans);
+			fprintf(fp, "\t\"depth\": %zu,\n", depth);
+			fprintf(fp, "\t\"filters\": %zu,\n", filterNames.size());
+			fprintf(fp, "\t\"waveforms\": %zu,\n", numWaveforms);
+			fprintf(fp, "\t\"dropped\": %zu,\n", numDropped);
+			fprintf(fp, "\t\"wfm_per_sec\": %.3f,\n", wfmRate);
+			fprintf(fp, "\t\"peak_rss_bytes\": %zu,\n", rss);
+			fprintf(fp, "\t\"stages\":\n");
+			fprintf(fp, "\t{\n");
+			for(size_t i=0; i<5; i++)
+			{
+				auto s = stages[i];
+				fprintf(fp, "\t\t\"%s\": { \"p50_ms\": %.6f, \"p90_ms\": %.6f, \"p99_ms\": %.6f, \"max_ms\": %.6f }%s\n",
+					s->m_name.c_str(),
+					s->GetPercentile(0.5) * 1e3,
+					s->GetPercentile(0.9) * 1e3,
+					s->GetPercentile(0.99) * 1e3,
+					s->GetPercentile(1) * 1e3,
+					(i < 4) ? "," : "");
+			}
+			fprintf(fp, "\t}\n");
+			fprintf(fp, "}\n");
+			fclose(fp);
+		}
+	}
+
+	ScopehalStaticCleanup();
+	return 0;
+}
@@ -0,0 +1,223 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Benchmarks for low level primitives
+ */
+
+#include "Benchmarks.h"
+
+using namespace std;
+
+/**
+	@brief Benchmarks converting raw ADC codes of type T to floating point volts
+ */
+template<class T>
+class ConvertSamplesBenchmark : public Benchmark
+{
+public:
+	ConvertSamplesBenchmark(const string& name, const string& shader, bool hasShaderSupport)
+	: Benchmark(name)
+	{
+		m_in.SetCpuAccessHint(AcceleratorBuffer<T>::HINT_LIKELY);
+		m_out.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+		//Don't allocate GPU-side buffers at all when benchmarking CPU-only
+		if(g_cpuOnly)
+		{
+			m_in.SetGpuAccessHint(AcceleratorBuffer<T>::HINT_NEVER);
+			m_out.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+		}
+		else
+		{
+			m_in.SetGpuAccessHint(AcceleratorBuffer<T>::HINT_LIKELY);
+			m_out.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		}
+
+		if(hasShaderSupport && IsIsaAvailable(ISA_GPU))
+			m_pipe = make_unique<ComputePipeline>(shader, 2, sizeof(ConvertRawSamplesShaderArgs));
+	}
+
+	virtual void Setup(size_t depth)
+	{
+		uniform_int_distribution<int> indesc(numeric_limits<T>::min(), numeric_limits<T>::max());
+
+		m_in.resize(depth);
+		m_out.resize(depth);
+
+		m_in.PrepareForCpuAccess();
+		for(size_t i=0; i<depth; i++)
+			m_in[i] = indesc(g_rng);
+		m_in.MarkModifiedFromCpu();
+
+		if(!g_cpuOnly)
+			m_in.PrepareForGpuAccess();
+		m_in.PrepareForCpuAccess();
+	}
+
+	virtual void Teardown()
+	{
+		m_in.clear();
+		m_out.clear();
+	}
+
+protected:
+	void RunGpu(vk::raii::CommandBuffer& cmdbuf, vk::raii::Queue& queue)
+	{
+		size_t len = m_in.size();
+
+		cmdbuf.begin({});
+		m_pipe->BindBufferNonblocking(0, m_out, cmdbuf, true);
+		m_pipe->BindBufferNonblocking(1, m_in, cmdbuf);
+		ConvertRawSamplesShaderArgs args;
+		args.size = len;
+		args.gain = m_gain;
+		args.offset = m_offset;
+		m_pipe->Dispatch(cmdbuf, args, GetComputeBlockCount(len, 64));
+		cmdbuf.end();
+		SubmitAndBlock(cmdbuf, queue);
+		m_out.MarkModifiedFromGpu();
+	}
+
+	AcceleratorBuffer<T> m_in;
+	AcceleratorBuffer<float> m_out;
+	unique_ptr<ComputePipeline> m_pipe;
+
+	const float m_gain = 0.01f;
+	const float m_offset = 0.5f;
+};
+
+class Convert8BitBenchmark : public ConvertSamplesBenchmark<int8_t>
+{
+public:
+	Convert8BitBenchmark()
+	: ConvertSamplesBenchmark<int8_t>(
+		"Primitive_Convert8BitSamples", "shaders/Convert8BitSamples.spv", g_hasShaderInt8)
+	{}
+
+	virtual bool SupportsIsa(BenchmarkIsa isa)
+	{
+		switch(isa)
+		{
+			case ISA_GENERIC:
+			case ISA_AVX2:
+				return true;
+			case ISA_GPU:
+				return (m_pipe != nullptr);
+			default:
+				return false;
+		}
+	}
+
+	virtual void Run(BenchmarkIsa isa, vk::raii::CommandBuffer& cmdbuf, vk::raii::Queue& queue)
+	{
+		size_t len = m_in.size();
+		switch(isa)
+		{
+			#ifdef __x86_64__
+			case ISA_AVX2:
+				m_out.PrepareForCpuAccess();
+				Oscilloscope::Convert8BitSamplesAVX2(&m_out[0], &m_in[0], m_gain, m_offset, len);
+				m_out.MarkModifiedFromCpu();
+				break;
+			#endif
+
+			case ISA_GPU:
+				RunGpu(cmdbuf, queue);
+				break;
+
+			default:
+				m_out.PrepareForCpuAccess();
+				Oscilloscope::Convert8BitSamplesGeneric(&m_out[0], &m_in[0], m_gain, m_offset, len);
+				m_out.MarkModifiedFromCpu();
+				break;
+		}
+	}
+};
+
+class Convert16BitBenchmark : public ConvertSamplesBenchmark<int16_t>
+{
+public:
+	Convert16BitBenchmark()
+	: ConvertSamplesBenchmark<int16_t>(
+		"Primitive_Convert16BitSamples", "shaders/Convert16BitSamples.spv", g_hasShaderInt16)
+	{}
+
+	virtual bool SupportsIsa(BenchmarkIsa isa)
+	{
+		if(isa == ISA_GPU)
+			return (m_pipe != nullptr);
+		return true;
+	}
+
+	virtual void Run(BenchmarkIsa isa, vk::raii::CommandBuffer& cmdbuf, vk::raii::Queue& queue)
+	{
+		size_t len = m_in.size();
+		switch(isa)
+		{
+			#ifdef __x86_64__
+			case ISA_AVX2:
+				m_out.PrepareForCpuAccess();
+				Oscilloscope::Convert16BitSamplesAVX2(&m_out[0], &m_in[0], m_gain, m_offset, len);
+				m_out.MarkModifiedFromCpu();
+				break;
+
+			case ISA_FMA:
+				m_out.PrepareForCpuAccess();
+				Oscilloscope::Convert16BitSamplesFMA(&m_out[0], &m_in[0], m_gain, m_offset, len);
+				m_out.MarkModifiedFromCpu();
+				break;
+
+			case ISA_AVX512F:
+				m_out.PrepareForCpuAccess();
+				Oscilloscope::Convert16BitSamplesAVX512F(&m_out[0], &m_in[0], m_gain, m_offset, len);
+				m_out.MarkModifiedFromCpu();
+				break;
+			#endif
+
+			case ISA_GPU:
+				RunGpu(cmdbuf, queue);
+				break;
+
+			default:
+				m_out.PrepareForCpuAccess();
+				Oscilloscope::Convert16BitSamplesGeneric(&m_out[0], &m_in[0], m_gain, m_offset, len);
+				m_out.MarkModifiedFromCpu();
+				break;
+		}
+	}
+};
+
+void CreatePrimitiveBenchmarks(vector<Benchmark*>& benchmarks)
+{
+	benchmarks.push_back(new Convert8BitBenchmark);
+	benchmarks.push_back(new Convert16BitBenchmark);
+}
@@ -0,0 +1,326 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief ISA selection, statistics and result file handling for the benchmark suite
+ */
+
+#include "Benchmarks.h"
+#include <yaml-cpp/yaml.h>
+
+using namespace std;
+
+//Capabilities of the host CPU/GPU as detected at startup, before we start turning things off
+static bool g_reallyHasAvx2 = false;
+static bool g_reallyHasFMA = false;
+static bool g_reallyHasAvx512F = false;
+static bool g_reallyHasGpu = false;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ISA selection
+
+/**
+	@brief Saves the real feature flags so we can restore them after forcing a given path
+ */
+void DetectIsas()
+{
+	#ifdef __x86_64__
+		g_reallyHasAvx2 = g_hasAvx2;
+		g_reallyHasFMA = g_hasFMA;
+		g_reallyHasAvx512F = g_hasAvx512F;
+	#endif
+	g_reallyHasGpu = !g_cpuOnly && (g_vkComputeDevice != nullptr);
+}
+
+const char* GetIsaName(BenchmarkIsa isa)
+{
+	switch(isa)
+	{
+		case ISA_GENERIC:
+			return "generic";
+		case ISA_AVX2:
+			return "avx2";
+		case ISA_FMA:
+			return "fma";
+		case ISA_AVX512F:
+			return "avx512f";
+		case ISA_GPU:
+			return "gpu";
+		default:
+			return "unknown";
+	}
+}
+
+bool IsIsaAvailable(BenchmarkIsa isa)
+{
+	switch(isa)
+	{
+		case ISA_GENERIC:
+			return true;
+		case ISA_AVX2:
+			return g_reallyHasAvx2;
+		case ISA_FMA:
+			return g_reallyHasAvx2 && g_reallyHasFMA;
+		case ISA_AVX512F:
+			return g_reallyHasAvx512F;
+		case ISA_GPU:
+			return g_reallyHasGpu;
+		default:
+			return false;
+	}
+}
+
+/**
+	@brief Sets the global feature flags so that only the requested path is taken
+
+	Lower ISA levels stay enabled when selecting a higher one, the same way the test cases do it.
+ */
+void SelectIsa(BenchmarkIsa isa)
+{
+	#ifdef __x86_64__
+		g_hasAvx2 = (isa == ISA_AVX2) || (isa == ISA_FMA) || (isa == ISA_AVX512F);
+		g_hasFMA = (isa == ISA_FMA);
+		g_hasAvx512F = (isa == ISA_AVX512F);
+		g_hasAvx2 &= g_reallyHasAvx2;
+		g_hasFMA &= g_reallyHasFMA;
+		g_hasAvx512F &= g_reallyHasAvx512F;
+	#endif
+	g_gpuFilterEnabled = (isa == ISA_GPU);
+}
+
+void RestoreIsa()
+{
+	#ifdef __x86_64__
+		g_hasAvx2 = g_reallyHasAvx2;
+		g_hasFMA = g_reallyHasFMA;
+		g_hasAvx512F = g_reallyHasAvx512F;
+	#endif
+	g_gpuFilterEnabled = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Statistics
+
+string BenchmarkResult::GetKey() const
+{
+	return m_kernel + "/" + m_isa + "/" + to_string(m_depth);
+}
+
+/**
+	@brief Computes summary statistics over a set of run times
+
+	Sorts the input in place.
+ */
+void SummarizeTimes(vector<double>& times, BenchmarkResult& result)
+{
+	result.m_iterations = times.size();
+	if(times.empty())
+		return;
+
+	sort(times.begin(), times.end());
+	size_t n = times.size();
+
+	double sum = 0;
+	for(auto t : times)
+		sum += t;
+	double mean = sum / n;
+
+	double var = 0;
+	for(auto t : times)
+		var += (t - mean) * (t - mean);
+	if(n > 1)
+		var /= (n - 1);
+
+	result.m_min = times[0];
+	result.m_max = times[n-1];
+	result.m_mean = mean;
+	result.m_stdev = sqrt(var);
+	if(n & 1)
+		result.m_median = times[n/2];
+	else
+		result.m_median = (times[n/2 - 1] + times[n/2]) / 2;
+	result.m_p90 = times[min(n-1, static_cast<size_t>(ceil(0.9 * n)) - 1)];
+	result.m_throughput = result.m_depth / result.m_median;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Output
+
+void WriteJsonResults(const string& path, const vector<BenchmarkResult>& results)
+{
+	FILE* fp = fopen(path.c_str(), "w");
+	if(!fp)
+	{
+		LogError("Couldn't open %s for writing\n", path.c_str());
+		return;
+	}
+
+	fprintf(fp, "{\n");
+	fprintf(fp, "\t\"results\":\n");
+	fprintf(fp, "\t[\n");
+	for(size_t i=0; i<results.size(); i++)
+	{
+		auto& r = results[i];
+		fprintf(fp, "\t\t{ \"kernel\": \"%s\", \"isa\": \"%s\", \"depth\": %zu, \"iterations\": %zu, "
+			"\"min_ms\": %.6f, \"median_ms\": %.6f, \"mean_ms\": %.6f, \"p90_ms\": %.6f, \"max_ms\": %.6f, "
+			"\"stdev_ms\": %.6f, \"msps\": %.3f }%s\n",
+			r.m_kernel.c_str(),
+			r.m_isa.c_str(),
+			r.m_depth,
+			r.m_iterations,
+			r.m_min * 1e3,
+			r.m_median * 1e3,
+			r.m_mean * 1e3,
+			r.m_p90 * 1e3,
+			r.m_max * 1e3,
+			r.m_stdev * 1e3,
+			r.m_throughput * 1e-6,
+			(i+1 < results.size()) ? "," : "");
+	}
+	fprintf(fp, "\t]\n");
+	fprintf(fp, "}\n");
+	fclose(fp);
+}
+
+void WriteCsvResults(const string& path, const vector<BenchmarkResult>& results)
+{
+	FILE* fp = fopen(path.c_str(), "w");
+	if(!fp)
+	{
+		LogError("Couldn't open %s for writing\n", path.c_str());
+		return;
+	}
+
+	fprintf(fp, "kernel,isa,depth,iterations,min_ms,median_ms,mean_ms,p90_ms,max_ms,stdev_ms,msps\n");
+	for(auto& r : results)
+	{
+		fprintf(fp, "%s,%s,%zu,%zu,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.3f\n",
+			r.m_kernel.c_str(),
+			r.m_isa.c_str(),
+			r.m_depth,
+			r.m_iterations,
+			r.m_min * 1e3,
+			r.m_median * 1e3,
+			r.m_mean * 1e3,
+			r.m_p90 * 1e3,
+			r.m_max * 1e3,
+			r.m_stdev * 1e3,
+			r.m_throughput * 1e-6);
+	}
+	fclose(fp);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Baseline comparison
+
+/**
+	@brief Loads a JSON file previously written by WriteJsonResults()
+
+	JSON is a subset of YAML so we use the same parser as everything else.
+ */
+bool LoadBaseline(const string& path, map<string, BenchmarkResult>& baseline)
+{
+	try
+	{
+		auto doc = YAML::LoadFile(path);
+		for(auto node : doc["results"])
+		{
+			BenchmarkResult r;
+			r.m_kernel = node["kernel"].as<string>();
+			r.m_isa = node["isa"].as<string>();
+			r.m_depth = node["depth"].as<size_t>();
+			r.m_iterations = node["iterations"].as<size_t>();
+			r.m_min = node["min_ms"].as<double>() * 1e-3;
+			r.m_median = node["median_ms"].as<double>() * 1e-3;
+			r.m_mean = node["mean_ms"].as<double>() * 1e-3;
+			r.m_p90 = node["p90_ms"].as<double>() * 1e-3;
+			r.m_max = node["max_ms"].as<double>() * 1e-3;
+			r.m_stdev = node["stdev_ms"].as<double>() * 1e-3;
+			r.m_throughput = node["msps"].as<double>() * 1e6;
+			baseline[r.GetKey()] = r;
+		}
+	}
+	catch(const YAML::Exception& exc)
+	{
+		LogError("Unable to load baseline %s: %s\n", path.c_str(), exc.what());
+		return false;
+	}
+
+	return true;
+}
+
+/**
+	@brief Compares median run times against a baseline
+
+	@param results		Results of this run
+	@param baseline		Previously loaded baseline
+	@param threshold	Fractional slowdown (0.1 = 10%) above which a result counts as a regression
+
+	@return Number of regressions found
+ */
+size_t CompareToBaseline(
+	const vector<BenchmarkResult>& results,
+	const map<string, BenchmarkResult>& baseline,
+	double threshold)
+{
+	LogNotice("Comparison against baseline (threshold %.1f%%)\n", threshold * 100);
+	LogIndenter li;
+
+	size_t regressions = 0;
+	for(auto& r : results)
+	{
+		auto it = baseline.find(r.GetKey());
+		if(it == baseline.end())
+		{
+			LogNotice("%-40s: not in baseline\n", r.GetKey().c_str());
+			continue;
+		}
+
+		double ratio = r.m_median / it->second.m_median;
+		const char* verdict = "";
+		if(ratio > (1 + threshold))
+		{
+			verdict = "  REGRESSION";
+			regressions ++;
+		}
+		else if(ratio < (1 - threshold))
+			verdict = "  improved";
+
+		LogNotice("%-40s: %9.3f ms -> %9.3f ms (%+6.1f%%)%s\n",
+			r.GetKey().c_str(),
+			it->second.m_median * 1e3,
+			r.m_median * 1e3,
+			(ratio - 1) * 100,
+			verdict);
+	}
+
+	return regressions;
+}
@@ -0,0 +1,308 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Main code for the filter/primitive benchmark suite
+ */
+
+#include "Benchmarks.h"
+
+using namespace std;
+
+minstd_rand g_rng;
+MockOscilloscope* g_scope;
+bool g_cpuOnly = false;
+
+void RunBenchmark(
+	Benchmark* bench,
+	BenchmarkIsa isa,
+	size_t depth,
+	size_t warmup,
+	size_t iterations,
+	double maxSeconds,
+	vk::raii::CommandBuffer& cmdbuf,
+	vk::raii::Queue& queue,
+	vector<BenchmarkResult>& results);
+
+void ShowUsage()
+{
+	fprintf(stderr,
+		"Usage: benchmarks [options]\n"
+		"    --min-depth <n>        Smallest waveform depth to test (default 1000)\n"
+		"    --max-depth <n>        Largest waveform depth to test (default 100000000)\n"
+		"    --depth-step <n>       Multiplier between successive depths (default 10)\n"
+		"    --warmup <n>           Untimed runs before each measurement (default 2)\n"
+		"    --iterations <n>       Timed runs per measurement (default 10)\n"
+		"    --max-seconds <t>      Reduce iterations (min 3) if a measurement would take longer (default 10)\n"
+		"    --kernel <name>        Only run kernels whose name contains this string (may be repeated)\n"
+		"    --isa <name>           Only run this ISA path (generic, avx2, fma, avx512f, gpu; may be repeated)\n"
+		"    --cpu-only             Don't use the GPU even if one is available\n"
+		"    --json <file>          Write results as JSON\n"
+		"    --csv <file>           Write results as CSV\n"
+		"    --baseline <file>      Compare against JSON results from a previous run\n"
+		"    --threshold <percent>  Slowdown counted as a regression when comparing (default 10)\n"
+		"Returns nonzero if any regressions were found against the baseline.\n");
+}
+
+int main(int argc, char* argv[])
+{
+	Severity console_verbosity = Severity::NOTICE;
+
+	size_t minDepth = 1000;
+	size_t maxDepth = 100000000;
+	size_t depthStep = 10;
+	size_t warmup = 2;
+	size_t iterations = 10;
+	double maxSeconds = 10;
+	double threshold = 10;
+	vector<string> kernelFilters;
+	set<string> isaFilters;
+	string jsonPath;
+	string csvPath;
+	string baselinePath;
+
+	for(int i=1; i<argc; i++)
+	{
+		string s(argv[i]);
+
+		//Let the logger eat its args first
+		if(ParseLoggerArguments(i, argc, argv, console_verbosity))
+			continue;
+
+		if(s == "--help")
+		{
+			ShowUsage();
+			return 0;
+		}
+		else if(s == "--cpu-only")
+		{
+			g_cpuOnly = true;
+			continue;
+		}
+
+		if(i+1 >= argc)
+		{
+			fprintf(stderr, "Unrecognized or incomplete command-line option \"%s\"\n", s.c_str());
+			ShowUsage();
+			return 1;
+		}
+
+		string arg(argv[++i]);
+		if(s == "--min-depth")
+			minDepth = stoull(arg);
+		else if(s == "--max-depth")
+			maxDepth = stoull(arg);
+		else if(s == "--depth-step")
+			depthStep = max(static_cast<size_t>(2), static_cast<size_t>(stoull(arg)));
+		else if(s == "--warmup")
+			warmup = stoull(arg);
+		else if(s == "--iterations")
+			iterations = max(static_cast<size_t>(1), static_cast<size_t>(stoull(arg)));
+		else if(s == "--max-seconds")
+			maxSeconds = stod(arg);
+		else if(s == "--kernel")
+			kernelFilters.push_back(arg);
+		else if(s == "--isa")
+			isaFilters.emplace(arg);
+		else if(s == "--json")
+			jsonPath = arg;
+		else if(s == "--csv")
+			csvPath = arg;
+		else if(s == "--baseline")
+			baselinePath = arg;
+		else if(s == "--threshold")
+			threshold = stod(arg);
+		else
+		{
+			fprintf(stderr, "Unrecognized command-line option \"%s\"\n", s.c_str());
+			ShowUsage();
+			return 1;
+		}
+	}
+
+	g_log_sinks.emplace(g_log_sinks.begin(), new ColoredSTDLogSink(console_verbosity));
+
+	//Load the baseline up front so we don't find out it's bad after an hour of benchmarking
+	map<string, BenchmarkResult> baseline;
+	if(!baselinePath.empty() && !LoadBaseline(baselinePath, baseline))
+		return 1;
+
+	//Global scopehal initialization
+	if(!VulkanInit())
+	{
+		LogNotice("No usable Vulkan device, GPU benchmarks will be skipped\n");
+		g_cpuOnly = true;
+	}
+	TransportStaticInit();
+	DriverStaticInit();
+	InitializePlugins();
+	ScopeProtocolStaticInit();
+	DetectIsas();
+
+	//Add search path
+	g_searchPaths.push_back(GetDirOfCurrentExecutable() + "/../../src/glscopeclient/");
+
+	//Initialize the RNG
+	g_rng.seed(0);
+
+	vector<BenchmarkResult> results;
+	{
+		//Same fake scope as the Filters test case
+		MockOscilloscope scope("Test Scope", "Antikernel Labs", "12345", "null", "mock", "");
+		AddMockChannels(scope);
+		g_scope = &scope;
+
+		//Create a queue and command buffer (null handles if we're running CPU-only)
+		vk::raii::CommandPool pool(nullptr);
+		vk::raii::CommandBuffer cmdbuf(nullptr);
+		vk::raii::Queue queue(nullptr);
+		CreateComputeObjects(pool, cmdbuf, queue);
+
+		vector<Benchmark*> benchmarks;
+		CreateFilterBenchmarks(benchmarks);
+		CreatePrimitiveBenchmarks(benchmarks);
+
+		for(auto bench : benchmarks)
+		{
+			//Skip anything not selected
+			bool selected = kernelFilters.empty();
+			for(auto& f : kernelFilters)
+			{
+				if(bench->GetName().find(f) != string::npos)
+					selected = true;
+			}
+			if(!selected)
+				continue;
+
+			LogNotice("%s\n", bench->GetName().c_str());
+			LogIndenter li;
+
+			for(size_t depth = minDepth; depth <= maxDepth; depth *= depthStep)
+			{
+				bench->Setup(depth);
+
+				for(int i=0; i<ISA_COUNT; i++)
+				{
+					auto isa = static_cast<BenchmarkIsa>(i);
+					if(!bench->SupportsIsa(isa) || !IsIsaAvailable(isa))
+						continue;
+					if(!isaFilters.empty() && (isaFilters.find(GetIsaName(isa)) == isaFilters.end()) )
+						continue;
+
+					RunBenchmark(bench, isa, depth, warmup, iterations, maxSeconds, cmdbuf, queue, results);
+				}
+
+				bench->Teardown();
+			}
+		}
+
+		for(auto bench : benchmarks)
+			delete bench;
+	}
+
+	//Write output
+	if(!jsonPath.empty())
+		WriteJsonResults(jsonPath, results);
+	if(!csvPath.empty())
+		WriteCsvResults(csvPath, results);
+
+	int ret = 0;
+	if(!baseline.empty())
+	{
+		size_t regressions = CompareToBaseline(results, baseline, threshold / 100);
+		if(regressions)
+		{
+			LogError("%zu regressions found\n", regressions);
+			ret = 1;
+		}
+	}
+
+	//Clean up and return after the scope goes out of scope (pun not intended)
+	ScopehalStaticCleanup();
+	return ret;
+}
+
+/**
+	@brief Times one kernel at one depth on one ISA path and appends the summary to the results
+ */
+void RunBenchmark(
+	Benchmark* bench,
+	BenchmarkIsa isa,
+	size_t depth,
+	size_t warmup,
+	size_t iterations,
+	double maxSeconds,
+	vk::raii::CommandBuffer& cmdbuf,
+	vk::raii::Queue& queue,
+	vector<BenchmarkResult>& results)
+{
+	SelectIsa(isa);
+
+	//Run the kernel a few times without looking at results, to make sure caches are hot and buffers are allocated etc
+	double twarm = 0;
+	for(size_t i=0; i<warmup; i++)
+	{
+		double start = GetTime();
+		bench->Run(isa, cmdbuf, queue);
+		twarm = GetTime() - start;
+	}
+
+	//Don't spend forever on very deep waveforms with slow paths
+	size_t niter = iterations;
+	if( (twarm > 0) && (twarm * iterations > maxSeconds) )
+		niter = max(static_cast<size_t>(3), static_cast<size_t>(maxSeconds / twarm));
+	niter = min(niter, iterations);
+
+	vector<double> times;
+	for(size_t i=0; i<niter; i++)
+	{
+		double start = GetTime();
+		bench->Run(isa, cmdbuf, queue);
+		times.push_back(GetTime() - start);
+	}
+
+	RestoreIsa();
+
+	BenchmarkResult result;
+	result.m_kernel = bench->GetName();
+	result.m_isa = GetIsaName(isa);
+	result.m_depth = depth;
+	SummarizeTimes(times, result);
+	results.push_back(result);
+
+	LogNotice("%-8s %10zu points: median %9.3f ms, min %9.3f ms, stdev %8.3f ms, %9.2f MS/s\n",
+		result.m_isa.c_str(),
+		depth,
+		result.m_median * 1e3,
+		result.m_min * 1e3,
+		result.m_stdev * 1e3,
+		result.m_throughput * 1e-6);
+}
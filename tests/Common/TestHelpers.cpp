@@ -0,0 +1,79 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* glscopeclient                                                                                                        *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Helpers shared by all of the test cases and benchmarks
+ */
+
+#include "TestHelpers.h"
+
+using namespace std;
+
+/**
+	@brief Removes --cpu-only from the command line (so Catch doesn't choke on it)
+
+	@return True if it was present
+ */
+bool ParseCpuOnlyArgument(int& argc, char* argv[])
+{
+	bool found = false;
+	int nout = 0;
+	for(int i=0; i<argc; i++)
+	{
+		if(!strcmp(argv[i], "--cpu-only"))
+			found = true;
+		else
+			argv[nout++] = argv[i];
+	}
+	argc = nout;
+	return found;
+}
+
+/**
+	@brief Creates the command pool, command buffer and queue used by the GPU paths
+
+	In CPU-only mode the objects are left as null handles. They still have to exist because filter Refresh() takes
+	them by reference, but nothing will use them as long as g_gpuFilterEnabled is false.
+ */
+void CreateComputeObjects(vk::raii::CommandPool& pool, vk::raii::CommandBuffer& cmdbuf, vk::raii::Queue& queue)
+{
+	if(g_cpuOnly)
+		return;
+
+	vk::CommandPoolCreateInfo poolInfo(
+		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		g_computeQueueType );
+	pool = vk::raii::CommandPool(*g_vkComputeDevice, poolInfo);
+
+	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
+	cmdbuf = move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front());
+	queue = vk::raii::Queue(*g_vkComputeDevice, g_computeQueueType, 0);
+}
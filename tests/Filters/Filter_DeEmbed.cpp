@@ -47,15 +47,11 @@ TEST_CASE("Filter_DeEmbed")
 	REQUIRE(filter != nullptr);
 	filter->AddRef();
 
-	//Create a queue and command buffer
-	vk::CommandPoolCreateInfo poolInfo(
-		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-		g_computeQueueType );
-	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
-
-	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
-	vk::raii::CommandBuffer cmdbuf(move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
-	vk::raii::Queue queue(*g_vkComputeDevice, g_computeQueueType, 0);
+	//Create a queue and command buffer (null handles if we're running CPU-only)
+	vk::raii::CommandPool pool(nullptr);
+	vk::raii::CommandBuffer cmdbuf(nullptr);
+	vk::raii::Queue queue(nullptr);
+	CreateComputeObjects(pool, cmdbuf, queue);
 
 	//Create an empty input waveform
 	const size_t depth = 1000000;
@@ -134,21 +130,24 @@ TEST_CASE("Filter_DeEmbed")
 				}
 			#endif
 
-			//Run the filter once without looking at results, to make sure caches are hot and buffers are allocated etc
-			g_gpuFilterEnabled = true;
-			filter->Refresh(cmdbuf, queue);
-
-			//Try again on the GPU, this time for score
-			start = GetTime();
-			filter->Refresh(cmdbuf, queue);
-			double dt = GetTime() - start;
-			LogVerbose("GPU           : %6.2f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
-
-			VerifyMatchingResult(
-				golden,
-				dynamic_cast<UniformAnalogWaveform*>(filter->GetData(0))->m_samples,
-				1e-2f
-				);
+			if(!g_cpuOnly)
+			{
+				//Run the filter once without looking at results, to make sure caches are hot and buffers are allocated etc
+				g_gpuFilterEnabled = true;
+				filter->Refresh(cmdbuf, queue);
+
+				//Try again on the GPU, this time for score
+				start = GetTime();
+				filter->Refresh(cmdbuf, queue);
+				double dt = GetTime() - start;
+				LogVerbose("GPU           : %6.2f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
+
+				VerifyMatchingResult(
+					golden,
+					dynamic_cast<UniformAnalogWaveform*>(filter->GetData(0))->m_samples,
+					1e-2f
+					);
+			}
 		}
 	}
 
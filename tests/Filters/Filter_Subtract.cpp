@@ -49,15 +49,11 @@ TEST_CASE("Filter_Subtract")
 	REQUIRE(filter != NULL);
 	filter->AddRef();
 
-	//Create a queue and command buffer
-	vk::CommandPoolCreateInfo poolInfo(
-		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-		g_computeQueueType );
-	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
-
-	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
-	vk::raii::CommandBuffer cmdbuf(move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
-	vk::raii::Queue queue(*g_vkComputeDevice, g_computeQueueType, 0);
+	//Create a queue and command buffer (null handles if we're running CPU-only)
+	vk::raii::CommandPool pool(nullptr);
+	vk::raii::CommandBuffer cmdbuf(nullptr);
+	vk::raii::Queue queue(nullptr);
+	CreateComputeObjects(pool, cmdbuf, queue);
 
 	//Create two empty input waveforms
 	const size_t depth = 10000000;
@@ -87,8 +83,11 @@ TEST_CASE("Filter_Subtract")
 			FillRandomWaveform(&ub, depth);
 
 			//Set up the filter (don't count this towards execution time)
-			ua.PrepareForGpuAccess();
-			ub.PrepareForGpuAccess();
+			if(!g_cpuOnly)
+			{
+				ua.PrepareForGpuAccess();
+				ub.PrepareForGpuAccess();
+			}
 
 			g_gpuFilterEnabled = false;
 			#ifdef __x86_64__
@@ -120,14 +119,17 @@ TEST_CASE("Filter_Subtract")
 				}
 			#endif /* __x86_64__ */
 
-			//Try again on the GPU
-			g_gpuFilterEnabled = true;
-			start = GetTime();
-			filter->Refresh(cmdbuf, queue);
-			double dt = GetTime() - start;
-			LogVerbose("GPU:          %.2f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
-
-			VerifySubtractionResult(&ua, &ub, dynamic_cast<UniformAnalogWaveform*>(filter->GetData(0)));
+			if(!g_cpuOnly)
+			{
+				//Try again on the GPU
+				g_gpuFilterEnabled = true;
+				start = GetTime();
+				filter->Refresh(cmdbuf, queue);
+				double dt = GetTime() - start;
+				LogVerbose("GPU:          %.2f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
+
+				VerifySubtractionResult(&ua, &ub, dynamic_cast<UniformAnalogWaveform*>(filter->GetData(0)));
+			}
 		}
 	}
 
@@ -47,15 +47,11 @@ TEST_CASE("Filter_Upsample")
 	REQUIRE(filter != NULL);
 	filter->AddRef();
 
-	//Create a queue and command buffer
-	vk::CommandPoolCreateInfo poolInfo(
-		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-		g_computeQueueType );
-	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
-
-	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
-	vk::raii::CommandBuffer cmdbuf(move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
-	vk::raii::Queue queue(*g_vkComputeDevice, g_computeQueueType, 0);
+	//Create a queue and command buffer (null handles if we're running CPU-only)
+	vk::raii::CommandPool pool(nullptr);
+	vk::raii::CommandBuffer cmdbuf(nullptr);
+	vk::raii::Queue queue(nullptr);
+	CreateComputeObjects(pool, cmdbuf, queue);
 
 	//Create an empty input waveform
 	const size_t depth = 10000000;
@@ -77,14 +73,15 @@ TEST_CASE("Filter_Upsample")
 			FillRandomWaveform(&ua, depth);
 
 			//Make sure data is in the right spot (don't count this towards execution time)
-			ua.PrepareForGpuAccess();
+			if(!g_cpuOnly)
+				ua.PrepareForGpuAccess();
 			ua.PrepareForCpuAccess();
 
 			//Run the filter once on CPU and GPU each
 			//without looking at results, to make sure caches are hot and buffers are allocated etc
 			g_gpuFilterEnabled = false;
 			filter->Refresh(cmdbuf, queue);
-			g_gpuFilterEnabled = true;
+			g_gpuFilterEnabled = !g_cpuOnly;
 			filter->Refresh(cmdbuf, queue);
 
 			//Baseline on the CPU
@@ -98,14 +95,17 @@ TEST_CASE("Filter_Upsample")
 			AcceleratorBuffer<float> golden;
 			golden.CopyFrom(dynamic_cast<UniformAnalogWaveform*>(filter->GetData(0))->m_samples);
 
-			//Try again on the GPU
-			g_gpuFilterEnabled = true;
-			start = GetTime();
-			filter->Refresh(cmdbuf, queue);
-			double dt = GetTime() - start;
-			LogVerbose("GPU: %.2f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
-
-			VerifyMatchingResult(golden, dynamic_cast<UniformAnalogWaveform*>(filter->GetData(0))->m_samples);
+			if(!g_cpuOnly)
+			{
+				//Try again on the GPU
+				g_gpuFilterEnabled = true;
+				start = GetTime();
+				filter->Refresh(cmdbuf, queue);
+				double dt = GetTime() - start;
+				LogVerbose("GPU: %.2f ms, %.2fx speedup\n", dt * 1000, tbase / dt);
+
+				VerifyMatchingResult(golden, dynamic_cast<UniformAnalogWaveform*>(filter->GetData(0))->m_samples);
+			}
 		}
 	}
 
@@ -41,13 +41,21 @@ using namespace std;
 
 minstd_rand g_rng;
 MockOscilloscope* g_scope;
+bool g_cpuOnly = false;
 
 int main(int argc, char* argv[])
 {
 	g_log_sinks.emplace(g_log_sinks.begin(), new ColoredSTDLogSink(Severity::VERBOSE));
 
 	//Global scopehal initialization
-	VulkanInit();
+	g_cpuOnly = ParseCpuOnlyArgument(argc, argv);
+	if(!VulkanInit())
+	{
+		LogNotice("No usable Vulkan device, GPU tests will be skipped\n");
+		g_cpuOnly = true;
+	}
+	else if(g_cpuOnly)
+		LogNotice("Running in CPU-only mode, GPU tests will be skipped\n");
 	TransportStaticInit();
 	DriverStaticInit();
 	InitializePlugins();
@@ -63,15 +71,7 @@ int main(int argc, char* argv[])
 	{
 		//Create some fake scope channels
 		MockOscilloscope scope("Test Scope", "Antikernel Labs", "12345", "null", "mock", "");
-		scope.AddChannel(new OscilloscopeChannel(
-			&scope, "CH1", "#ffffffff", Unit(Unit::UNIT_FS), Unit(Unit::UNIT_VOLTS)));
-		scope.AddChannel(new OscilloscopeChannel(
-			&scope, "CH2", "#ffffffff", Unit(Unit::UNIT_FS), Unit(Unit::UNIT_VOLTS)));
-
-		scope.AddChannel(new OscilloscopeChannel(
-			&scope, "Mag", "#ffffffff", Unit(Unit::UNIT_HZ), Unit(Unit::UNIT_DB)));
-		scope.AddChannel(new OscilloscopeChannel(
-			&scope, "Angle", "#ffffffff", Unit(Unit::UNIT_HZ), Unit(Unit::UNIT_DEGREES)));
+		AddMockChannels(scope);
 		g_scope = &scope;
 
 		//Run the actual test
@@ -83,24 +83,6 @@ int main(int argc, char* argv[])
 	return ret;
 }
 
-/**
-	@brief Fills a waveform with random content, uniformly distributed from fmin to fmax
- */
-void FillRandomWaveform(UniformAnalogWaveform* wfm, size_t size, float fmin, float fmax)
-{
-	auto rdist = uniform_real_distribution<float>(fmin, fmax);
-
-	wfm->PrepareForCpuAccess();
-	wfm->Resize(size);
-
-	for(size_t i=0; i<size; i++)
-		wfm->m_samples[i] = rdist(g_rng);
-
-	wfm->MarkModifiedFromCpu();
-
-	wfm->m_revision ++;
-}
-
 void VerifyMatchingResult(AcceleratorBuffer<float>& golden, AcceleratorBuffer<float>& observed, float tolerance)
 {
 	REQUIRE(golden.size() == observed.size());
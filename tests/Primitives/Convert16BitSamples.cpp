@@ -49,15 +49,11 @@ TEST_CASE("Primitive_Convert16BitSamples")
 	bool reallyHasAvx512F = g_hasAvx512F;
 	#endif
 
-	//Create a queue and command buffer
-	vk::CommandPoolCreateInfo poolInfo(
-		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-		g_computeQueueType );
-	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
-
-	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
-	vk::raii::CommandBuffer cmdbuf(move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
-	vk::raii::Queue queue(*g_vkComputeDevice, g_computeQueueType, 0);
+	//Create a queue and command buffer (null handles if we're running CPU-only)
+	vk::raii::CommandPool pool(nullptr);
+	vk::raii::CommandBuffer cmdbuf(nullptr);
+	vk::raii::Queue queue(nullptr);
+	CreateComputeObjects(pool, cmdbuf, queue);
 
 	AcceleratorBuffer<int16_t> data_in;
 	AcceleratorBuffer<float> data_out;
@@ -80,7 +76,7 @@ TEST_CASE("Primitive_Convert16BitSamples")
 	uniform_real_distribution<float> offdesc(-10, 10);
 
 	unique_ptr<ComputePipeline> pipe;
-	if(g_hasShaderInt16)
+	if(g_hasShaderInt16 && !g_cpuOnly)
 	{
 		pipe = make_unique<ComputePipeline>(
 			"shaders/Convert16BitSamples.spv", 2, sizeof(ConvertRawSamplesShaderArgs) );
@@ -101,7 +97,8 @@ TEST_CASE("Primitive_Convert16BitSamples")
 			for(size_t j=0; j<wavelen; j++)
 				data_in[j] = indesc(g_rng);
 			data_in.MarkModifiedFromCpu();
-			data_in.PrepareForGpuAccess();
+			if(!g_cpuOnly)
+				data_in.PrepareForGpuAccess();
 
 			//Baseline with CPU reference implementation
 			#ifdef __x86_64__
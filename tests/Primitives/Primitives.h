@@ -31,6 +31,7 @@
 #define Primitives_h
 
 #include "../../lib/scopehal/scopehal.h"
+#include "../Common/TestHelpers.h"
 #include <random>
 
 extern std::mt19937 g_rng;
@@ -40,13 +40,21 @@
 using namespace std;
 
 mt19937 g_rng;
+bool g_cpuOnly = false;
 
 int main(int argc, char* argv[])
 {
 	g_log_sinks.emplace(g_log_sinks.begin(), new ColoredSTDLogSink(Severity::VERBOSE));
 
 	//Global scopehal initialization
-	VulkanInit();
+	g_cpuOnly = ParseCpuOnlyArgument(argc, argv);
+	if(!VulkanInit())
+	{
+		LogNotice("No usable Vulkan device, GPU tests will be skipped\n");
+		g_cpuOnly = true;
+	}
+	else if(g_cpuOnly)
+		LogNotice("Running in CPU-only mode, GPU tests will be skipped\n");
 	TransportStaticInit();
 	DriverStaticInit();
 	InitializePlugins();